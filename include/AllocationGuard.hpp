@@ -0,0 +1,128 @@
+#ifndef ALLOCATION_GUARD_HPP
+#define ALLOCATION_GUARD_HPP
+
+#include <cstdint>
+
+/**
+ * @file AllocationGuard.hpp
+ * @brief Modo de depuração que garante zero alocações no heap nas threads
+ * de tempo real depois do aquecimento.
+ *
+ * Compilado com -DSINE_ALLOC_GUARD (`make ALLOC_GUARD=1`), este cabeçalho
+ * substitui o operator new/delete global do binário: cada thread que chamou
+ * allocationGuardArm() aborta o processo na primeira alocação seguinte, com
+ * uma mensagem em stderr e o core apontando o culpado. Sem a macro, as
+ * funções abaixo não fazem nada e o operator new é o da biblioteca.
+ *
+ * A substituição do operator new é uma definição global, então o cabeçalho
+ * só pode entrar numa unidade de tradução por binário (aqui todo binário é
+ * um único .cpp). malloc direto não é interceptado; o código C++ do projeto
+ * só aloca por new (contêineres, make_unique).
+ */
+
+#ifdef SINE_ALLOC_GUARD
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <new>
+
+namespace allocation_guard {
+inline thread_local bool armed = false;  // Esta thread não pode mais alocar
+
+inline void check() {
+  if (!armed) return;
+  armed = false;  // abort() e a mensagem não podem cair aqui de novo
+  static const char message[] =
+      "[ALLOC_GUARD] Heap allocation on a real-time thread after warm-up\n";
+  ssize_t written = write(STDERR_FILENO, message, sizeof(message) - 1);
+  (void)written;
+  abort();
+}
+
+inline void* allocate(std::size_t size) {
+  check();
+  void* block = std::malloc(size ? size : 1);
+  if (!block) throw std::bad_alloc();
+  return block;
+}
+
+inline void* allocateAligned(std::size_t size, std::align_val_t align) {
+  check();
+  std::size_t alignment = static_cast<std::size_t>(align);
+  std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+  void* block = std::aligned_alloc(alignment, rounded ? rounded : alignment);
+  if (!block) throw std::bad_alloc();
+  return block;
+}
+}  // namespace allocation_guard
+
+void* operator new(std::size_t size) {
+  return allocation_guard::allocate(size);
+}
+void* operator new[](std::size_t size) {
+  return allocation_guard::allocate(size);
+}
+void* operator new(std::size_t size, std::align_val_t align) {
+  return allocation_guard::allocateAligned(size, align);
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+  return allocation_guard::allocateAligned(size, align);
+}
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete[](void* block) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t) noexcept { std::free(block); }
+void operator delete[](void* block, std::size_t) noexcept {
+  std::free(block);
+}
+void operator delete(void* block, std::align_val_t) noexcept {
+  std::free(block);
+}
+void operator delete[](void* block, std::align_val_t) noexcept {
+  std::free(block);
+}
+void operator delete(void* block, std::size_t, std::align_val_t) noexcept {
+  std::free(block);
+}
+void operator delete[](void* block, std::size_t, std::align_val_t) noexcept {
+  std::free(block);
+}
+
+// A partir daqui, qualquer alocação nesta thread aborta o processo
+inline void allocationGuardArm() { allocation_guard::armed = true; }
+inline void allocationGuardDisarm() { allocation_guard::armed = false; }
+constexpr bool ALLOCATION_GUARD_ENABLED = true;
+
+#else
+
+inline void allocationGuardArm() {}
+inline void allocationGuardDisarm() {}
+constexpr bool ALLOCATION_GUARD_ENABLED = false;
+
+#endif  // SINE_ALLOC_GUARD
+
+/**
+ * @class AllocationWarmup
+ * @brief Arma o guarda da thread depois de `frames` iterações do laço
+ * quente: o aquecimento cobre o que só acontece nos primeiros quadros
+ * (reservas preguiçosas, tabelas, caminhos de erro da partida).
+ */
+class AllocationWarmup {
+ public:
+  explicit AllocationWarmup(uint64_t frames) : m_remaining(frames) {
+    if (m_remaining == 0) allocationGuardArm();
+  }
+
+  // Chamado uma vez por iteração do laço quente
+  void tick() {
+    if (m_remaining == 0) return;
+    if (--m_remaining == 0) allocationGuardArm();
+  }
+
+  bool armed() const { return m_remaining == 0; }
+
+ private:
+  uint64_t m_remaining;  // Iterações até armar (0 = já armado)
+};
+
+#endif  // ALLOCATION_GUARD_HPP
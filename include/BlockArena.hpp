@@ -0,0 +1,72 @@
+#ifndef BLOCK_ARENA_HPP
+#define BLOCK_ARENA_HPP
+
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file BlockArena.hpp
+ * @brief Região de trabalho pré-alocada de onde os caminhos quentes tiram
+ * seus blocos.
+ *
+ * O tamanho é calculado uma vez na partida (do layout do anel, o mesmo que
+ * vai no cabeçalho do segmento) e a região é mapeada com MAP_POPULATE: as
+ * páginas já existem antes do primeiro quadro, então nem o primeiro bloco
+ * paga falta de página. allocate() só avança um ponteiro, não libera nada
+ * individualmente e nunca recorre ao heap; pedir mais que o reservado é um
+ * erro de dimensionamento e retorna nullptr.
+ */
+class BlockArena {
+ public:
+  static constexpr size_t ALIGNMENT = 64;  ///< Linha de cache (e AVX-512)
+
+  explicit BlockArena(size_t bytes)
+      : m_base(nullptr), m_capacity(roundUp(bytes)), m_used(0) {
+    if (m_capacity == 0) return;
+    void* address = mmap(nullptr, m_capacity, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (address != MAP_FAILED) m_base = static_cast<unsigned char*>(address);
+  }
+
+  ~BlockArena() {
+    if (m_base) munmap(m_base, m_capacity);
+  }
+
+  BlockArena(const BlockArena&) = delete;
+  BlockArena& operator=(const BlockArena&) = delete;
+
+  bool isValid() const { return m_base != nullptr; }
+
+  // Bytes reservados para `count` objetos T, já com o alinhamento
+  template <typename T>
+  static size_t bytesFor(size_t count) {
+    return roundUp(count * sizeof(T));
+  }
+
+  // `count` objetos T alinhados em ALIGNMENT (nullptr se não couberem)
+  template <typename T>
+  T* allocate(size_t count) {
+    static_assert(alignof(T) <= ALIGNMENT, "Alinhamento maior que a arena");
+    size_t bytes = bytesFor<T>(count);
+    if (!m_base || bytes > m_capacity - m_used) return nullptr;
+    T* block = reinterpret_cast<T*>(m_base + m_used);
+    m_used += bytes;
+    return block;
+  }
+
+  size_t capacity() const { return m_capacity; }
+  size_t used() const { return m_used; }
+
+ private:
+  unsigned char* m_base;  // Início do mapeamento (nullptr se falhou)
+  size_t m_capacity;      // Bytes mapeados
+  size_t m_used;          // Bytes já entregues
+
+  static size_t roundUp(size_t bytes) {
+    return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  }
+};
+
+#endif  // BLOCK_ARENA_HPP
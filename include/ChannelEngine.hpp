@@ -0,0 +1,299 @@
+#ifndef CHANNEL_ENGINE_HPP
+#define CHANNEL_ENGINE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Communication.hpp"
+#include "EffectChain.hpp"
+#include "ISignalGenerator.hpp"
+#include "RenderPool.hpp"
+
+/**
+ * @file ChannelEngine.hpp
+ * @brief Conjunto de N fontes de sinal independentes renderizadas num único
+ * bloco planar, publicado de uma vez no anel multicanal.
+ *
+ * Cada canal tem sua própria instância de ISignalGenerator (e portanto
+ * frequência, amplitude e fase próprias). Um único processo, FIFO e segmento
+ * atendem todos os canais: o custo por canal é só o do kernel de bloco.
+ *
+ * Comandos com Command::atFrame no futuro ficam numa fila ordenada por
+ * instante e são aplicados por render() exatamente na amostra pedida: o
+ * bloco do canal afetado é dividido nesse ponto.
+ *
+ * Com enableEffects() cada canal ganha uma EffectChain, aplicada a cada
+ * trecho logo depois do gerador (CMD_SET_EFFECT a configura, agendável
+ * como qualquer comando).
+ *
+ * Com um RenderPool (setPool) os canais de um quadro são renderizados em
+ * paralelo, um canal por tarefa: cada canal só toca o próprio gerador e a
+ * própria faixa do bloco planar.
+ *
+ * `Generator` é o tipo guardado por canal. Com a própria interface
+ * (ChannelEngine) os canais podem ser de tipos diferentes, ao custo de uma
+ * chamada virtual por canal e por trecho; com uma fonte concreta `final`
+ * (ex.: BasicChannelEngine<SineGenerator>) render() chama o bloco do
+ * gerador diretamente e os comandos viram switches sobre ParameterId.
+ */
+template <typename Generator>
+class BasicChannelEngine {
+ public:
+  using GeneratorType = Generator;
+  using Pointer = std::unique_ptr<Generator>;
+
+  static constexpr size_t MAX_PENDING_COMMANDS = 1024;  ///< Fila agendada
+
+  BasicChannelEngine() : m_pool(nullptr) {
+    m_pending.reserve(MAX_PENDING_COMMANDS);
+  }
+
+  // Adiciona um canal; retorna seu índice
+  uint32_t addChannel(Pointer generator) {
+    m_channels.push_back(std::move(generator));
+    m_running.push_back(0);
+    return static_cast<uint32_t>(m_channels.size() - 1);
+  }
+
+  /**
+   * @brief Cria uma cadeia de efeitos para cada canal já adicionado.
+   *
+   * Os efeitos precisam do relógio de amostras real (`sampleRate` > 0);
+   * sem esta chamada CMD_SET_EFFECT é ignorado e hasEffects() é false.
+   */
+  void enableEffects(double sampleRate) {
+    m_effects.clear();
+    for (uint32_t c = 0; c < channelCount(); ++c) {
+      m_effects.push_back(std::make_unique<EffectChain>(sampleRate));
+    }
+  }
+
+  bool hasEffects() const { return !m_effects.empty(); }
+
+  // Pool usado por render() (nullptr = tudo na thread chamadora)
+  void setPool(RenderPool* pool) { m_pool = pool; }
+
+  uint32_t channelCount() const {
+    return static_cast<uint32_t>(m_channels.size());
+  }
+
+  // Verdadeiro se `channel` é um índice válido ou ALL_CHANNELS
+  bool isValidTarget(int32_t channel) const {
+    return channel == ALL_CHANNELS ||
+           (channel >= 0 && static_cast<uint32_t>(channel) < channelCount());
+  }
+
+  Generator& channel(uint32_t index) { return *m_channels[index]; }
+  const Generator& channel(uint32_t index) const {
+    return *m_channels[index];
+  }
+
+  // Inicia/para um canal ou, com ALL_CHANNELS, todos eles
+  void start(int32_t target = ALL_CHANNELS) { setRunning(target, true); }
+  void stop(int32_t target = ALL_CHANNELS) { setRunning(target, false); }
+
+  // Verdadeiro se algum canal está gerando
+  bool isRunning() const {
+    return std::find(m_running.begin(), m_running.end(), 1) !=
+           m_running.end();
+  }
+
+  void setParameter(int32_t target, ParameterId id, double value) {
+    forEachTarget(target, [&](uint32_t c) {
+      m_channels[c]->setParameter(id, value);
+    });
+  }
+
+  void rampParameter(int32_t target, ParameterId id, double value,
+                     size_t frames) {
+    forEachTarget(target, [&](uint32_t c) {
+      m_channels[c]->rampParameter(id, value, frames);
+    });
+  }
+
+  // Aplica um comando de canal agora (CMD_QUIT e desconhecidos são ignorados)
+  void apply(const Command& cmd) {
+    forEachTarget(cmd.channel, [&](uint32_t c) { applyTo(cmd, c); });
+  }
+
+  /**
+   * @brief Guarda um comando para o instante cmd.atFrame.
+   *
+   * Comandos com o mesmo instante mantêm a ordem de chegada. Retorna false
+   * se a fila estiver cheia.
+   */
+  bool schedule(const Command& cmd) {
+    if (m_pending.size() >= MAX_PENDING_COMMANDS) return false;
+    auto position = std::upper_bound(
+        m_pending.begin(), m_pending.end(), cmd,
+        [](const Command& a, const Command& b) {
+          return a.atFrame < b.atFrame;
+        });
+    m_pending.insert(position, cmd);
+    return true;
+  }
+
+  size_t pendingCommands() const { return m_pending.size(); }
+  size_t freeCommandSlots() const {
+    return MAX_PENDING_COMMANDS - m_pending.size();
+  }
+
+  /**
+   * @brief Renderiza `frames` quadros de todos os canais em `planar`.
+   *
+   * O canal c ocupa planar[c * frames, (c + 1) * frames), formato aceito
+   * diretamente por RingWriter::write. Canais parados (ou que produzam menos
+   * que `frames`) são completados com silêncio, mantendo todos os canais
+   * alinhados no tempo; canais parados também não passam pelos efeitos.
+   * `planar` precisa de channelCount() * frames doubles.
+   *
+   * `startFrame` é o instante do primeiro quadro no relógio de amostras.
+   * Com `sampleAccurate`, comandos agendados dentro do bloco o dividem no
+   * ponto exato; sem ele (modo visual, em que o gerador desenha o bloco
+   * inteiro de uma vez) valem a partir do início do bloco que os contém.
+   */
+  void render(double* planar, size_t frames, uint64_t startFrame = 0,
+              bool sampleAccurate = true) {
+    render(planar, frames, frames, startFrame, sampleAccurate);
+  }
+
+  /**
+   * @brief Como acima, mas o canal c começa em planes + c * planeStride
+   * (ex.: uma RingRegion, para gerar direto nos slots do anel).
+   */
+  void render(double* planes, size_t planeStride, size_t frames,
+              uint64_t startFrame, bool sampleAccurate) {
+    // Comandos que vencem neste bloco: m_pending[0, due), somente leitura
+    // enquanto os canais renderizam
+    uint64_t blockEnd = startFrame + frames;
+    size_t due = static_cast<size_t>(
+        std::lower_bound(m_pending.begin(), m_pending.end(), blockEnd,
+                         [](const Command& cmd, uint64_t frame) {
+                           return cmd.atFrame < frame;
+                         }) -
+        m_pending.begin());
+
+    auto renderOne = [&](size_t c) {
+      renderChannel(static_cast<uint32_t>(c), planes + c * planeStride,
+                    frames, startFrame, sampleAccurate, due);
+    };
+    if (m_pool) {
+      m_pool->run(channelCount(), renderOne);
+    } else {
+      for (uint32_t c = 0; c < channelCount(); ++c) renderOne(c);
+    }
+    m_pending.erase(m_pending.begin(), m_pending.begin() + due);
+  }
+
+ private:
+  std::vector<Pointer> m_channels;  // Uma fonte por canal
+  // Estado de cada canal (espelha start/stop); um byte por canal para que
+  // tarefas paralelas escrevam canais vizinhos sem corrida
+  std::vector<uint8_t> m_running;
+  std::vector<std::unique_ptr<EffectChain>> m_effects;  // Vazio = sem efeitos
+  std::vector<Command> m_pending;  // Comandos agendados, por atFrame
+  RenderPool* m_pool;              // Renderização paralela (opcional)
+
+  static bool targets(const Command& cmd, uint32_t c) {
+    return cmd.channel == ALL_CHANNELS ||
+           static_cast<uint32_t>(cmd.channel) == c;
+  }
+
+  // Aplica `cmd` somente ao canal `c`
+  void applyTo(const Command& cmd, uint32_t c) {
+    Generator& generator = *m_channels[c];
+    switch (cmd.type) {
+      case CMD_START:
+        generator.start();
+        m_running[c] = 1;
+        break;
+      case CMD_STOP:
+        generator.stop();
+        m_running[c] = 0;
+        break;
+      case CMD_SET_FREQ:
+        generator.rampParameter(PARAM_FREQUENCY, cmd.value, cmd.rampFrames);
+        break;
+      case CMD_SET_AMP:
+        generator.rampParameter(PARAM_AMPLITUDE, cmd.value, cmd.rampFrames);
+        break;
+      case CMD_SET_PHASE:
+        generator.setParameter(PARAM_PHASE, cmd.value);
+        break;
+      case CMD_SET_EFFECT:
+        if (!m_effects.empty()) m_effects[c]->apply(cmd);
+        break;
+      case CMD_SET_SPEED:
+        generator.setParameter(PARAM_SPEED, cmd.value);
+        break;
+      case CMD_SEEK:
+        generator.setParameter(PARAM_POSITION, cmd.value);
+        break;
+      default:
+        break;
+    }
+  }
+
+  /**
+   * Bloco inteiro do canal `c` em `out`, aplicando os comandos de
+   * m_pending[0, due) que o endereçam e dividindo a geração nesses
+   * instantes. Canais parados (ou que produzam menos) são completados com
+   * silêncio.
+   */
+  void renderChannel(uint32_t c, double* out, size_t frames,
+                     uint64_t startFrame, bool sampleAccurate, size_t due) {
+    size_t next = 0;  // Próximo comando vencido ainda não examinado
+    size_t done = 0;
+    while (done < frames) {
+      uint64_t now = startFrame + done;
+      uint64_t horizon = sampleAccurate ? now : startFrame + frames - 1;
+      for (; next < due && m_pending[next].atFrame <= horizon; ++next) {
+        if (targets(m_pending[next], c)) applyTo(m_pending[next], c);
+      }
+
+      // O trecho vai até o próximo comando deste canal (ou o fim do bloco)
+      size_t end = frames;
+      for (size_t i = next; i < due; ++i) {
+        if (targets(m_pending[i], c)) {
+          end = static_cast<size_t>(m_pending[i].atFrame - startFrame);
+          break;
+        }
+      }
+
+      size_t produced = m_channels[c]->generateSamples(out + done, end - done);
+      std::fill(out + done + produced, out + end, 0.0);
+      if (!m_effects.empty() && m_running[c]) {
+        m_effects[c]->process(out + done, end - done);
+      }
+      done = end;
+    }
+  }
+
+  template <typename Fn>
+  void forEachTarget(int32_t target, Fn fn) {
+    if (target == ALL_CHANNELS) {
+      for (uint32_t c = 0; c < channelCount(); ++c) fn(c);
+    } else if (isValidTarget(target)) {
+      fn(static_cast<uint32_t>(target));
+    }
+  }
+
+  void setRunning(int32_t target, bool running) {
+    forEachTarget(target, [&](uint32_t c) {
+      if (running) {
+        m_channels[c]->start();
+      } else {
+        m_channels[c]->stop();
+      }
+      m_running[c] = running ? 1 : 0;
+    });
+  }
+};
+
+// Canais de qualquer tipo de fonte, via ISignalGenerator
+using ChannelEngine = BasicChannelEngine<ISignalGenerator>;
+
+#endif  // CHANNEL_ENGINE_HPP
@@ -0,0 +1,225 @@
+#ifndef COMMAND_PROTOCOL_HPP
+#define COMMAND_PROTOCOL_HPP
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "Communication.hpp"
+
+/**
+ * @file CommandProtocol.hpp
+ * @brief Framing binário dos comandos no FIFO e das confirmações.
+ *
+ * Cada frame é um CommandFrameHeader seguido de `count` Commands e é enviado
+ * com um único write() de no máximo PIPE_BUF bytes, o que o kernel garante
+ * ser atômico: frames de controladores diferentes nunca se misturam e um
+ * lote inteiro chega (e é aplicado) de uma vez. O leitor não depende do
+ * tamanho das leituras: CommandDecoder remonta frames a partir de leituras
+ * curtas e ressincroniza no próximo magic se encontrar lixo.
+ *
+ * Com CMD_FLAG_ACK o gerador responde com um CommandReply no FIFO_REPLY,
+ * levando o mesmo `seq`, o resultado e o instante atual do relógio de
+ * amostras (útil para agendar comandos com Command::atFrame).
+ */
+
+constexpr uint32_t CMD_FRAME_MAGIC = 0x46444D43;  ///< "CMDF" em little-endian
+constexpr uint32_t CMD_REPLY_MAGIC = 0x50455243;  ///< "CREP" em little-endian
+constexpr uint32_t CMD_FLAG_ACK = 1u << 0;        ///< Pede um CommandReply
+
+struct CommandFrameHeader {
+  uint32_t magic;  ///< CMD_FRAME_MAGIC
+  uint32_t seq;    ///< Número de sequência escolhido pelo remetente
+  uint32_t flags;  ///< CMD_FLAG_*
+  uint32_t count;  ///< Comandos que seguem o cabeçalho
+};
+
+constexpr size_t MAX_FRAME_BYTES = PIPE_BUF;  ///< Limite de write() atômico
+constexpr size_t MAX_BATCH_COMMANDS =
+    (MAX_FRAME_BYTES - sizeof(CommandFrameHeader)) /
+    sizeof(Command);  ///< Comandos por frame (127 com PIPE_BUF = 4096)
+
+// Resultado de um frame
+enum ReplyStatus : uint32_t {
+  REPLY_OK,               ///< Lote inteiro aceito
+  REPLY_INVALID_CHANNEL,  ///< Algum comando endereça um canal inexistente
+  REPLY_QUEUE_FULL,       ///< Fila de comandos agendados cheia
+  REPLY_MALFORMED,        ///< Frame inválido (lote descartado)
+  REPLY_UNSUPPORTED       ///< Comando sem suporte neste modo (ex.: efeitos)
+};
+
+struct CommandReply {
+  uint32_t magic;   ///< CMD_REPLY_MAGIC
+  uint32_t seq;     ///< `seq` do frame confirmado
+  uint32_t status;  ///< ReplyStatus (lote é aplicado por inteiro ou não)
+  uint32_t count;   ///< Comandos do frame
+  uint64_t frame;   ///< Relógio de amostras do gerador ao processar
+};
+
+inline const char* replyStatusName(uint32_t status) {
+  switch (status) {
+    case REPLY_OK:
+      return "ok";
+    case REPLY_INVALID_CHANNEL:
+      return "invalid channel";
+    case REPLY_QUEUE_FULL:
+      return "command queue full";
+    case REPLY_UNSUPPORTED:
+      return "unsupported in this mode";
+    default:
+      return "malformed frame";
+  }
+}
+
+/**
+ * @class CommandBatch
+ * @brief Monta um frame com até MAX_BATCH_COMMANDS comandos.
+ */
+class CommandBatch {
+ public:
+  CommandBatch() : m_count(0) {}
+
+  // Adiciona um comando; retorna false se o frame já está cheio
+  bool add(const Command& cmd) {
+    if (m_count == MAX_BATCH_COMMANDS) return false;
+    memcpy(m_bytes + sizeof(CommandFrameHeader) + m_count * sizeof(Command),
+           &cmd, sizeof(Command));
+    ++m_count;
+    return true;
+  }
+
+  size_t size() const { return m_count; }
+  bool empty() const { return m_count == 0; }
+  void clear() { m_count = 0; }
+
+  /**
+   * @brief Envia o lote como um único frame e esvazia o lote.
+   *
+   * Retorna false se o write() falhar ou for parcial (só possível se o
+   * descritor não for um pipe); nesse caso o lote é mantido, para ser
+   * reenviado (ex.: a um gerador reiniciado) ou descartado com clear().
+   */
+  bool send(int fd, uint32_t seq, uint32_t flags = CMD_FLAG_ACK) {
+    CommandFrameHeader header = {CMD_FRAME_MAGIC, seq, flags,
+                                 static_cast<uint32_t>(m_count)};
+    memcpy(m_bytes, &header, sizeof(header));
+    size_t bytes = sizeof(header) + m_count * sizeof(Command);
+    if (write(fd, m_bytes, bytes) != static_cast<ssize_t>(bytes)) return false;
+    m_count = 0;
+    return true;
+  }
+
+ private:
+  unsigned char m_bytes[MAX_FRAME_BYTES];
+  size_t m_count;
+};
+
+/**
+ * @class CommandDecoder
+ * @brief Remonta frames a partir de um descritor não bloqueante.
+ *
+ * Buffer fixo de dois frames máximos: nenhum frame válido fica preso entre
+ * duas leituras, e nada é alocado.
+ */
+class CommandDecoder {
+ public:
+  CommandDecoder() : m_used(0), m_malformed(0) {}
+
+  // Ainda há bytes no buffer (frame parcial ou frames não extraídos)
+  bool pending() const { return m_used > 0; }
+
+  /**
+   * @brief Lê o que couber no buffer a partir de `fd`; retorna os bytes
+   * lidos. Como um frame tem no máximo metade do buffer, depois de next()
+   * esvaziar os frames completos sempre há espaço para o próximo.
+   */
+  size_t fill(int fd) {
+    size_t before = m_used;
+    while (m_used < sizeof(m_bytes)) {
+      ssize_t n = read(fd, m_bytes + m_used, sizeof(m_bytes) - m_used);
+      if (n <= 0) break;  // EAGAIN (vazio), EOF ou erro: tenta depois
+      m_used += static_cast<size_t>(n);
+    }
+    return m_used - before;
+  }
+
+  /**
+   * @brief Extrai o próximo frame completo.
+   *
+   * Em caso de sucesso copia o cabeçalho e os comandos (até
+   * MAX_BATCH_COMMANDS) para `header`/`commands` e retorna true. Bytes que
+   * não formam um frame válido são pulados até o próximo magic e contados
+   * em malformed().
+   */
+  bool next(CommandFrameHeader& header, Command* commands) {
+    while (m_used >= sizeof(CommandFrameHeader)) {
+      memcpy(&header, m_bytes, sizeof(header));
+      if (header.magic != CMD_FRAME_MAGIC ||
+          header.count > MAX_BATCH_COMMANDS) {
+        discard(1);
+        resync();
+        ++m_malformed;
+        continue;
+      }
+
+      size_t bytes = sizeof(header) + header.count * sizeof(Command);
+      if (m_used < bytes) return false;  // Resto do frame ainda não chegou
+
+      memcpy(commands, m_bytes + sizeof(header),
+             header.count * sizeof(Command));
+      discard(bytes);
+      return true;
+    }
+    return false;
+  }
+
+  uint64_t malformed() const { return m_malformed; }
+
+ private:
+  unsigned char m_bytes[2 * MAX_FRAME_BYTES];
+  size_t m_used;
+  uint64_t m_malformed;
+
+  void discard(size_t bytes) {
+    memmove(m_bytes, m_bytes + bytes, m_used - bytes);
+    m_used -= bytes;
+  }
+
+  // Pula até a próxima ocorrência do magic (ou mantém os últimos 3 bytes,
+  // que podem ser o começo de um magic ainda incompleto)
+  void resync() {
+    uint32_t magic = CMD_FRAME_MAGIC;
+    size_t skip = 0;
+    while (skip + sizeof(magic) <= m_used &&
+           memcmp(m_bytes + skip, &magic, sizeof(magic)) != 0) {
+      ++skip;
+    }
+    if (skip + sizeof(magic) > m_used) {
+      skip = m_used >= sizeof(magic) ? m_used - (sizeof(magic) - 1) : 0;
+    }
+    discard(skip);
+  }
+};
+
+/**
+ * @brief Envia uma confirmação sem bloquear.
+ *
+ * O FIFO_REPLY é aberto sob demanda: enquanto nenhum controlador o tiver
+ * aberto para leitura, open() falha com ENXIO e a confirmação é descartada.
+ * Um leitor que fechou o FIFO (EPIPE) faz o descritor ser reaberto depois.
+ */
+inline void sendReply(int& replyFd, const CommandReply& reply) {
+  if (replyFd < 0) replyFd = open(FIFO_REPLY, O_WRONLY | O_NONBLOCK);
+  if (replyFd < 0) return;
+  if (write(replyFd, &reply, sizeof(reply)) < 0 && errno == EPIPE) {
+    close(replyFd);
+    replyFd = -1;
+  }
+}
+
+#endif  // COMMAND_PROTOCOL_HPP
@@ -0,0 +1,373 @@
+#ifndef COMMAND_SCRIPT_HPP
+#define COMMAND_SCRIPT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Communication.hpp"
+#include "EffectChain.hpp"
+
+/**
+ * @file CommandScript.hpp
+ * @brief Sequência de comandos com instantes, lida e expandida por inteiro
+ * antes do primeiro envio (modo script do controlador).
+ *
+ * Formato texto, uma ação por linha ('#' começa um comentário):
+ *
+ *     TIME [ch N|all] start|stop|quit
+ *     TIME [ch N|all] freq|amp VALUE [RAMP_MS]
+ *     TIME [ch N|all] phase RAD
+ *     TIME [ch N|all] speed FACTOR | seek SECONDS   (reprodução de arquivo)
+ *     TIME [ch N|all] fx STAGE KIND [VALORES]   (como no modo interativo)
+ *     TIME repeat COUNT PERIOD
+ *       ...
+ *     end
+ *
+ * TIME é em segundos (sufixo "s" opcional) a partir do início do bloco que
+ * contém a linha: o script ou a iteração corrente do repeat. repeat executa
+ * as linhas até o end correspondente COUNT vezes, uma iteração a cada
+ * PERIOD segundos, e pode ser aninhado. Os números de uma linha podem
+ * variar com o índice i (0, 1, ...) da iteração mais interna: "100+10" vale
+ * 100 + 10·i e "100*1.01" vale 100·1.01^i. Uma varredura de mil passos:
+ *
+ *     0 start
+ *     0 repeat 1000 0.01
+ *       0 freq 100*1.005 10
+ *     end
+ *
+ * Formato binário (loadBinary): Commands do protocolo em sequência, com
+ * atFrame contado em quadros a partir do início da reprodução.
+ *
+ * O resultado é a lista de comandos ordenada por instante. A ordenação é
+ * estável, então comandos no mesmo instante mantêm a ordem do arquivo. Os
+ * comandos de um mesmo "fx" vêm marcados com `joined` e precisam ir no
+ * mesmo frame.
+ */
+class CommandScript {
+ public:
+  static constexpr size_t MAX_COMMANDS = size_t(1) << 22;  ///< Já expandidos
+  static constexpr size_t MAX_DEPTH = 16;  ///< Repeats aninhados
+
+  struct Entry {
+    uint64_t frame;  ///< Instante relativo ao início (quadros)
+    Command cmd;     ///< Comando com o canal; atFrame vem no envio
+    bool joined;     ///< Vai no mesmo frame que o anterior
+  };
+
+  CommandScript() : m_errorPosition(0), m_framesPerSecond(0.0), m_steps(0) {}
+
+  /**
+   * @brief Lê um script texto inteiro. `framesPerSecond` converte segundos
+   * e rampas em quadros.
+   *
+   * Em erro retorna false com a descrição em `error`; errorPosition() dá a
+   * linha. Nada é enviado antes de o arquivo todo ser aceito.
+   */
+  bool parse(std::istream& in, double framesPerSecond, const char*& error) {
+    m_entries.clear();
+    m_lines.clear();
+    m_framesPerSecond = framesPerSecond;
+    m_steps = 0;
+    if (!tokenize(in, error)) return false;
+    if (!expand(0, m_lines.size(), 0.0, 0.0, error)) return false;
+    sortEntries();
+    m_errorPosition = 0;
+    return true;
+  }
+
+  /**
+   * @brief Lê um fluxo binário de Commands inteiro; errorPosition() dá o
+   * registro (a partir de 1) em caso de erro.
+   */
+  bool loadBinary(std::istream& in, const char*& error) {
+    m_entries.clear();
+    m_errorPosition = 0;
+    std::string bytes((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+    if (bytes.size() % sizeof(Command) != 0) {
+      error = "binary stream is not a whole number of commands";
+      return false;
+    }
+    size_t count = bytes.size() / sizeof(Command);
+    if (count > MAX_COMMANDS) {
+      error = "script too large";
+      return false;
+    }
+    m_entries.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      Entry entry;
+      memcpy(&entry.cmd, bytes.data() + i * sizeof(Command), sizeof(Command));
+      entry.frame = entry.cmd.atFrame;
+      entry.cmd.atFrame = 0;
+      entry.joined = false;
+      const Command& cmd = entry.cmd;
+      if (cmd.type <= CMD_NONE || cmd.type > CMD_SEEK ||
+          (cmd.type == CMD_SET_EFFECT && !isValidEffectCommand(cmd))) {
+        m_errorPosition = i + 1;
+        error = "invalid command record";
+        return false;
+      }
+      m_entries.push_back(entry);
+    }
+    sortEntries();
+    return true;
+  }
+
+  const std::vector<Entry>& entries() const { return m_entries; }
+  size_t errorPosition() const { return m_errorPosition; }
+
+  // Instante do último comando (quadros)
+  uint64_t duration() const {
+    return m_entries.empty() ? 0 : m_entries.back().frame;
+  }
+
+ private:
+  // Linha já separada em campos; a expansão reavalia os números a cada
+  // iteração
+  struct Line {
+    size_t number;                  // Linha no arquivo
+    double time;                    // Segundos desde o início do bloco
+    int32_t channel;                // Alvo (ALL_CHANNELS = todos)
+    std::string command;            // start, freq, repeat, ...
+    std::vector<std::string> args;  // Campos depois do comando
+    size_t end;                     // repeat: índice da linha do end
+  };
+
+  std::vector<Entry> m_entries;
+  std::vector<Line> m_lines;
+  size_t m_errorPosition;
+  double m_framesPerSecond;
+  size_t m_steps;  // Linhas visitadas na expansão (limita repeats vazios)
+
+  // Número com variação opcional pelo índice ("A", "A+B" ou "A*B")
+  static bool parseValue(const std::string& text, double index,
+                         double& value) {
+    const char* start = text.c_str();
+    char* end;
+    value = strtod(start, &end);
+    if (end == start) return false;
+    if (*end == '+' || *end == '*') {
+      char op = *end;
+      const char* stepText = end + 1;
+      double step = strtod(stepText, &end);
+      if (end == stepText) return false;
+      value = op == '+' ? value + step * index : value * std::pow(step, index);
+    }
+    return *end == '\0' && std::isfinite(value);
+  }
+
+  static bool parseTime(std::string text, double& seconds) {
+    if (!text.empty() && text.back() == 's') text.pop_back();
+    char* end;
+    seconds = strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && std::isfinite(seconds) &&
+           seconds >= 0.0;
+  }
+
+  uint64_t toFrames(double seconds) const {
+    return static_cast<uint64_t>(std::llround(seconds * m_framesPerSecond));
+  }
+
+  // Separa as linhas em campos e casa cada repeat com o seu end
+  bool tokenize(std::istream& in, const char*& error) {
+    std::vector<size_t> open;  // repeats ainda sem end
+    std::string text;
+    for (size_t number = 1; std::getline(in, text); ++number) {
+      m_errorPosition = number;
+      text = text.substr(0, text.find('#'));
+      std::istringstream iss(text);
+      std::vector<std::string> fields{std::istream_iterator<std::string>(iss),
+                                      std::istream_iterator<std::string>()};
+      if (fields.empty()) continue;
+
+      Line line = {number, 0.0, ALL_CHANNELS, "", {}, 0};
+      size_t next = 0;
+      if (fields[0] == "end") {
+        if (fields.size() != 1 || open.empty()) {
+          error = "'end' without 'repeat'";
+          return false;
+        }
+        m_lines[open.back()].end = m_lines.size();
+        open.pop_back();
+        line.command = "end";
+        m_lines.push_back(line);
+        continue;
+      }
+      if (!parseTime(fields[next++], line.time)) {
+        error = "invalid time (use seconds, e.g. '1.25' or '1.25s')";
+        return false;
+      }
+      if (next < fields.size() && fields[next] == "ch") {
+        if (++next == fields.size()) {
+          error = "use 'ch N' or 'ch all'";
+          return false;
+        }
+        const std::string& target = fields[next++];
+        double channel;
+        if (target != "all") {
+          if (!parseValue(target, 0.0, channel) || channel < 0.0 ||
+              channel >= MAX_CHANNELS || channel != std::floor(channel)) {
+            error = "use 'ch N' or 'ch all'";
+            return false;
+          }
+          line.channel = static_cast<int32_t>(channel);
+        }
+      }
+      if (next == fields.size()) {
+        error = "missing command";
+        return false;
+      }
+      line.command = fields[next++];
+      line.args.assign(fields.begin() + next, fields.end());
+      if (line.command == "repeat") {
+        if (open.size() == MAX_DEPTH) {
+          error = "repeats nested too deep";
+          return false;
+        }
+        open.push_back(m_lines.size());
+      }
+      m_lines.push_back(line);
+    }
+    if (!open.empty()) {
+      m_errorPosition = m_lines[open.back()].number;
+      error = "'repeat' without 'end'";
+      return false;
+    }
+    return true;
+  }
+
+  // Gera os comandos das linhas [begin, end) de um bloco iniciado em
+  // `start` segundos, na iteração `index` do repeat que o contém
+  bool expand(size_t begin, size_t end, double start, double index,
+              const char*& error) {
+    for (size_t i = begin; i < end; ++i) {
+      const Line& line = m_lines[i];
+      m_errorPosition = line.number;
+      if (++m_steps > 4 * MAX_COMMANDS) {
+        error = "script too large";
+        return false;
+      }
+      double at = start + line.time;
+      if (line.command != "repeat") {
+        if (!emit(line, at, index, error)) return false;
+        continue;
+      }
+      double count, period;
+      if (line.args.size() != 2 || !parseValue(line.args[0], index, count) ||
+          !parseValue(line.args[1], index, period) || count < 0.0 ||
+          count > MAX_COMMANDS || count != std::floor(count) ||
+          period < 0.0) {
+        error = "use 'TIME repeat COUNT PERIOD'";
+        return false;
+      }
+      for (size_t k = 0; k < static_cast<size_t>(count); ++k) {
+        if (!expand(i + 1, line.end, at + k * period,
+                    static_cast<double>(k), error)) {
+          return false;
+        }
+      }
+      i = line.end;  // O laço pula a linha do end
+    }
+    return true;
+  }
+
+  // Converte uma linha de comando nos Commands correspondentes
+  bool emit(const Line& line, double at, double index, const char*& error) {
+    const std::vector<std::string>& args = line.args;
+    Command cmds[MAX_EFFECT_COMMANDS];
+    size_t count = 0;
+    std::vector<double> values;
+    size_t firstValue = line.command == "fx" ? 2 : 0;
+    for (size_t a = firstValue; a < args.size(); ++a) {
+      double value;
+      if (!parseValue(args[a], index, value)) {
+        error = "invalid number";
+        return false;
+      }
+      values.push_back(value);
+    }
+
+    const std::string& name = line.command;
+    if (name == "start" || name == "stop" || name == "quit") {
+      if (!values.empty()) {
+        error = "start, stop and quit take no arguments";
+        return false;
+      }
+      cmds[count++] = Command(name == "start"  ? CMD_START
+                              : name == "stop" ? CMD_STOP
+                                               : CMD_QUIT);
+    } else if (name == "freq" || name == "amp") {
+      if (values.empty() || values.size() > 2 ||
+          (values.size() == 2 && values[1] < 0.0)) {
+        error = "use 'freq|amp VALUE [RAMP_MS]'";
+        return false;
+      }
+      if (values.size() == 2 &&
+          values[1] / 1000.0 * m_framesPerSecond > MAX_RAMP_FRAMES) {
+        error = "ramp too long";
+        return false;
+      }
+      Command& cmd = cmds[count++];
+      cmd = Command(name == "freq" ? CMD_SET_FREQ : CMD_SET_AMP, values[0]);
+      if (values.size() == 2) {
+        cmd.rampFrames = static_cast<uint32_t>(toFrames(values[1] / 1000.0));
+      }
+    } else if (name == "phase") {
+      if (values.size() != 1) {
+        error = "use 'phase RAD'";
+        return false;
+      }
+      cmds[count++] = Command(CMD_SET_PHASE, values[0]);
+    } else if (name == "speed" || name == "seek") {
+      if (values.size() != 1 || values[0] < 0.0) {
+        error = "use 'speed FACTOR' or 'seek SECONDS'";
+        return false;
+      }
+      cmds[count++] =
+          Command(name == "speed" ? CMD_SET_SPEED : CMD_SEEK, values[0]);
+    } else if (name == "fx") {
+      double stage;
+      EffectKind kind;
+      if (args.size() < 2 || !parseValue(args[0], index, stage) ||
+          stage < 0.0 || stage != std::floor(stage) ||
+          !parseEffectKind(args[1].c_str(), kind) ||
+          (count = buildEffectCommands(static_cast<uint32_t>(stage), kind,
+                                       values, m_framesPerSecond, cmds)) ==
+              0) {
+        error = "invalid fx (see the controller's 'fx' command)";
+        return false;
+      }
+    } else {
+      error = "unknown command";
+      return false;
+    }
+
+    if (m_entries.size() + count > MAX_COMMANDS) {
+      error = "script too large";
+      return false;
+    }
+    for (size_t c = 0; c < count; ++c) {
+      cmds[c].channel = line.channel;
+      m_entries.push_back({toFrames(at), cmds[c], c > 0});
+    }
+    return true;
+  }
+
+  void sortEntries() {
+    std::stable_sort(m_entries.begin(), m_entries.end(),
+                     [](const Entry& a, const Entry& b) {
+                       return a.frame < b.frame;
+                     });
+  }
+};
+
+#endif  // COMMAND_SCRIPT_HPP
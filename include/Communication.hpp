@@ -1,8 +1,16 @@
 #ifndef COMMUNICATION_HPP
 #define COMMUNICATION_HPP
 
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 
+#include "SampleFormat.hpp"
+#include "Telemetry.hpp"
+
 /**
  * @file Communication.hpp
  * @brief Define estruturas de comunicação entre processos (gerador e
@@ -18,12 +26,20 @@ constexpr int SAMPLES_PER_FRAME =
 constexpr int FRAME_INTERVAL_MS = 50;  ///< Intervalo entre quadros (20 fps)
 constexpr double MAX_AMPLITUDE = 1.0;  ///< Amplitude máxima normalizada
 
-constexpr int BUFFER_SIZE =
-    16384;  ///< Tamanho do buffer circular (potência de 2 para wrap)
+constexpr uint64_t DEFAULT_BUFFER_CAPACITY =
+    16384;  ///< Capacidade padrão do anel (potência de 2 para wrap)
+constexpr size_t CACHE_LINE_SIZE =
+    64;  ///< Alinhamento para evitar false sharing entre contadores
 const char* const FIFO_COMMAND =
     "/tmp/sine_commands";  ///< Pipe nomeado para comandos
+const char* const FIFO_REPLY =
+    "/tmp/sine_replies";  ///< Pipe nomeado para confirmações do gerador
 const char* const SHARED_MEMORY_NAME =
     "/sine_buffer";  ///< Nome do objeto de memória compartilhada
+constexpr uint32_t SHM_MAGIC = 0x454E4953;  ///< "SINE" em little-endian
+constexpr uint32_t SHM_VERSION = 5;  ///< Versão do layout do segmento
+constexpr uint32_t MAX_CHANNELS = 64;  ///< Máximo de canais por segmento
+constexpr int32_t ALL_CHANNELS = -1;  ///< Comando endereçado a todos os canais
 
 // Tipos de comando enviados do controlador para o gerador
 enum CommandType {
@@ -32,37 +48,248 @@ enum CommandType {
   CMD_STOP,      ///< Parar geração
   CMD_SET_FREQ,  ///< Ajustar frequência (value = frequência em Hz)
   CMD_SET_AMP,   ///< Ajustar amplitude (value = amplitude)
-  CMD_QUIT       ///< Encerrar processo gerador
+  CMD_QUIT,      ///< Encerrar processo gerador
+  CMD_SET_PHASE,  ///< Ajustar fase (value = fase em radianos)
+  CMD_SET_EFFECT,  ///< Configurar um estágio de efeito (ver EffectChain.hpp)
+  CMD_SET_SPEED,  ///< Velocidade de reprodução de arquivo (value = fator)
+  CMD_SEEK        ///< Posição de reprodução de arquivo (value = segundos)
 };
 
+/**
+ * @struct Command
+ * @brief Um comando do protocolo (ver CommandProtocol.hpp para o framing).
+ *
+ * `atFrame` é um instante absoluto no relógio de amostras do anel (o valor
+ * de `head` em que o comando deve valer); 0 ou um instante já passado
+ * aplicam no início do próximo bloco. `rampFrames` > 0 transforma
+ * SET_FREQ/SET_AMP numa rampa linear até `value` ao longo desse número de
+ * quadros, em vez de um degrau (que causa "zipper noise" em varreduras).
+ */
 struct Command {
-  CommandType type;  ///< Tipo do comando
-  double value;      ///< Parâmetro associado (quando aplicável)
+  CommandType type;     ///< Tipo do comando
+  int32_t channel;      ///< Canal alvo (ALL_CHANNELS = todos)
+  double value;         ///< Parâmetro associado (quando aplicável)
+  uint64_t atFrame;     ///< Instante de aplicação (0 = imediato)
+  uint32_t rampFrames;  ///< Duração da rampa linear (0 = degrau)
+  uint32_t arg;         ///< Argumento extra (CMD_SET_EFFECT: estágio e
+                        ///< parâmetro); zero nos demais
+
+  Command()
+      : type(CMD_NONE),
+        channel(ALL_CHANNELS),
+        value(0.0),
+        atFrame(0),
+        rampFrames(0),
+        arg(0) {}
+  Command(CommandType t, double v = 0.0, int32_t ch = ALL_CHANNELS)
+      : type(t), channel(ch), value(v), atFrame(0), rampFrames(0), arg(0) {}
+};
+
+static_assert(sizeof(Command) == 32, "Command faz parte do protocolo binário");
+
+// Rampa mais longa que Command::rampFrames representa (~24 h a 48 kHz);
+// quem converte de tempo rejeita valores acima em vez de truncar
+constexpr double MAX_RAMP_FRAMES = UINT32_MAX;
+
+// Organização dos canais no anel
+enum ChannelLayout : uint32_t {
+  LAYOUT_INTERLEAVED,  ///< Quadro a quadro: c0 c1 ... cN-1 c0 c1 ...
+  LAYOUT_PLANAR        ///< Um plano de `capacity` amostras por canal
+};
 
-  Command() : type(CMD_NONE), value(0.0) {}
-  Command(CommandType t, double v = 0.0) : type(t), value(v) {}
+/**
+ * @struct RingLayout
+ * @brief Parâmetros do anel escolhidos pelo produtor na inicialização.
+ */
+struct RingLayout {
+  uint64_t capacity = DEFAULT_BUFFER_CAPACITY;  ///< Quadros (potência de 2)
+  SampleFormat format = FORMAT_F64;             ///< Formato das amostras
+  uint32_t channels = 1;                        ///< Canais por quadro
+  ChannelLayout channelLayout = LAYOUT_INTERLEAVED;  ///< Organização
+  double sampleRate = 0.0;                      ///< Hz (0 = modo visual)
 };
 
 /**
  * @struct SharedBuffer
- * @brief Buffer circular em memória compartilhada para transferência de
- * amostras.
+ * @brief Cabeçalho do segmento de memória compartilhada, seguido do anel de
+ * difusão (um produtor, N consumidores) com as amostras.
+ *
+ * Layout do segmento:
+ *
+ *   [0, consumersOffset)     este cabeçalho (inclui ProducerTelemetry)
+ *   [consumersOffset, +4096) tabela de ConsumerSlot (página própria)
+ *   [headerSize, ...)        capacity * channels * sampleFormatSize() bytes
+ *   [..., totalSize)         preenchimento (ex.: arredondamento para 2 MiB)
+ *
+ * O anel é contado em quadros de amostra (uma amostra por canal). No layout
+ * intercalado o quadro f ocupa os slots [(f & mask) * channels, ... +
+ * channels); no planar o canal c tem seu próprio plano contíguo de
+ * `capacity` slots, começando no slot c * capacity.
+ *
+ * O descritor (magic até totalSize) é escrito uma única vez pelo produtor;
+ * `magic` é publicado por último, com release, e só então o segmento é
+ * considerado válido. Consumidores não dependem de nenhuma constante de
+ * compilação: mapeiam o segmento inteiro e leem capacidade, formato e canais
+ * do cabeçalho, recusando versões diferentes de SHM_VERSION.
  *
- * O gerador escreve amostras na posição writePos, o visualizador lê de readPos.
- * newDataAvailable indica que novos dados foram escritos após um quadro
- * completo.
+ * O segmento sobrevive ao produtor (ver createSharedBuffer). Um gerador que
+ * reinicia com o mesmo layout reaproveita o segmento em vez de recriá-lo:
+ * head/claim continuam de onde pararam e a troca fica visível em `epoch`,
+ * que cada RingReader confere a cada leitura para ressincronizar o cursor
+ * sem remapear. Com outro layout o segmento antigo é aposentado (`magic`
+ * volta a 0) antes de o nome passar a um segmento novo.
+ *
+ * Os contadores head/claim são de 64 bits, contam quadros e crescem
+ * monotonicamente (nunca sofrem wrap na prática); a posição física no anel é
+ * `contador & (capacity - 1)`. Só o produtor escreve no cabeçalho e no anel:
+ * cada consumidor mantém seu próprio cursor privado (ver RingReader), de
+ * modo que vários visualizadores, gravadores e analisadores podem ler o
+ * mesmo fluxo sem roubar amostras uns dos outros. As únicas escritas dos
+ * consumidores vão para a página da tabela de consumidores: o contador
+ * frameWaiters() e, opcionalmente, o seu slot de telemetria (ver
+ * Telemetry.hpp e registerConsumer()).
+ *
+ * - head:  escrito pelo produtor com release após copiar um quadro;
+ *          o consumidor lê com acquire e só então acessa as amostras.
+ * - claim: escrito pelo produtor ANTES de sobrescrever slots; permite ao
+ *          consumidor detectar amostras que foram sobrescritas durante a
+ *          cópia (validação estilo seqlock).
+ * - frameSeq: palavra de futex incrementada após cada publicação; os
+ *          consumidores dormem nela em vez de fazer polling e se contam em
+ *          frameWaiters(), para o produtor só fazer a syscall de wake
+ *          quando há alguém dormindo.
+ * - sampleRate/frequency: metadados do sinal para os consumidores
+ *          (sampleRate == 0 indica o modo visual legado, sem taxa física;
+ *          frequency[c] é a frequência atual do canal c).
+ * - telemetry: contadores e histogramas do produtor, para raspagem externa.
+ * - epoch/epochStart/producerPid: execução atual do produtor. epochStart
+ *          (o head em que ela começou) é escrito antes de epoch, com
+ *          release, e ambos antes do primeiro quadro da execução.
+ *
+ * Política de overrun: o produtor NUNCA bloqueia nem sabe quantos
+ * consumidores existem. Um consumidor atrasado mais de `capacity` quadros
+ * perde os mais antigos; ele detecta isso comparando seu cursor com
+ * head/claim, contabiliza a perda e ressincroniza nas amostras mais antigas
+ * ainda válidas. Amostras entregues ao consumidor nunca são parciais.
  */
 struct SharedBuffer {
-  double samples[BUFFER_SIZE];  ///< Amostras no buffer circular
-  int writePos;                 ///< Posição atual de escrita (produtor)
-  int readPos;                  ///< Posição atual de leitura (consumidor)
-  bool newDataAvailable;        ///< Sinaliza novo quadro disponível
-  int totalProduced;            ///< Total de amostras produzidas (estatística)
-
-  SharedBuffer()
-      : writePos(0), readPos(0), newDataAvailable(false), totalProduced(0) {
-    memset(samples, 0, sizeof(samples));
+  // Descritor do layout (imutável após a inicialização)
+  std::atomic<uint32_t> magic;  ///< SHM_MAGIC quando o segmento está válido
+  uint32_t version;             ///< Versão do layout (SHM_VERSION)
+  uint32_t headerSize;          ///< Offset do anel a partir do início
+  uint32_t consumersOffset;     ///< Offset da tabela de ConsumerSlot
+  SampleFormat sampleFormat;    ///< Formato das amostras no anel
+  uint32_t channels;            ///< Canais por quadro
+  ChannelLayout channelLayout;  ///< Intercalado ou planar
+  uint64_t capacity;            ///< Capacidade do anel em quadros
+  uint64_t totalSize;           ///< Tamanho do segmento em bytes
+
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head;  ///< Amostras publicadas
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> claim;  ///< Reserva de escrita
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> frameSeq;  ///< Futex de quadro
+  alignas(CACHE_LINE_SIZE) std::atomic<double> sampleRate;  ///< Hz (0 = visual)
+  std::atomic<double> frequency[MAX_CHANNELS];  ///< Hz, por canal
+  alignas(CACHE_LINE_SIZE) ProducerTelemetry telemetry;  ///< Só o produtor
+
+  // Execuções do produtor: mudam só quando um gerador assume o segmento
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> epoch;  ///< 1 = primeira
+  std::atomic<uint32_t> producerPid;  ///< Produtor ativo (0 = nenhum)
+  std::atomic<uint64_t> epochStart;   ///< head no início da execução
+
+  // Inicializa tudo menos `magic`, que o criador publica ao final.
+  // `segmentSize` pode exceder segmentBytes(layout) (ex.: páginas grandes).
+  SharedBuffer(const RingLayout& layout, size_t segmentSize)
+      : magic(0),
+        version(SHM_VERSION),
+        headerSize(static_cast<uint32_t>(headerBytes())),
+        consumersOffset(static_cast<uint32_t>(consumerTableOffset())),
+        sampleFormat(layout.format),
+        channels(layout.channels),
+        channelLayout(layout.channelLayout),
+        capacity(layout.capacity),
+        totalSize(segmentSize),
+        head(0),
+        claim(0),
+        frameSeq(0),
+        sampleRate(layout.sampleRate),
+        telemetry(),
+        epoch(1),
+        producerPid(static_cast<uint32_t>(getpid())),
+        epochStart(0) {
+    for (std::atomic<double>& f : frequency) f.store(0.0);
+    memset(reinterpret_cast<unsigned char*>(this) + consumersOffset, 0,
+           CONSUMER_TABLE_BYTES);
+    memset(data(), 0, totalSize - headerSize);
+  }
+
+  unsigned char* data() {
+    return reinterpret_cast<unsigned char*>(this) + headerSize;
+  }
+  const unsigned char* data() const {
+    return reinterpret_cast<const unsigned char*>(this) + headerSize;
+  }
+  // Tabela de consumidores (MAX_CONSUMERS slots), para leitura
+  const ConsumerSlot* consumers() const {
+    return reinterpret_cast<const ConsumerSlot*>(
+        reinterpret_cast<const unsigned char*>(this) + consumersOffset);
+  }
+
+  // Leitores dentro de RingReader::waitForData(). É a única palavra que todo
+  // consumidor escreve, então fica na página da tabela, que
+  // attachSharedBuffer mapeia com escrita mesmo num mapeamento de leitura.
+  std::atomic<uint32_t>& frameWaiters() const {
+    return *reinterpret_cast<std::atomic<uint32_t>*>(
+        const_cast<unsigned char*>(
+            reinterpret_cast<const unsigned char*>(this)) +
+        consumersOffset + FRAME_WAITERS_OFFSET);
+  }
+
+  uint64_t mask() const { return capacity - 1; }
+  size_t sampleBytes() const { return sampleFormatSize(sampleFormat); }
+
+  // Slot do canal `channel` na posição física `index` (< capacity)
+  unsigned char* slot(uint64_t index, uint32_t channel) {
+    return data() + slotOffset(index, channel);
+  }
+  const unsigned char* slot(uint64_t index, uint32_t channel) const {
+    return data() + slotOffset(index, channel);
+  }
+
+  // Bytes entre quadros consecutivos de um mesmo canal
+  size_t frameStride() const {
+    return channelLayout == LAYOUT_PLANAR ? sampleBytes()
+                                          : sampleBytes() * channels;
+  }
+
+  size_t slotOffset(uint64_t index, uint32_t channel) const {
+    uint64_t slotIndex = channelLayout == LAYOUT_PLANAR
+                             ? channel * capacity + index
+                             : index * channels + channel;
+    return slotIndex * sampleBytes();
+  }
+
+  // A tabela de consumidores começa na primeira página após o cabeçalho
+  static size_t consumerTableOffset() {
+    return (sizeof(SharedBuffer) + CONSUMER_TABLE_BYTES - 1) &
+           ~(CONSUMER_TABLE_BYTES - 1);
+  }
+
+  // Cabeçalho e tabela de consumidores: o anel começa alinhado a página
+  static size_t headerBytes() {
+    return consumerTableOffset() + CONSUMER_TABLE_BYTES;
+  }
+
+  // Tamanho total do segmento para um layout
+  static size_t segmentBytes(const RingLayout& layout) {
+    return headerBytes() + layout.capacity * layout.channels *
+                               sampleFormatSize(layout.format);
   }
 };
 
+static_assert((DEFAULT_BUFFER_CAPACITY & (DEFAULT_BUFFER_CAPACITY - 1)) == 0,
+              "DEFAULT_BUFFER_CAPACITY deve ser potência de 2");
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<double>::is_always_lock_free,
+              "Campos atômicos precisam ser lock-free para uso entre processos");
+
 #endif  // COMMUNICATION_HPP
@@ -0,0 +1,101 @@
+#ifndef EDGE_TRIGGER_HPP
+#define EDGE_TRIGGER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @file EdgeTrigger.hpp
+ * @brief Disparo por borda (estilo osciloscópio) avaliado amostra a amostra.
+ *
+ * O trigger recebe cada amostra nova uma única vez, com seu índice absoluto,
+ * e reporta o instante em que o sinal cruza `level` na direção escolhida.
+ * Depois de um disparo ele só rearma após `rearmSamples` (a janela de
+ * aquisição mais o holdoff), o que fixa a fase do traço na tela e limita o
+ * trabalho a no máximo um disparo por janela exibida.
+ */
+
+enum TriggerMode {
+  TRIGGER_OFF,     ///< Sem disparo: a tela mostra as amostras mais recentes
+  TRIGGER_RISING,  ///< Cruzamento de `level` para cima
+  TRIGGER_FALLING  ///< Cruzamento de `level` para baixo
+};
+
+inline const char* triggerModeName(TriggerMode mode) {
+  switch (mode) {
+    case TRIGGER_RISING:
+      return "rising";
+    case TRIGGER_FALLING:
+      return "falling";
+    default:
+      return "off";
+  }
+}
+
+// Converte "off", "rising" ou "falling"; retorna false se desconhecido
+inline bool parseTriggerMode(const char* name, TriggerMode& mode) {
+  for (TriggerMode m : {TRIGGER_OFF, TRIGGER_RISING, TRIGGER_FALLING}) {
+    if (strcmp(name, triggerModeName(m)) == 0) {
+      mode = m;
+      return true;
+    }
+  }
+  return false;
+}
+
+class EdgeTrigger {
+ public:
+  EdgeTrigger()
+      : m_mode(TRIGGER_OFF),
+        m_level(0.0),
+        m_rearmSamples(0),
+        m_armedAt(0),
+        m_previous(0.0),
+        m_hasPrevious(false) {}
+
+  // Nova configuração; rearma imediatamente
+  void configure(TriggerMode mode, double level, uint64_t rearmSamples) {
+    m_mode = mode;
+    m_level = level;
+    m_rearmSamples = rearmSamples;
+    m_armedAt = 0;
+    m_hasPrevious = false;
+  }
+
+  TriggerMode mode() const { return m_mode; }
+  double level() const { return m_level; }
+
+  /**
+   * @brief Avalia a amostra `index`; true se ela é o ponto de disparo.
+   *
+   * O ponto de disparo é a primeira amostra do outro lado do nível. Os
+   * índices precisam ser consecutivos (um salto, ex.: amostras perdidas,
+   * só atrasa o próximo disparo em uma amostra).
+   */
+  bool process(double sample, uint64_t index) {
+    double previous = m_previous;
+    bool hasPrevious = m_hasPrevious;
+    m_previous = sample;
+    m_hasPrevious = true;
+
+    if (m_mode == TRIGGER_OFF || !hasPrevious || index < m_armedAt) {
+      return false;
+    }
+    bool crossed = m_mode == TRIGGER_RISING
+                       ? previous < m_level && sample >= m_level
+                       : previous > m_level && sample <= m_level;
+    if (crossed) m_armedAt = index + std::max<uint64_t>(m_rearmSamples, 1);
+    return crossed;
+  }
+
+ private:
+  TriggerMode m_mode;
+  double m_level;           // Nível de disparo (unidades de amostra)
+  uint64_t m_rearmSamples;  // Amostras entre disparos (janela + holdoff)
+  uint64_t m_armedAt;       // Primeiro índice em que pode disparar de novo
+  double m_previous;        // Amostra anterior (para detectar o cruzamento)
+  bool m_hasPrevious;
+};
+
+#endif  // EDGE_TRIGGER_HPP
@@ -0,0 +1,403 @@
+#ifndef EFFECT_CHAIN_HPP
+#define EFFECT_CHAIN_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Communication.hpp"
+#include "ParameterRamp.hpp"
+#include "SineGenerator.hpp"
+
+/**
+ * @file EffectChain.hpp
+ * @brief Cadeia de processadores de bloco aplicada à saída de um canal,
+ * dentro do gerador, antes da publicação no anel.
+ *
+ * Cada canal tem MAX_EFFECT_STAGES estágios processados em ordem, no lugar,
+ * sobre cada trecho que o ChannelEngine renderiza (o bloco inteiro ou os
+ * pedaços entre comandos agendados, que continuam valendo na amostra
+ * exata). O tipo de cada estágio é decidido num switch uma vez por trecho;
+ * os laços internos percorrem o bloco sem chamadas indiretas, e os sem
+ * dependência entre amostras (ganho, mix) são vetorizáveis.
+ *
+ * Tipos de estágio:
+ * - lowpass/highpass/bandpass/notch: biquad (RBJ), forma direta II
+ *   transposta, com `frequency` (Hz) e `q`.
+ * - gain: multiplica por `gain` (linear), com rampa.
+ * - noise: soma ruído branco uniforme de amplitude `level`, com rampa.
+ * - mix: soma um segundo oscilador senoidal (um SineGenerator próprio, no
+ *   modo físico) em `frequency` com amplitude `level`, ambos com rampa. A
+ *   fonte é sempre essa senoide: cada canal renderiza em paralelo (ver
+ *   RenderPool), então um estágio não lê a saída de outro canal.
+ *
+ * Configuração por CMD_SET_EFFECT: `arg` = effectArg(estágio, parâmetro) e
+ * `value` o valor; `rampFrames` vale para gain, level e a frequência do
+ * mix (nos biquads a mudança é imediata). Trocar o tipo de um estágio o
+ * reinicia com os valores padrão; repetir o tipo atual não muda nada, então
+ * um parâmetro pode ser ajustado sem perder o estado do filtro. A primeira
+ * frequência de um mix recém-ligado vale na hora (a rampa partiria dos
+ * 1000 Hz padrão); só o nível sobe em rampa desde o silêncio.
+ *
+ * Tudo roda na thread que renderiza o canal e nada aloca depois do
+ * construtor.
+ */
+
+// Processador de um estágio
+enum EffectKind : uint32_t {
+  EFFECT_NONE,      ///< Estágio desligado
+  EFFECT_LOWPASS,   ///< Passa-baixas de 2ª ordem
+  EFFECT_HIGHPASS,  ///< Passa-altas de 2ª ordem
+  EFFECT_BANDPASS,  ///< Passa-faixa (0 dB no centro)
+  EFFECT_NOTCH,     ///< Rejeita-faixa
+  EFFECT_GAIN,      ///< Ganho linear
+  EFFECT_NOISE,     ///< Ruído branco somado
+  EFFECT_MIX,       ///< Segundo oscilador somado
+  EFFECT_KIND_COUNT
+};
+
+// Parâmetro endereçado por CMD_SET_EFFECT
+enum EffectParam : uint32_t {
+  FX_PARAM_KIND,       ///< value = EffectKind
+  FX_PARAM_FREQUENCY,  ///< Corte/centro do biquad ou frequência do mix (Hz)
+  FX_PARAM_Q,          ///< Fator de qualidade do biquad
+  FX_PARAM_GAIN,       ///< Ganho linear do estágio gain
+  FX_PARAM_LEVEL,      ///< Amplitude do ruído ou do oscilador do mix
+  FX_PARAM_COUNT
+};
+
+constexpr uint32_t MAX_EFFECT_STAGES = 4;  ///< Estágios por canal
+
+// Command::arg de um CMD_SET_EFFECT
+inline uint32_t effectArg(uint32_t stage, EffectParam param) {
+  return stage << 8 | param;
+}
+inline uint32_t effectStage(uint32_t arg) { return arg >> 8; }
+inline EffectParam effectParam(uint32_t arg) {
+  return static_cast<EffectParam>(arg & 0xFF);
+}
+
+// Estágio, parâmetro e tipo (se for o caso) dentro dos limites
+inline bool isValidEffectCommand(const Command& cmd) {
+  if (effectStage(cmd.arg) >= MAX_EFFECT_STAGES ||
+      effectParam(cmd.arg) >= FX_PARAM_COUNT || !std::isfinite(cmd.value)) {
+    return false;
+  }
+  return effectParam(cmd.arg) != FX_PARAM_KIND ||
+         (cmd.value >= 0.0 && cmd.value < EFFECT_KIND_COUNT);
+}
+
+constexpr const char* EFFECT_KIND_NAMES[EFFECT_KIND_COUNT] = {
+    "off",   "lowpass", "highpass", "bandpass",
+    "notch", "gain",    "noise",    "mix"};
+
+inline bool parseEffectKind(const char* name, EffectKind& kind) {
+  for (uint32_t k = 0; k < EFFECT_KIND_COUNT; ++k) {
+    if (strcmp(name, EFFECT_KIND_NAMES[k]) == 0) {
+      kind = static_cast<EffectKind>(k);
+      return true;
+    }
+  }
+  return false;
+}
+
+constexpr size_t MAX_EFFECT_COMMANDS = 3;  ///< Comandos de um "fx"
+
+/**
+ * @brief Monta os CMD_SET_EFFECT de "fx STAGE KIND valores" (controlador e
+ * scripts): o tipo seguido dos parâmetros, que precisam ir no mesmo frame.
+ *
+ * `values` são os números depois do tipo: nenhum em off, HZ [Q] nos
+ * biquads, VALUE [RAMP_MS] em gain e noise, HZ LEVEL [RAMP_MS] no mix. A
+ * rampa é convertida com `framesPerSecond`. Retorna quantos comandos foram
+ * escritos em `cmds` (até MAX_EFFECT_COMMANDS), ou 0 se os valores não
+ * servem para o tipo (inclusive rampa acima de MAX_RAMP_FRAMES); canal e
+ * instante ficam por conta de quem envia.
+ */
+inline size_t buildEffectCommands(uint32_t stage, EffectKind kind,
+                                  const std::vector<double>& values,
+                                  double framesPerSecond, Command* cmds) {
+  // Valores obrigatórios e opcionais de cada tipo
+  size_t required = kind == EFFECT_NONE ? 0 : kind == EFFECT_MIX ? 2 : 1;
+  size_t optional = kind == EFFECT_NONE ? 0 : 1;
+  if (stage >= MAX_EFFECT_STAGES || kind >= EFFECT_KIND_COUNT ||
+      values.size() < required || values.size() > required + optional) {
+    return 0;
+  }
+  for (double value : values) {
+    if (!std::isfinite(value) || value < 0.0) return 0;
+  }
+
+  bool biquad = kind >= EFFECT_LOWPASS && kind <= EFFECT_NOTCH;
+  uint32_t ramp = 0;
+  if (!biquad && values.size() > required) {
+    double frames = values.back() * framesPerSecond / 1000.0;
+    if (frames > MAX_RAMP_FRAMES) return 0;  // Não cabe em rampFrames
+    ramp = static_cast<uint32_t>(std::llround(frames));
+  }
+  size_t count = 0;
+  auto add = [&](EffectParam param, double value, uint32_t rampFrames) {
+    Command& cmd = cmds[count++];
+    cmd = Command(CMD_SET_EFFECT, value);
+    cmd.arg = effectArg(stage, param);
+    cmd.rampFrames = rampFrames;
+  };
+  add(FX_PARAM_KIND, kind, 0);
+  if (biquad) {
+    add(FX_PARAM_FREQUENCY, values[0], 0);
+    if (values.size() > 1) add(FX_PARAM_Q, values[1], 0);
+  } else if (kind == EFFECT_GAIN) {
+    add(FX_PARAM_GAIN, values[0], ramp);
+  } else if (kind == EFFECT_NOISE) {
+    add(FX_PARAM_LEVEL, values[0], ramp);
+  } else if (kind == EFFECT_MIX) {
+    add(FX_PARAM_FREQUENCY, values[0], ramp);
+    add(FX_PARAM_LEVEL, values[1], ramp);
+  }
+  return count;
+}
+
+/**
+ * @class EffectChain
+ * @brief Os estágios de efeito de um canal.
+ */
+class EffectChain {
+ public:
+  static constexpr double DEFAULT_FREQUENCY = 1000.0;  ///< Hz
+  static constexpr double DEFAULT_Q = M_SQRT1_2;       ///< Butterworth
+  static constexpr double MIN_Q = 0.1;
+  static constexpr double MAX_Q = 100.0;
+  static constexpr double MAX_GAIN = 16.0;  ///< ~+24 dB
+
+  explicit EffectChain(double sampleRate) : m_sampleRate(sampleRate) {
+    for (uint32_t s = 0; s < MAX_EFFECT_STAGES; ++s) {
+      Stage& stage = m_stages[s];
+      stage.source = std::make_unique<SineGenerator>(
+          sampleRate, DEFAULT_FREQUENCY, 0.0, SineGenerator::MODE_PHYSICAL);
+      stage.noiseState = 0x9E3779B97F4A7C15ULL * (s + 1);
+      reset(stage, EFFECT_NONE);
+    }
+  }
+
+  EffectChain(const EffectChain&) = delete;
+  EffectChain& operator=(const EffectChain&) = delete;
+
+  // Verdadeiro se algum estágio está ligado
+  bool active() const { return m_active > 0; }
+
+  EffectKind kind(uint32_t stage) const { return m_stages[stage].kind; }
+
+  // Aplica um CMD_SET_EFFECT já validado (isValidEffectCommand)
+  void apply(const Command& cmd) {
+    Stage& stage = m_stages[effectStage(cmd.arg)];
+    double value = cmd.value;
+    switch (effectParam(cmd.arg)) {
+      case FX_PARAM_KIND: {
+        EffectKind kind = static_cast<EffectKind>(value);
+        if (kind == stage.kind) return;
+        if (stage.kind != EFFECT_NONE) --m_active;
+        if (kind != EFFECT_NONE) ++m_active;
+        reset(stage, kind);
+        break;
+      }
+      case FX_PARAM_FREQUENCY:
+        stage.frequency = std::clamp(value, 1.0, 0.49 * m_sampleRate);
+        if (stage.kind == EFFECT_MIX) {
+          stage.source->rampParameter(PARAM_FREQUENCY, stage.frequency,
+                                      stage.tuned ? cmd.rampFrames : 0);
+          stage.tuned = true;
+        }
+        stage.biquad = designBiquad(stage);
+        break;
+      case FX_PARAM_Q:
+        stage.q = std::clamp(value, MIN_Q, MAX_Q);
+        stage.biquad = designBiquad(stage);
+        break;
+      case FX_PARAM_GAIN:
+        value = std::clamp(value, 0.0, MAX_GAIN);
+        stage.gainRamp.begin(stage.gain, value, cmd.rampFrames);
+        if (cmd.rampFrames == 0) stage.gain = value;
+        break;
+      case FX_PARAM_LEVEL:
+        value = std::clamp(value, 0.0, 1.0);
+        if (stage.kind == EFFECT_MIX) {
+          stage.source->rampParameter(PARAM_AMPLITUDE, value,
+                                      cmd.rampFrames);
+        }
+        stage.levelRamp.begin(stage.level, value, cmd.rampFrames);
+        if (cmd.rampFrames == 0) stage.level = value;
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Processa `count` amostras de `io` no lugar, estágio por estágio
+  void process(double* io, size_t count) {
+    if (m_active == 0 || count == 0) return;
+    for (Stage& stage : m_stages) {
+      switch (stage.kind) {
+        case EFFECT_LOWPASS:
+        case EFFECT_HIGHPASS:
+        case EFFECT_BANDPASS:
+        case EFFECT_NOTCH:
+          processBiquad(stage.biquad, io, count);
+          break;
+        case EFFECT_GAIN:
+          processGain(stage, io, count);
+          break;
+        case EFFECT_NOISE:
+          processNoise(stage, io, count);
+          break;
+        case EFFECT_MIX:
+          processMix(stage, io, count);
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t MIX_CHUNK = 256;  // Amostras do oscilador por vez
+
+  // Coeficientes normalizados (a0 = 1) e estado da forma direta II transposta
+  struct Biquad {
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    double z1 = 0.0, z2 = 0.0;
+  };
+
+  struct Stage {
+    EffectKind kind = EFFECT_NONE;
+    double frequency = DEFAULT_FREQUENCY;
+    double q = DEFAULT_Q;
+    double gain = 1.0;
+    double level = 0.0;
+    LinearRamp gainRamp;
+    LinearRamp levelRamp;
+    Biquad biquad;
+    std::unique_ptr<SineGenerator> source;  // Oscilador do mix
+    bool tuned = false;  // Mix já recebeu uma frequência desde o reset
+    uint64_t noiseState = 1;                // xorshift64 (nunca zero)
+  };
+
+  double m_sampleRate;
+  Stage m_stages[MAX_EFFECT_STAGES];
+  uint32_t m_active = 0;  // Estágios com kind != EFFECT_NONE
+
+  void reset(Stage& stage, EffectKind kind) {
+    stage.kind = kind;
+    stage.frequency = std::min(DEFAULT_FREQUENCY, 0.49 * m_sampleRate);
+    stage.q = DEFAULT_Q;
+    stage.gain = 1.0;
+    stage.level = 0.0;
+    stage.gainRamp.cancel();
+    stage.levelRamp.cancel();
+    stage.tuned = false;
+    stage.biquad = Biquad();
+    stage.biquad = designBiquad(stage);
+    stage.source->stop();
+    stage.source->setParameters(stage.frequency, 0.0);
+    stage.source->resetPhase();
+    if (kind == EFFECT_MIX) stage.source->start();
+  }
+
+  // Coeficientes do "Audio EQ Cookbook" (R. Bristow-Johnson). O estado do
+  // filtro é mantido: só reset() o zera, quando o tipo muda
+  Biquad designBiquad(const Stage& stage) const {
+    Biquad filter = stage.biquad;
+    double w0 = 2.0 * M_PI * stage.frequency / m_sampleRate;
+    double c = std::cos(w0);
+    double alpha = std::sin(w0) / (2.0 * stage.q);
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0;
+    switch (stage.kind) {
+      case EFFECT_LOWPASS:
+        b0 = b2 = 0.5 * (1.0 - c);
+        b1 = 1.0 - c;
+        break;
+      case EFFECT_HIGHPASS:
+        b0 = b2 = 0.5 * (1.0 + c);
+        b1 = -(1.0 + c);
+        break;
+      case EFFECT_BANDPASS:
+        b0 = alpha;
+        b2 = -alpha;
+        break;
+      case EFFECT_NOTCH:
+        b1 = -2.0 * c;
+        b2 = 1.0;
+        break;
+      default:
+        return Biquad();
+    }
+    double a0 = 1.0 + alpha;
+    filter.b0 = b0 / a0;
+    filter.b1 = b1 / a0;
+    filter.b2 = b2 / a0;
+    filter.a1 = -2.0 * c / a0;
+    filter.a2 = (1.0 - alpha) / a0;
+    return filter;
+  }
+
+  static void processBiquad(Biquad& f, double* io, size_t count) {
+    double z1 = f.z1, z2 = f.z2;
+    for (size_t i = 0; i < count; ++i) {
+      double x = io[i];
+      double y = f.b0 * x + z1;
+      z1 = f.b1 * x - f.a1 * y + z2;
+      z2 = f.b2 * x - f.a2 * y;
+      io[i] = y;
+    }
+    // Caudas que caem para subnormais deixariam o laço muito mais lento
+    f.z1 = std::fabs(z1) < 1e-30 ? 0.0 : z1;
+    f.z2 = std::fabs(z2) < 1e-30 ? 0.0 : z2;
+  }
+
+  static void processGain(Stage& stage, double* io, size_t count) {
+    size_t done = 0;
+    if (stage.gainRamp.active()) {
+      size_t n = stage.gainRamp.span(count);
+      double g = stage.gain, delta = stage.gainRamp.delta;
+      for (size_t i = 0; i < n; ++i) io[i] *= g + i * delta;
+      stage.gain = stage.gainRamp.advance(g, n);
+      done = n;
+    }
+    double g = stage.gain;
+    for (size_t i = done; i < count; ++i) io[i] *= g;
+  }
+
+  static void processNoise(Stage& stage, double* io, size_t count) {
+    double level = stage.level;
+    double delta = stage.levelRamp.delta;
+    size_t ramped = stage.levelRamp.span(count);
+    double settled = ramped ? stage.levelRamp.target : level;  // Após a rampa
+    if (level == 0.0 && settled == 0.0) return;
+    uint64_t s = stage.noiseState;
+    for (size_t i = 0; i < count; ++i) {
+      s ^= s << 13;
+      s ^= s >> 7;
+      s ^= s << 17;
+      double white = (s >> 11) * (2.0 / 9007199254740992.0) - 1.0;  // [-1, 1)
+      double a = i < ramped ? level + i * delta : settled;
+      io[i] += a * white;
+    }
+    stage.noiseState = s;
+    stage.level = ramped ? stage.levelRamp.advance(level, ramped) : level;
+  }
+
+  static void processMix(Stage& stage, double* io, size_t count) {
+    double scratch[MIX_CHUNK];
+    for (size_t done = 0; done < count;) {
+      size_t n = std::min(MIX_CHUNK, count - done);
+      stage.source->generateSamples(scratch, n);
+      for (size_t i = 0; i < n; ++i) io[done + i] += scratch[i];
+      done += n;
+    }
+  }
+};
+
+#endif  // EFFECT_CHAIN_HPP
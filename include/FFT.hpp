@@ -0,0 +1,79 @@
+#ifndef FFT_HPP
+#define FFT_HPP
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @class FFT
+ * @brief Transformada rápida de Fourier radix-2, in-place, de tamanho fixo.
+ *
+ * Fatores de giro (twiddles) e a permutação por bits invertidos são
+ * calculados uma vez no construtor; forward() não aloca nem chama funções
+ * trigonométricas, então pode rodar a cada quadro na taxa de amostragem.
+ * O tamanho precisa ser potência de 2 (ver isPowerOfTwo()).
+ */
+class FFT {
+ public:
+  static bool isPowerOfTwo(size_t n) { return n >= 2 && (n & (n - 1)) == 0; }
+
+  explicit FFT(size_t size) : m_size(size), m_twiddles(size / 2) {
+    for (size_t k = 0; k < size / 2; ++k) {
+      double angle = -2.0 * M_PI * static_cast<double>(k) / size;
+      m_twiddles[k] = std::complex<double>(cos(angle), sin(angle));
+    }
+
+    // Só os pares (i, j) com i < j: cada troca aparece uma vez
+    unsigned bits = 0;
+    while ((size_t{1} << bits) < size) ++bits;
+    for (size_t i = 0; i < size; ++i) {
+      size_t j = 0;
+      for (unsigned b = 0; b < bits; ++b) {
+        j |= ((i >> b) & 1) << (bits - 1 - b);
+      }
+      if (i < j) {
+        m_swaps.emplace_back(static_cast<uint32_t>(i),
+                             static_cast<uint32_t>(j));
+      }
+    }
+  }
+
+  size_t size() const { return m_size; }
+
+  // Transformada direta (sem normalização) de `data`, com size() pontos
+  void forward(std::complex<double>* data) const {
+    for (const auto& swap : m_swaps) {
+      std::swap(data[swap.first], data[swap.second]);
+    }
+
+    for (size_t length = 2; length <= m_size; length <<= 1) {
+      size_t half = length / 2;
+      size_t step = m_size / length;  // Passo na tabela de twiddles
+      for (size_t start = 0; start < m_size; start += length) {
+        std::complex<double>* a = data + start;
+        std::complex<double>* b = a + half;
+        for (size_t k = 0; k < half; ++k) {
+          // Produto complexo escrito à mão: o operador* padrão trata
+          // infinitos/NaN (Anexo G) e fica bem mais lento
+          const std::complex<double>& w = m_twiddles[k * step];
+          double re = b[k].real(), im = b[k].imag();
+          std::complex<double> t(re * w.real() - im * w.imag(),
+                                 re * w.imag() + im * w.real());
+          b[k] = a[k] - t;
+          a[k] += t;
+        }
+      }
+    }
+  }
+
+ private:
+  size_t m_size;
+  std::vector<std::complex<double>> m_twiddles;  // e^(-2πik/N), k < N/2
+  std::vector<std::pair<uint32_t, uint32_t>> m_swaps;  // Bits invertidos
+};
+
+#endif  // FFT_HPP
@@ -0,0 +1,456 @@
+#ifndef FILE_PLAYBACK_GENERATOR_HPP
+#define FILE_PLAYBACK_GENERATOR_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ISignalGenerator.hpp"
+#include "SampleFormat.hpp"
+#include "WavFormat.hpp"
+
+/**
+ * @class SampleFile
+ * @brief Arquivo de amostras intercaladas (WAV ou cru) mapeado somente
+ * leitura.
+ *
+ * O arquivo inteiro é mapeado com MADV_SEQUENTIAL: o kernel lê à frente e
+ * descarta o que ficou para trás, então reproduzir capturas de vários GB
+ * não custa nenhuma chamada de sistema por bloco nem ocupa memória própria.
+ * Imutável depois de aberto; vários geradores (um por canal) podem
+ * compartilhar a mesma instância.
+ */
+class SampleFile {
+ public:
+  // Formato assumido para arquivos sem cabeçalho
+  struct RawFormat {
+    SampleFormat format;
+    uint32_t channels;
+    double sampleRate;
+  };
+
+  /**
+   * @brief Mapeia `path`; arquivos terminados em ".wav" são interpretados
+   * pelo cabeçalho, os demais seguem `raw`.
+   *
+   * Retorna nullptr e preenche `error` em caso de falha.
+   */
+  static std::shared_ptr<const SampleFile> open(const std::string& path,
+                                                const RawFormat& raw,
+                                                const char*& error) {
+    error = nullptr;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      error = "Failed to open file";
+      return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+      close(fd);
+      error = "Empty or unreadable file";
+      return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+      error = "Failed to map file";
+      return nullptr;
+    }
+    madvise(address, size, MADV_SEQUENTIAL);
+
+    // Daqui em diante o destrutor desfaz o mapeamento
+    std::shared_ptr<SampleFile> file(new SampleFile(address, size));
+    const unsigned char* bytes = static_cast<const unsigned char*>(address);
+    bool wav = path.size() >= 4 &&
+               path.compare(path.size() - 4, 4, ".wav") == 0;
+    WavInfo info = {raw.format, raw.channels, raw.sampleRate, 0, size};
+    if (wav && !parseWavHeader(bytes, size, info, error)) return nullptr;
+    if (info.channels == 0 || info.sampleRate <= 0.0) {
+      error = "Invalid raw file format";
+      return nullptr;
+    }
+
+    file->m_format = info.format;
+    file->m_channels = info.channels;
+    file->m_sampleRate = info.sampleRate;
+    file->m_frameBytes = info.channels * sampleFormatSize(info.format);
+    file->m_samples = bytes + info.dataOffset;
+    file->m_frames = info.dataBytes / file->m_frameBytes;
+    if (file->m_frames == 0) {
+      error = "File has no complete frames";
+      return nullptr;
+    }
+    return file;
+  }
+
+  ~SampleFile() { munmap(m_address, m_size); }
+
+  SampleFile(const SampleFile&) = delete;
+  SampleFile& operator=(const SampleFile&) = delete;
+
+  SampleFormat format() const { return m_format; }
+  uint32_t channels() const { return m_channels; }
+  double sampleRate() const { return m_sampleRate; }
+  uint64_t frames() const { return m_frames; }
+  size_t frameBytes() const { return m_frameBytes; }
+
+  // Primeira amostra do canal `channel` no quadro `frame`
+  const unsigned char* sample(uint64_t frame, uint32_t channel) const {
+    return m_samples + frame * m_frameBytes +
+           channel * sampleFormatSize(m_format);
+  }
+
+  // Decodifica `count` quadros do canal `channel` a partir de `frame`
+  void decode(uint64_t frame, uint32_t channel, double* out,
+              size_t count) const {
+    decodeSamples(m_format, sample(frame, channel), out, count, m_frameBytes);
+  }
+
+  // Pede leitura antecipada a partir de `frame` (ex.: depois de um seek)
+  void prefetch(uint64_t frame, uint64_t count) const {
+    uintptr_t first = reinterpret_cast<uintptr_t>(sample(frame, 0));
+    uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = first & ~(page - 1);
+    uintptr_t end = std::min(
+        reinterpret_cast<uintptr_t>(sample(std::min(frame + count, m_frames),
+                                           0)),
+        reinterpret_cast<uintptr_t>(m_address) + m_size);
+    if (end > start) {
+      madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED);
+    }
+  }
+
+ private:
+  SampleFile(void* address, size_t size)
+      : m_address(address),
+        m_size(size),
+        m_format(FORMAT_F64),
+        m_channels(0),
+        m_sampleRate(0.0),
+        m_frameBytes(0),
+        m_samples(nullptr),
+        m_frames(0) {}
+
+  void* m_address;  // Mapeamento do arquivo inteiro
+  size_t m_size;
+  SampleFormat m_format;
+  uint32_t m_channels;
+  double m_sampleRate;
+  size_t m_frameBytes;               // Bytes por quadro (todos os canais)
+  const unsigned char* m_samples;    // Primeiro quadro
+  uint64_t m_frames;                 // Quadros completos no arquivo
+};
+
+/**
+ * @class FilePlaybackGenerator
+ * @brief Fonte de sinal que reproduz um canal de um SampleFile.
+ *
+ * Os blocos são decodificados direto do mapeamento. Com a taxa do arquivo
+ * igual à de saída (e velocidade 1) cada bloco é uma decodificação
+ * contínua; caso contrário a posição avança fileRate / outputRate * speed
+ * quadros por amostra, com interpolação cúbica de Hermite entre quadros
+ * (sem filtro anti-aliasing: reduzir muito a taxa aliasa o conteúdo
+ * agudo). Sem loop, a reprodução para no fim do arquivo (blocos parciais e
+ * depois 0 amostras); com loop ela volta ao início sem descontinuidade de
+ * posição.
+ *
+ * Parâmetros: "amplitude" (ganho 0..1), "speed" (0.01..16), "loop" (0/1),
+ * "position" (segundos; escrever faz seek), "channel" (canal do arquivo)
+ * e, textual, "filename". Todos podem ser alterados de qualquer thread e
+ * valem a partir do próximo bloco; abrir e mapear um arquivo acontece na
+ * thread que chama setParameter("filename", ...), nunca na de renderização.
+ * O munmap de um arquivo trocado também: ele só é solto numa troca
+ * seguinte, depois que a renderização já passou a usar outro.
+ */
+class FilePlaybackGenerator final : public ISignalGenerator {
+ public:
+  using FilePtr = std::shared_ptr<const SampleFile>;
+
+  static constexpr double MIN_SPEED = 0.01;  ///< Limite inferior de "speed"
+  static constexpr double MAX_SPEED = 16.0;  ///< Limite superior de "speed"
+
+  // `raw` descreve arquivos sem cabeçalho abertos por "filename"
+  FilePlaybackGenerator(double outputRate, const SampleFile::RawFormat& raw,
+                        FilePtr file = nullptr, uint32_t channel = 0,
+                        bool loop = false)
+      : m_outputRate(outputRate),
+        m_raw(raw),
+        m_file(std::move(file)),
+        m_published(m_file.get()),
+        m_inUse(nullptr),
+        m_running(false),
+        m_gain(1.0),
+        m_speed(1.0),
+        m_loop(loop),
+        m_channel(channel),
+        m_seekFrame(NO_SEEK),
+        m_positionSeconds(0.0),
+        m_current(nullptr),
+        m_frame(0),
+        m_fraction(0.0),
+        m_scratch(SCRATCH_FRAMES) {}
+
+  void start() override { m_running = true; }
+  void stop() override { m_running = false; }
+
+  size_t generateSamples(double* out, size_t count) override {
+    if (!m_running) return 0;
+
+    // Arquivo novo recomeça do início. Esta thread não guarda referências:
+    // o arquivo marcado em m_inUse fica vivo na thread de controle até o
+    // bloco seguinte usar outro (ver retireFiles)
+    const SampleFile* file = acquireFile();
+    if (!file) return 0;
+    if (file != m_current) {
+      m_current = file;
+      m_frame = 0;
+      m_fraction = 0.0;
+    }
+    uint64_t seek = m_seekFrame.exchange(NO_SEEK);
+    if (seek != NO_SEEK) {
+      m_frame = std::min(seek, file->frames());
+      m_fraction = 0.0;
+    }
+
+    uint32_t channel = std::min(m_channel.load(), file->channels() - 1);
+    double step =
+        std::min(file->sampleRate() / m_outputRate * m_speed, MAX_STEP);
+    bool loop = m_loop;
+    size_t produced = step == 1.0 && m_fraction == 0.0
+                          ? playDirect(*file, channel, out, count, loop)
+                          : resample(*file, channel, step, out, count, loop);
+
+    double gain = m_gain;
+    for (size_t i = 0; i < produced; ++i) out[i] *= gain;
+    m_positionSeconds.store((m_frame + m_fraction) / file->sampleRate(),
+                            std::memory_order_relaxed);
+    return produced;
+  }
+
+  using ISignalGenerator::generateSamples;
+  using ISignalGenerator::getParameter;
+  using ISignalGenerator::rampParameter;
+  using ISignalGenerator::setParameter;
+
+  void setParameter(ParameterId id, double value) override {
+    switch (id) {
+      case PARAM_AMPLITUDE:
+        m_gain = std::clamp(value, 0.0, 1.0);
+        break;
+      case PARAM_SPEED:
+        m_speed = std::clamp(value, MIN_SPEED, MAX_SPEED);
+        break;
+      case PARAM_LOOP:
+        m_loop = value >= 0.5;
+        break;
+      case PARAM_CHANNEL:
+        m_channel = static_cast<uint32_t>(std::max(value, 0.0));
+        break;
+      case PARAM_POSITION: {
+        FilePtr file = std::atomic_load(&m_file);
+        if (!file) return;
+        uint64_t frame = static_cast<uint64_t>(
+            std::max(value, 0.0) * file->sampleRate());
+        frame = std::min(frame, file->frames());
+        file->prefetch(frame, static_cast<uint64_t>(file->sampleRate()));
+        m_seekFrame = frame;
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  // "filename": mapeia o arquivo aqui e o entrega à renderização
+  bool setParameter(const std::string& name, const std::string& value,
+                    const char*& error) override {
+    if (name != "filename") {
+      return ISignalGenerator::setParameter(name, value, error);
+    }
+    FilePtr file = SampleFile::open(value, m_raw, error);
+    if (!file) return false;
+
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    m_retired.push_back(std::atomic_exchange(&m_file, file));
+    m_published.store(file.get());
+    retireFiles();
+    return true;
+  }
+
+  double getParameter(ParameterId id) const override {
+    switch (id) {
+      case PARAM_AMPLITUDE:
+        return m_gain;
+      case PARAM_SPEED:
+        return m_speed;
+      case PARAM_LOOP:
+        return m_loop ? 1.0 : 0.0;
+      case PARAM_CHANNEL:
+        return m_channel;
+      case PARAM_POSITION:
+        return m_positionSeconds.load(std::memory_order_relaxed);
+      case PARAM_DURATION: {
+        FilePtr file = std::atomic_load(&m_file);
+        return file ? file->frames() / file->sampleRate() : 0.0;
+      }
+      case PARAM_SAMPLE_RATE: {
+        FilePtr file = std::atomic_load(&m_file);
+        return file ? file->sampleRate() : 0.0;
+      }
+      default:
+        return 0.0;
+    }
+  }
+
+  bool isRunning() const { return m_running; }
+
+ private:
+  static constexpr uint64_t NO_SEEK = UINT64_MAX;
+  static constexpr size_t SCRATCH_FRAMES = 4096;  // Quadros decodificados
+  static constexpr double MAX_STEP = 256.0;  // Quadros do arquivo por amostra
+
+  double m_outputRate;             // Taxa de saída em Hz
+  SampleFile::RawFormat m_raw;     // Formato de arquivos crus
+  FilePtr m_file;                  // Acesso via std::atomic_load/store
+  std::atomic<const SampleFile*> m_published;  // m_file, para a renderização
+  std::atomic<const SampleFile*> m_inUse;  // Arquivo do bloco em andamento
+  std::vector<FilePtr> m_retired;  // Trocados, talvez ainda em uso
+  std::mutex m_controlMutex;       // Serializa trocas de arquivo
+  std::atomic<bool> m_running;
+  std::atomic<double> m_gain;
+  std::atomic<double> m_speed;
+  std::atomic<bool> m_loop;
+  std::atomic<uint32_t> m_channel;
+  std::atomic<uint64_t> m_seekFrame;  // Seek pendente (NO_SEEK = nenhum)
+  std::atomic<double> m_positionSeconds;  // Publicado a cada bloco
+
+  // Estado da renderização (só a thread de renderização toca)
+  const SampleFile* m_current;  // Arquivo do bloco anterior
+  uint64_t m_frame;             // Posição inteira no arquivo, em quadros
+  double m_fraction;            // Posição fracionária [0, 1)
+  std::vector<double> m_scratch;  // Quadros decodificados para interpolar
+
+  /**
+   * Arquivo do bloco atual, anunciado em m_inUse antes do uso. A releitura
+   * de m_published fecha a corrida com uma troca: ou a thread de controle
+   * já vê o anúncio, ou esta thread vê o arquivo novo e anuncia de novo.
+   */
+  const SampleFile* acquireFile() {
+    const SampleFile* file = m_published.load();
+    while (true) {
+      m_inUse.store(file);
+      const SampleFile* latest = m_published.load();
+      if (latest == file) return file;
+      file = latest;
+    }
+  }
+
+  // Solta os arquivos trocados que a renderização não usa mais; o munmap
+  // acontece aqui, na thread de controle (chamada com m_controlMutex)
+  void retireFiles() {
+    const SampleFile* inUse = m_inUse.load();
+    m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(),
+                                   [&](const FilePtr& file) {
+                                     return !file || file.get() != inUse;
+                                   }),
+                    m_retired.end());
+  }
+
+  // Taxas iguais: decodifica trechos contíguos do mapeamento
+  size_t playDirect(const SampleFile& file, uint32_t channel, double* out,
+                    size_t count, bool loop) {
+    size_t done = 0;
+    while (done < count) {
+      if (m_frame >= file.frames()) {
+        if (!loop) break;
+        m_frame = 0;
+      }
+      size_t n = static_cast<size_t>(
+          std::min<uint64_t>(count - done, file.frames() - m_frame));
+      file.decode(m_frame, channel, out + done, n);
+      m_frame += n;
+      done += n;
+    }
+    return done;
+  }
+
+  // Decodifica quadros [first, first + count) em m_scratch; fora do arquivo
+  // é silêncio ou, com loop, a continuação circular
+  void fill(const SampleFile& file, uint32_t channel, int64_t first,
+            size_t count, bool loop) {
+    int64_t frames = static_cast<int64_t>(file.frames());
+    size_t done = 0;
+    while (done < count) {
+      int64_t frame = first + static_cast<int64_t>(done);
+      if (loop) frame = ((frame % frames) + frames) % frames;
+      size_t n;
+      if (frame < 0 || frame >= frames) {
+        n = frame < 0 ? std::min<size_t>(count - done, -frame) : count - done;
+        std::fill_n(m_scratch.begin() + done, n, 0.0);
+      } else {
+        n = static_cast<size_t>(
+            std::min<int64_t>(count - done, frames - frame));
+        file.decode(static_cast<uint64_t>(frame), channel,
+                    m_scratch.data() + done, n);
+      }
+      done += n;
+    }
+  }
+
+  // Taxas diferentes: Hermite de 4 pontos sobre trechos de m_scratch
+  size_t resample(const SampleFile& file, uint32_t channel, double step,
+                  double* out, size_t count, bool loop) {
+    uint64_t frames = file.frames();
+    size_t done = 0;
+    while (done < count) {
+      if (m_frame >= frames) {
+        if (!loop) break;
+        m_frame %= frames;
+      }
+      // Saídas que cabem em m_scratch (mais 3 quadros de vizinhança) e, sem
+      // loop, que ainda caem dentro do arquivo
+      size_t n = std::min(
+          count - done,
+          static_cast<size_t>((SCRATCH_FRAMES - 4 - m_fraction) / step) + 1);
+      if (!loop) {
+        double left = (frames - m_frame - m_fraction) / step;
+        n = std::min(n, static_cast<size_t>(std::ceil(left)));
+      }
+      double span = m_fraction + (n - 1) * step;
+      fill(file, channel, static_cast<int64_t>(m_frame) - 1,
+           static_cast<size_t>(span) + 4, loop);
+
+      const double* x = m_scratch.data();
+      for (size_t i = 0; i < n; ++i) {
+        double position = m_fraction + i * step;
+        size_t k = static_cast<size_t>(position);
+        double t = position - k;
+        double xm1 = x[k], x0 = x[k + 1], x1 = x[k + 2], x2 = x[k + 3];
+        double c1 = 0.5 * (x1 - xm1);
+        double c2 = xm1 - 2.5 * x0 + 2.0 * x1 - 0.5 * x2;
+        double c3 = 0.5 * (x2 - xm1) + 1.5 * (x0 - x1);
+        out[done + i] = ((c3 * t + c2) * t + c1) * t + x0;
+      }
+
+      double advance = m_fraction + n * step;
+      uint64_t whole = static_cast<uint64_t>(advance);
+      m_frame += whole;
+      m_fraction = advance - whole;
+      done += n;
+    }
+    return done;
+  }
+};
+
+#endif  // FILE_PLAYBACK_GENERATOR_HPP
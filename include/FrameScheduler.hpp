@@ -0,0 +1,125 @@
+#ifndef FRAME_SCHEDULER_HPP
+#define FRAME_SCHEDULER_HPP
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdint>
+
+/**
+ * @file FrameScheduler.hpp
+ * @brief Relógio de quadros com prazos absolutos sobre timerfd.
+ *
+ * O quadro n vence em origin + n * interval (CLOCK_MONOTONIC, armado com
+ * TFD_TIMER_ABSTIME): um atraso ao acordar não empurra os prazos seguintes,
+ * então a taxa média de quadros é exata em execuções de horas. Expirações
+ * acumuladas (o processo ficou sem CPU) viram quadros pendentes que o
+ * chamador renderiza em sequência, até maxCatchUp por disparo; acima disso
+ * os quadros excedentes não são renderizados e ficam em skipped(), sem
+ * rajadas ilimitadas. O chamador ainda deve avançar o relógio de amostras
+ * por eles (o gerador publica silêncio com RingWriter::skip) para que ele
+ * continue acompanhando os prazos.
+ *
+ * O descritor é exposto via fd() para entrar no poll() do laço principal.
+ */
+class FrameScheduler {
+ public:
+  FrameScheduler(int64_t intervalNs, uint64_t maxCatchUp)
+      : m_fd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+        m_intervalNs(intervalNs),
+        m_maxCatchUp(maxCatchUp),
+        m_skipped(0) {}
+
+  ~FrameScheduler() {
+    if (m_fd >= 0) close(m_fd);
+  }
+
+  FrameScheduler(const FrameScheduler&) = delete;
+  FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+  bool isValid() const { return m_fd >= 0; }
+  int fd() const { return m_fd; }
+
+  // Ancora os prazos em agora: o primeiro quadro vence daqui a um intervalo
+  void start() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    int64_t first = toNs(now) + m_intervalNs;
+    struct itimerspec spec = {};
+    spec.it_value = fromNs(first);
+    spec.it_interval = fromNs(m_intervalNs);
+    timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+  }
+
+  // Desarma o timer; o processo só acorda com outros eventos
+  void stop() {
+    struct itimerspec spec = {};
+    timerfd_settime(m_fd, 0, &spec, nullptr);
+  }
+
+  /**
+   * @brief Consome as expirações pendentes e retorna quantos quadros
+   * renderizar agora (0 se o timer não disparou, no máximo maxCatchUp).
+   */
+  uint64_t framesDue() {
+    uint64_t expirations = 0;
+    if (read(m_fd, &expirations, sizeof(expirations)) !=
+        static_cast<ssize_t>(sizeof(expirations))) {
+      return 0;
+    }
+    if (expirations > m_maxCatchUp) {
+      m_skipped += expirations - m_maxCatchUp;
+      expirations = m_maxCatchUp;
+    }
+    return expirations;
+  }
+
+  // Quadros descartados por atrasos além do limite de recuperação
+  uint64_t skipped() const { return m_skipped; }
+
+ private:
+  int m_fd;               // timerfd (CLOCK_MONOTONIC)
+  int64_t m_intervalNs;   // Período dos quadros
+  uint64_t m_maxCatchUp;  // Máximo de quadros recuperados por disparo
+  uint64_t m_skipped;     // Total de quadros descartados
+
+  static int64_t toNs(const struct timespec& ts) {
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+  }
+  static struct timespec fromNs(int64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000LL);
+    return ts;
+  }
+};
+
+/**
+ * @brief Coloca o processo em SCHED_FIFO com `priority` e trava toda a
+ * memória atual e futura (mlockall), evitando preempção por tarefas comuns
+ * e page faults no caminho quente.
+ *
+ * Requer CAP_SYS_NICE / CAP_IPC_LOCK (ou limites RLIMIT_RTPRIO/MEMLOCK
+ * adequados). Em caso de falha retorna false e aponta `error` para o passo
+ * que falhou; o que já foi aplicado permanece.
+ */
+inline bool enableRealtime(int priority, const char*& error) {
+  error = nullptr;
+  struct sched_param param = {};
+  param.sched_priority = priority;
+  if (sched_setscheduler(0, SCHED_FIFO, &param) < 0) {
+    error = "Failed to enable SCHED_FIFO (missing CAP_SYS_NICE?)";
+    return false;
+  }
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+    error = "Failed to lock memory (missing CAP_IPC_LOCK?)";
+    return false;
+  }
+  return true;
+}
+
+#endif  // FRAME_SCHEDULER_HPP
@@ -0,0 +1,46 @@
+#ifndef FUTEX_HPP
+#define FUTEX_HPP
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @file Futex.hpp
+ * @brief Espera/notificação entre processos sobre uma palavra de 32 bits em
+ * memória compartilhada.
+ *
+ * Usa as variantes não-privadas do futex (a palavra vive num segmento
+ * mapeado por processos diferentes). FUTEX_WAIT funciona também sobre
+ * mapeamentos somente leitura, então consumidores não precisam de escrita.
+ */
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "Palavra do futex precisa ter exatamente 32 bits");
+
+/**
+ * @brief Dorme enquanto `*word == expected`, por no máximo `timeoutMs`.
+ *
+ * Retorna imediatamente se o valor já mudou. Wakeups espúrios são
+ * possíveis; o chamador sempre deve reavaliar sua condição.
+ */
+inline void futexWait(const std::atomic<uint32_t>* word, uint32_t expected,
+                      int timeoutMs) {
+  struct timespec timeout;
+  timeout.tv_sec = timeoutMs / 1000;
+  timeout.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000000L;
+  syscall(SYS_futex, reinterpret_cast<const uint32_t*>(word), FUTEX_WAIT,
+          expected, &timeout, nullptr, 0);
+}
+
+// Acorda todos os processos/threads esperando em `word`.
+inline void futexWakeAll(std::atomic<uint32_t>* word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE,
+          INT32_MAX, nullptr, nullptr, 0);
+}
+
+#endif  // FUTEX_HPP
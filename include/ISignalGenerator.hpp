@@ -5,18 +5,107 @@
 #include <string>
 #include <vector>
 
-// Interface genérica para qualquer fonte de sinal (gerador sintético, leitor de
-// arquivo, stream, etc.)
+// Parâmetros numéricos conhecidos. Cada fonte aceita um subconjunto e
+// ignora os demais; o nome textual de cada um está em PARAMETER_NAMES.
+enum ParameterId {
+  PARAM_FREQUENCY,      ///< "frequency" (Hz)
+  PARAM_AMPLITUDE,      ///< "amplitude" (0.0 a 1.0)
+  PARAM_PHASE,          ///< "phase" (radianos)
+  PARAM_MODE,           ///< "mode" (0 = visual, 1 = físico)
+  PARAM_WAVEFORM,       ///< "waveform" (valor de Waveform)
+  PARAM_INTERPOLATION,  ///< "interpolation" (0 = linear, 1 = cúbica)
+  PARAM_SPEED,          ///< "speed" (fator de velocidade)
+  PARAM_LOOP,           ///< "loop" (0/1)
+  PARAM_POSITION,       ///< "position" (segundos)
+  PARAM_CHANNEL,        ///< "channel" (canal do arquivo)
+  PARAM_DURATION,       ///< "duration" (segundos, somente leitura)
+  PARAM_SAMPLE_RATE,    ///< "sample_rate" (Hz, somente leitura)
+  PARAM_COUNT,
+  PARAM_UNKNOWN = PARAM_COUNT  ///< Nome sem identificador
+};
+
+constexpr const char* PARAMETER_NAMES[PARAM_COUNT] = {
+    "frequency", "amplitude", "phase", "mode", "waveform",
+    "interpolation", "speed", "loop", "position", "channel",
+    "duration", "sample_rate"};
+
+// Identificador do parâmetro `name` (PARAM_UNKNOWN se não existe)
+inline ParameterId parameterId(const std::string& name) {
+  for (int id = 0; id < PARAM_COUNT; ++id) {
+    if (name == PARAMETER_NAMES[id]) return static_cast<ParameterId>(id);
+  }
+  return PARAM_UNKNOWN;
+}
+
+/**
+ * Interface genérica para qualquer fonte de sinal (gerador sintético, leitor
+ * de arquivo, stream, etc.)
+ *
+ * Parâmetros numéricos são endereçados por ParameterId: as fontes tratam o
+ * identificador num switch, sem comparar strings. As sobrecargas por nome
+ * são só adaptadores (uma busca em PARAMETER_NAMES) para quem trabalha com
+ * texto, como linhas de comando e plugins.
+ *
+ * Fontes concretas são `final`: quem guarda o tipo concreto (ex.:
+ * BasicChannelEngine<SineGenerator>) chama generateSamples() e os
+ * parâmetros sem despacho virtual, e o compilador pode expandir o bloco
+ * inteiro no lugar da chamada.
+ */
 class ISignalGenerator {
  public:
   ISignalGenerator() = default;
   virtual ~ISignalGenerator() = default;
 
-  // Gera e retorna um bloco de `count` amostras.
-  virtual std::vector<double> generateSamples(size_t count) = 0;
+  // Gera até `count` amostras diretamente em `out` (memória do chamador, sem
+  // alocação). Retorna quantas foram escritas; 0 se o gerador estiver parado.
+  virtual size_t generateSamples(double* out, size_t count) = 0;
+
+  // Conveniência: gera e retorna um bloco de `count` amostras. Aloca a cada
+  // chamada; caminhos quentes devem usar a sobrecarga acima.
+  std::vector<double> generateSamples(size_t count) {
+    std::vector<double> samples(count);
+    samples.resize(generateSamples(samples.data(), count));
+    return samples;
+  }
+
+  // Define um parâmetro numérico (desconhecidos são ignorados).
+  virtual void setParameter(ParameterId id, double value) = 0;
+
+  // Por nome (ex.: "frequency", "amplitude").
+  void setParameter(const std::string& name, double value) {
+    ParameterId id = parameterId(name);
+    if (id != PARAM_UNKNOWN) setParameter(id, value);
+  }
+
+  // Parâmetro textual (ex.: "filename"). Retorna false e preenche `error`
+  // se a fonte não o reconhece ou o valor é inválido.
+  virtual bool setParameter(const std::string& name, const std::string& value,
+                            const char*& error) {
+    (void)name;
+    (void)value;
+    error = "Unknown parameter";
+    return false;
+  }
+
+  // Valor atual de um parâmetro (0.0 se desconhecido).
+  virtual double getParameter(ParameterId id) const = 0;
+
+  double getParameter(const std::string& name) const {
+    ParameterId id = parameterId(name);
+    return id != PARAM_UNKNOWN ? getParameter(id) : 0.0;
+  }
+
+  // Leva um parâmetro até `value` linearmente ao longo de `frames` amostras.
+  // Por padrão (fontes sem rampas) é um degrau imediato.
+  virtual void rampParameter(ParameterId id, double value, size_t frames) {
+    (void)frames;
+    setParameter(id, value);
+  }
 
-  // Define um parâmetro nomeado (ex.: "frequency", "amplitude", "filename").
-  virtual void setParameter(const std::string& name, double value) = 0;
+  void rampParameter(const std::string& name, double value, size_t frames) {
+    ParameterId id = parameterId(name);
+    if (id != PARAM_UNKNOWN) rampParameter(id, value, frames);
+  }
 
   virtual void start() = 0;
   virtual void stop() = 0;
@@ -0,0 +1,136 @@
+#ifndef JITTER_BUFFER_HPP
+#define JITTER_BUFFER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class JitterBuffer
+ * @brief Reordena quadros recebidos pela rede e os entrega com atraso fixo.
+ *
+ * Os quadros são guardados pelo índice absoluto do emissor numa janela
+ * circular de `capacity` quadros (potência de 2). Um quadro só é entregue
+ * quando o mais novo já recebido está `delay` quadros à frente dele: pacotes
+ * atrasados ou fora de ordem dentro desse intervalo entram no lugar certo, e
+ * o que não chegou até lá vira silêncio (contado em missing()). Pacotes que
+ * chegam depois de sua vez são descartados (late()).
+ *
+ * Como a entrega segue os índices do emissor, o receptor anda no relógio do
+ * emissor: não há deriva entre máquinas, só o atraso configurado.
+ */
+class JitterBuffer {
+ public:
+  JitterBuffer(uint32_t channels, size_t capacity, uint64_t delay)
+      : m_channels(channels),
+        m_mask(capacity - 1),
+        m_delay(std::min<uint64_t>(delay, capacity / 2)),
+        m_samples(capacity * channels, 0.0),
+        m_present(capacity, 0),
+        m_started(false),
+        m_cursor(0),
+        m_newest(0),
+        m_late(0),
+        m_missing(0) {}
+
+  // Esquece tudo; o próximo insert() define o início do fluxo
+  void reset() {
+    std::fill(m_present.begin(), m_present.end(), 0);
+    m_started = false;
+    m_cursor = m_newest = 0;
+  }
+
+  /**
+   * @brief Guarda `frames` quadros intercalados a partir do índice `first`.
+   *
+   * Um salto maior que a janela (perda longa) descarta o intervalo mais
+   * antigo como silêncio antes de guardar os quadros novos.
+   */
+  void insert(uint64_t first, const double* interleaved, size_t frames) {
+    uint64_t end = first + frames;
+    if (!m_started) {
+      m_started = true;
+      m_cursor = m_newest = first;
+    }
+    if (end <= m_cursor) {
+      m_late += frames;
+      return;
+    }
+    if (first < m_cursor) {
+      size_t skipped = static_cast<size_t>(m_cursor - first);
+      m_late += skipped;
+      interleaved += skipped * m_channels;
+      frames -= skipped;
+      first = m_cursor;
+    }
+    if (end - m_cursor > m_present.size()) {
+      uint64_t start = end - m_present.size();
+      for (uint64_t f = m_cursor; f < std::min(start, m_newest); ++f) {
+        m_present[f & m_mask] = 0;
+      }
+      m_missing += start - m_cursor;
+      m_cursor = start;
+      m_newest = std::max(m_newest, start);
+      if (first < start) {
+        size_t skipped = static_cast<size_t>(start - first);
+        interleaved += skipped * m_channels;
+        frames -= skipped;
+        first = start;
+      }
+    }
+
+    for (size_t i = 0; i < frames; ++i) {
+      size_t slot = static_cast<size_t>((first + i) & m_mask);
+      std::copy_n(interleaved + i * m_channels, m_channels,
+                  m_samples.begin() + slot * m_channels);
+      m_present[slot] = 1;
+    }
+    m_newest = std::max(m_newest, end);
+  }
+
+  // Quadros que já cumpriram o atraso
+  size_t ready() const {
+    uint64_t limit = m_newest > m_delay ? m_newest - m_delay : 0;
+    return limit > m_cursor ? static_cast<size_t>(limit - m_cursor) : 0;
+  }
+
+  // Quadros recebidos ou pulados ainda não entregues (inclui o atraso)
+  size_t pending() const { return static_cast<size_t>(m_newest - m_cursor); }
+
+  /**
+   * @brief Entrega os próximos `frames` quadros em `planar` (canal c em
+   * planar[c * frames, (c + 1) * frames)), com silêncio nos que faltam.
+   */
+  void pop(double* planar, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+      size_t slot = static_cast<size_t>((m_cursor + i) & m_mask);
+      bool present = m_present[slot] != 0;
+      const double* frame = m_samples.data() + slot * m_channels;
+      for (uint32_t c = 0; c < m_channels; ++c) {
+        planar[c * frames + i] = present ? frame[c] : 0.0;
+      }
+      if (!present) ++m_missing;
+      m_present[slot] = 0;
+    }
+    m_cursor += frames;
+    m_newest = std::max(m_newest, m_cursor);
+  }
+
+  uint64_t late() const { return m_late; }
+  uint64_t missing() const { return m_missing; }
+
+ private:
+  uint32_t m_channels;
+  uint64_t m_mask;                 // capacity - 1
+  uint64_t m_delay;                // Atraso de entrega em quadros
+  std::vector<double> m_samples;   // Janela circular, intercalada
+  std::vector<uint8_t> m_present;  // Quadro recebido em cada slot
+  bool m_started;
+  uint64_t m_cursor;   // Próximo quadro a entregar
+  uint64_t m_newest;   // Fim (exclusivo) do quadro mais novo recebido
+  uint64_t m_late;     // Quadros que chegaram depois de entregues
+  uint64_t m_missing;  // Quadros entregues como silêncio
+};
+
+#endif  // JITTER_BUFFER_HPP
@@ -0,0 +1,104 @@
+#ifndef NET_STREAM_HPP
+#define NET_STREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "SampleFormat.hpp"
+
+/**
+ * @file NetStream.hpp
+ * @brief Formato dos pacotes UDP do netbridge: RTP (RFC 3550) com payload
+ * dinâmico carregando quadros do anel.
+ *
+ * Cada datagrama é:
+ *
+ *   [0, 12)   cabeçalho RTP fixo (big-endian): V=2, PT=NET_PAYLOAD_TYPE,
+ *             sequência de 16 bits, timestamp = relógio de amostras (32 bits
+ *             baixos do índice do primeiro quadro), SSRC do emissor
+ *   [12, 44)  StreamHeader (little-endian): layout do fluxo e o índice de
+ *             64 bits do primeiro quadro, que o timestamp RTP só carrega
+ *             módulo 2^32
+ *   [44, ...) `frames` quadros intercalados no formato `format`,
+ *             exatamente como nos slots do anel
+ *
+ * Todo pacote descreve o fluxo inteiro, então um receptor pode entrar a
+ * qualquer momento e perdas não exigem renegociação.
+ */
+
+constexpr uint8_t NET_PAYLOAD_TYPE = 96;      ///< Primeiro PT dinâmico
+constexpr uint32_t NET_MAGIC = 0x54454E53;    ///< "SNET" em little-endian
+constexpr uint16_t NET_VERSION = 1;           ///< Versão do StreamHeader
+constexpr size_t RTP_HEADER_BYTES = 12;
+constexpr size_t NET_DEFAULT_PAYLOAD = 1400;  ///< Cabe num MTU Ethernet
+
+// Layout do fluxo e posição do pacote, logo após o cabeçalho RTP
+struct StreamHeader {
+  uint32_t magic;       ///< NET_MAGIC
+  uint16_t version;     ///< NET_VERSION
+  uint16_t channels;    ///< Canais por quadro
+  uint32_t format;      ///< SampleFormat das amostras
+  uint32_t frames;      ///< Quadros neste pacote
+  double sampleRate;    ///< Hz do emissor
+  uint64_t firstFrame;  ///< Índice absoluto do primeiro quadro
+};
+static_assert(sizeof(StreamHeader) == 32, "StreamHeader precisa de 32 bytes");
+
+constexpr size_t NET_HEADER_BYTES = RTP_HEADER_BYTES + sizeof(StreamHeader);
+
+// Campos do cabeçalho RTP usados pelo receptor
+struct RtpHeader {
+  bool marker;         ///< Primeiro pacote do fluxo
+  uint16_t sequence;
+  uint32_t timestamp;
+  uint32_t ssrc;
+};
+
+// Escreve os cabeçalhos RTP e StreamHeader em `out` (NET_HEADER_BYTES)
+inline void buildNetHeader(unsigned char* out, const RtpHeader& rtp,
+                           const StreamHeader& stream) {
+  out[0] = 0x80;  // V=2, sem padding, extensão ou CSRC
+  out[1] = static_cast<unsigned char>((rtp.marker ? 0x80 : 0) |
+                                      NET_PAYLOAD_TYPE);
+  out[2] = static_cast<unsigned char>(rtp.sequence >> 8);
+  out[3] = static_cast<unsigned char>(rtp.sequence);
+  for (int i = 0; i < 4; ++i) {
+    out[4 + i] = static_cast<unsigned char>(rtp.timestamp >> (24 - 8 * i));
+    out[8 + i] = static_cast<unsigned char>(rtp.ssrc >> (24 - 8 * i));
+  }
+  memcpy(out + RTP_HEADER_BYTES, &stream, sizeof(stream));
+}
+
+/**
+ * @brief Valida um datagrama recebido e extrai seus cabeçalhos.
+ *
+ * Retorna false para qualquer pacote que não seja deste protocolo ou cujo
+ * tamanho não corresponda aos quadros anunciados.
+ */
+inline bool parseNetPacket(const unsigned char* data, size_t size,
+                           RtpHeader& rtp, StreamHeader& stream) {
+  if (size < NET_HEADER_BYTES || (data[0] & 0xC0) != 0x80 ||
+      (data[1] & 0x7F) != NET_PAYLOAD_TYPE) {
+    return false;
+  }
+  rtp.marker = (data[1] & 0x80) != 0;
+  rtp.sequence = static_cast<uint16_t>(data[2] << 8 | data[3]);
+  rtp.timestamp = 0;
+  rtp.ssrc = 0;
+  for (int i = 0; i < 4; ++i) {
+    rtp.timestamp = rtp.timestamp << 8 | data[4 + i];
+    rtp.ssrc = rtp.ssrc << 8 | data[8 + i];
+  }
+  memcpy(&stream, data + RTP_HEADER_BYTES, sizeof(stream));
+  if (stream.magic != NET_MAGIC || stream.version != NET_VERSION ||
+      stream.channels == 0 || stream.format > FORMAT_S24 ||
+      stream.sampleRate <= 0.0) {
+    return false;
+  }
+  SampleFormat format = static_cast<SampleFormat>(stream.format);
+  size_t frameBytes = stream.channels * sampleFormatSize(format);
+  return size == NET_HEADER_BYTES + stream.frames * frameBytes;
+}
+
+#endif  // NET_STREAM_HPP
@@ -0,0 +1,152 @@
+#ifndef OSCILLATOR_CONTROL_HPP
+#define OSCILLATOR_CONTROL_HPP
+
+#include <cstdint>
+
+#include "ParameterRamp.hpp"
+#include "SeqLock.hpp"
+
+/**
+ * @struct OscillatorParams
+ * @brief Bloco de parâmetros publicado pelo controle e lido pelo áudio.
+ *
+ * Os contadores `*Edits` avançam a cada escrita do controle: é por eles (e
+ * não pela comparação de valores) que o caminho de áudio sabe que um
+ * parâmetro foi sobrescrito e que a rampa correspondente deve parar.
+ */
+struct OscillatorParams {
+  double frequency;         ///< Hz
+  double amplitude;         ///< 0.0 a 1.0
+  double phase;             ///< Última fase pedida (radianos)
+  uint32_t frequencyEdits;  ///< Escritas de frequência pelo controle
+  uint32_t amplitudeEdits;  ///< Escritas de amplitude pelo controle
+  uint32_t phaseEdits;      ///< Pedidos de fase ainda não vistos pelo áudio
+  uint32_t reserved;
+};
+
+// Valores que o áudio usa em um bloco
+struct OscillatorSnapshot {
+  double frequency;
+  double amplitude;
+  double phase;       ///< Válido se phaseChanged
+  bool phaseChanged;  ///< O controle pediu uma nova fase desde o último bloco
+};
+
+/**
+ * @class OscillatorControl
+ * @brief Parâmetros de oscilador compartilhados entre controle e áudio.
+ *
+ * Lado do controle (qualquer thread, sem locks): setFrequency(),
+ * setAmplitude(), setPhase() e set(), que publica frequência e amplitude
+ * juntas. Lado do áudio (só a thread que renderiza): acquire() uma vez por
+ * bloco, rampas via frequencyRamp()/amplitudeRamp() e beginFrequencyRamp()/
+ * beginAmplitudeRamp(), e publish() para devolver o progresso das rampas.
+ *
+ * O progresso das rampas nunca sobrescreve uma escrita do controle: se o
+ * controle escreveu um parâmetro durante o bloco, publish() mantém o valor
+ * dele e o próximo acquire() cancela a rampa.
+ */
+class OscillatorControl {
+ public:
+  OscillatorControl(double frequency, double amplitude)
+      : m_params(OscillatorParams{frequency, amplitude, 0.0, 0, 0, 0, 0}),
+        m_frequencyEdits(0),
+        m_amplitudeEdits(0),
+        m_phaseEdits(0) {}
+
+  // --- Controle ---
+
+  void setFrequency(double frequency) {
+    m_params.update([&](OscillatorParams& p) {
+      p.frequency = frequency;
+      ++p.frequencyEdits;
+    });
+  }
+
+  void setAmplitude(double amplitude) {
+    m_params.update([&](OscillatorParams& p) {
+      p.amplitude = amplitude;
+      ++p.amplitudeEdits;
+    });
+  }
+
+  // Frequência e amplitude aplicadas no mesmo bloco
+  void set(double frequency, double amplitude) {
+    m_params.update([&](OscillatorParams& p) {
+      p.frequency = frequency;
+      p.amplitude = amplitude;
+      ++p.frequencyEdits;
+      ++p.amplitudeEdits;
+    });
+  }
+
+  void setPhase(double phase) {
+    m_params.update([&](OscillatorParams& p) {
+      p.phase = phase;
+      ++p.phaseEdits;
+    });
+  }
+
+  // Cópia coerente dos valores atuais
+  OscillatorParams load() const { return m_params.load(); }
+
+  // --- Áudio ---
+
+  // Snapshot para o próximo bloco; cancela rampas sobrescritas pelo controle
+  OscillatorSnapshot acquire() {
+    OscillatorParams p = m_params.load();
+    if (p.frequencyEdits != m_frequencyEdits) {
+      m_frequencyRamp.cancel();
+      m_frequencyEdits = p.frequencyEdits;
+    }
+    if (p.amplitudeEdits != m_amplitudeEdits) {
+      m_amplitudeRamp.cancel();
+      m_amplitudeEdits = p.amplitudeEdits;
+    }
+    bool phaseChanged = p.phaseEdits != m_phaseEdits;
+    m_phaseEdits = p.phaseEdits;
+    return {p.frequency, p.amplitude, p.phase, phaseChanged};
+  }
+
+  LinearRamp& frequencyRamp() { return m_frequencyRamp; }
+  LinearRamp& amplitudeRamp() { return m_amplitudeRamp; }
+
+  bool rampActive() const {
+    return m_frequencyRamp.active() || m_amplitudeRamp.active();
+  }
+
+  /**
+   * @brief Inicia uma rampa de frequência a partir de `from` (o valor atual,
+   * já limitado pelo chamador) até `to`.
+   *
+   * Escritas de frequência pendentes são consideradas vistas: a rampa parte
+   * delas, então o próximo acquire() não deve cancelá-la.
+   */
+  void beginFrequencyRamp(double from, double to, size_t frames) {
+    m_frequencyEdits = m_params.load().frequencyEdits;
+    m_frequencyRamp.begin(from, to, frames);
+  }
+
+  void beginAmplitudeRamp(double from, double to, size_t frames) {
+    m_amplitudeEdits = m_params.load().amplitudeEdits;
+    m_amplitudeRamp.begin(from, to, frames);
+  }
+
+  // Devolve o progresso das rampas ao fim do bloco
+  void publish(double frequency, double amplitude) {
+    m_params.update([&](OscillatorParams& p) {
+      if (p.frequencyEdits == m_frequencyEdits) p.frequency = frequency;
+      if (p.amplitudeEdits == m_amplitudeEdits) p.amplitude = amplitude;
+    });
+  }
+
+ private:
+  SeqLock<OscillatorParams> m_params;
+  LinearRamp m_frequencyRamp;  // Rampa de frequência em curso (só áudio)
+  LinearRamp m_amplitudeRamp;  // Rampa de amplitude em curso (só áudio)
+  uint32_t m_frequencyEdits;   // Último frequencyEdits visto pelo áudio
+  uint32_t m_amplitudeEdits;   // Último amplitudeEdits visto pelo áudio
+  uint32_t m_phaseEdits;       // Último phaseEdits visto pelo áudio
+};
+
+#endif  // OSCILLATOR_CONTROL_HPP
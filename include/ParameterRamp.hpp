@@ -0,0 +1,42 @@
+#ifndef PARAMETER_RAMP_HPP
+#define PARAMETER_RAMP_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+/**
+ * @struct LinearRamp
+ * @brief Rampa linear de um parâmetro contínuo, amostra a amostra.
+ *
+ * O valor da amostra i (a partir do início do trecho corrente) é
+ * `current + i * delta`; ao fim da rampa o valor é fixado exatamente em
+ * `target`, sem acumular erro de arredondamento.
+ */
+struct LinearRamp {
+  double target = 0.0;   ///< Valor final
+  double delta = 0.0;    ///< Incremento por amostra
+  size_t remaining = 0;  ///< Amostras até chegar em `target`
+
+  bool active() const { return remaining > 0; }
+
+  // Inicia uma rampa de `current` até `to` em `frames` amostras
+  void begin(double current, double to, size_t frames) {
+    target = to;
+    remaining = frames;
+    delta = frames ? (to - current) / frames : 0.0;
+  }
+
+  void cancel() { remaining = 0; }
+
+  // Amostras do próximo trecho de até `count` que a rampa ainda cobre
+  size_t span(size_t count) const { return std::min(count, remaining); }
+
+  // Avança `n` amostras a partir de `current` e retorna o novo valor
+  double advance(double current, size_t n) {
+    n = std::min(n, remaining);
+    remaining -= n;
+    return remaining ? current + n * delta : target;
+  }
+};
+
+#endif  // PARAMETER_RAMP_HPP
@@ -0,0 +1,232 @@
+#ifndef RENDER_POOL_HPP
+#define RENDER_POOL_HPP
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "AllocationGuard.hpp"
+#include "Communication.hpp"
+#include "Futex.hpp"
+
+/**
+ * @file RenderPool.hpp
+ * @brief Pool fixo de threads que executa as tarefas de um quadro em
+ * paralelo (parallel-for com roubo de trabalho).
+ *
+ * run(tasks, fn) divide os índices [0, tasks) em faixas contíguas, uma por
+ * participante (os workers e a própria thread chamadora). Cada um consome a
+ * sua faixa com fetch_add e, ao terminar, rouba índices das faixas dos
+ * outros; canais mais caros (rampas, interpolação cúbica) ou um worker
+ * preemptado não seguram o quadro. run() só retorna depois que todos os
+ * participantes saíram do quadro, então as tarefas podem usar o estado do
+ * chamador por referência.
+ *
+ * Entre quadros os workers dormem num futex (sem spin contínuo); com
+ * `pinned` cada participante fica preso a um núcleo diferente. Depois de
+ * armAllocationGuard(), cada worker arma o guarda de alocações da própria
+ * thread no início do quadro seguinte (ver AllocationGuard.hpp).
+ */
+class RenderPool {
+ public:
+  /**
+   * @brief Cria `threads - 1` workers (a chamadora de run() é o participante
+   * 0). Com `pinned`, o participante i fica no núcleo i % núcleos online;
+   * a afinidade da chamadora é aplicada aqui, então o pool deve ser criado
+   * pela thread que vai chamar run().
+   *
+   * Os workers herdam a política de escalonamento da thread criadora (ex.:
+   * SCHED_FIFO de enableRealtime) e nascem com todos os sinais bloqueados.
+   */
+  explicit RenderPool(unsigned threads, bool pinned = false)
+      : m_slots(new Slot[threads ? threads : 1]),
+        m_participants(threads ? threads : 1),
+        m_generation(0),
+        m_finished(0),
+        m_stopping(false),
+        m_armGuard(false),
+        m_pinFailures(0),
+        m_invoke(nullptr),
+        m_context(nullptr) {
+    if (pinned && !pinToCore(0)) ++m_pinFailures;
+
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    for (unsigned i = 1; i < m_participants; ++i) {
+      m_workers.emplace_back([this, i, pinned]() {
+        if (pinned && !pinToCore(i)) m_pinFailures.fetch_add(1);
+        checkOut();
+        workerLoop(i);
+      });
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+    // Só retorna com todos os workers prontos (e pinFailures() completo)
+    waitWorkers();
+  }
+
+  ~RenderPool() {
+    m_stopping.store(true, std::memory_order_release);
+    m_generation.fetch_add(1, std::memory_order_release);
+    futexWakeAll(&m_generation);
+    for (std::thread& worker : m_workers) worker.join();
+  }
+
+  RenderPool(const RenderPool&) = delete;
+  RenderPool& operator=(const RenderPool&) = delete;
+
+  // Participantes (workers + thread chamadora)
+  unsigned threads() const { return m_participants; }
+
+  // Participantes que não conseguiram fixar a afinidade pedida
+  unsigned pinFailures() const { return m_pinFailures.load(); }
+
+  // Os workers passam a abortar se alocarem (chamado quando a thread
+  // chamadora arma o próprio guarda; sem SINE_ALLOC_GUARD não faz nada)
+  void armAllocationGuard() {
+    if (ALLOCATION_GUARD_ENABLED &&
+        !m_armGuard.load(std::memory_order_relaxed)) {
+      m_armGuard.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Executa fn(i) para todo i em [0, tasks) e espera todas terminarem.
+   *
+   * fn precisa ser segura para índices diferentes em paralelo. Não é
+   * reentrante: só uma thread chama run(), um quadro por vez.
+   */
+  template <typename Fn>
+  void run(size_t tasks, Fn& fn) {
+    if (m_participants == 1 || tasks <= 1) {
+      for (size_t i = 0; i < tasks; ++i) fn(i);
+      return;
+    }
+
+    // Faixa contígua de cada participante (as primeiras ficam com o resto)
+    size_t share = tasks / m_participants, extra = tasks % m_participants;
+    size_t begin = 0;
+    for (unsigned p = 0; p < m_participants; ++p) {
+      size_t end = begin + share + (p < extra ? 1 : 0);
+      m_slots[p].next.store(begin, std::memory_order_relaxed);
+      m_slots[p].end.store(end, std::memory_order_relaxed);
+      begin = end;
+    }
+    m_invoke = [](void* context, size_t i) { (*static_cast<Fn*>(context))(i); };
+    m_context = &fn;
+
+    // Publica o quadro (release: faixas e função visíveis aos workers)
+    m_generation.fetch_add(1, std::memory_order_release);
+    futexWakeAll(&m_generation);
+
+    work(0);
+
+    // Junta: espera todos os workers saírem do quadro
+    waitWorkers();
+  }
+
+ private:
+  static constexpr int SPIN_ITERATIONS = 2000;  // Antes de dormir no futex
+  static constexpr int WAIT_TIMEOUT_MS = 100;   // Reavaliação periódica
+
+  // Faixa de índices de um participante; uma linha de cache cada
+  struct alignas(CACHE_LINE_SIZE) Slot {
+    std::atomic<size_t> next{0};  // Próximo índice a tomar (pode passar de end)
+    std::atomic<size_t> end{0};   // Fim da faixa (exclusivo)
+  };
+
+  std::unique_ptr<Slot[]> m_slots;
+  unsigned m_participants;
+  std::vector<std::thread> m_workers;
+  std::atomic<uint32_t> m_generation;  // Quadro atual (palavra de futex)
+  std::atomic<uint32_t> m_finished;    // Workers que saíram do quadro
+  std::atomic<bool> m_stopping;
+  std::atomic<bool> m_armGuard;  // Workers devem armar o guarda de alocações
+  std::atomic<unsigned> m_pinFailures;
+  void (*m_invoke)(void*, size_t);  // Chama a fn de run() com um índice
+  void* m_context;                  // A fn de run()
+
+  static bool pinToCore(unsigned participant) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(participant % static_cast<unsigned>(cores), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+  }
+
+  // Worker sinaliza que terminou a etapa atual (partida ou quadro)
+  void checkOut() {
+    m_finished.fetch_add(1, std::memory_order_release);
+    futexWakeAll(&m_finished);
+  }
+
+  // Espera todos os workers fazerem checkOut() e zera o contador
+  void waitWorkers() {
+    uint32_t workers = m_participants - 1;
+    uint32_t finished;
+    for (int spin = 0; spin < SPIN_ITERATIONS; ++spin) {
+      if (m_finished.load(std::memory_order_acquire) == workers) break;
+    }
+    while ((finished = m_finished.load(std::memory_order_acquire)) !=
+           workers) {
+      futexWait(&m_finished, finished, WAIT_TIMEOUT_MS);
+    }
+    m_finished.store(0, std::memory_order_relaxed);
+  }
+
+  // Toma um índice da faixa `p`; false se ela se esgotou
+  bool take(unsigned p, size_t& index) {
+    Slot& slot = m_slots[p];
+    if (slot.next.load(std::memory_order_relaxed) >=
+        slot.end.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    index = slot.next.fetch_add(1, std::memory_order_relaxed);
+    return index < slot.end.load(std::memory_order_relaxed);
+  }
+
+  // Consome a própria faixa e depois rouba das outras, em ordem circular
+  void work(unsigned self) {
+    size_t index;
+    for (unsigned k = 0; k < m_participants; ++k) {
+      unsigned victim = (self + k) % m_participants;
+      while (take(victim, index)) m_invoke(m_context, index);
+    }
+  }
+
+  void workerLoop(unsigned self) {
+    uint32_t seen = 0;
+    bool armed = false;  // Guarda de alocações desta thread já armado
+    while (true) {
+      uint32_t generation;
+      while ((generation = m_generation.load(std::memory_order_acquire)) ==
+             seen) {
+        futexWait(&m_generation, seen, WAIT_TIMEOUT_MS);
+      }
+      seen = generation;
+      if (m_stopping.load(std::memory_order_acquire)) {
+        allocationGuardDisarm();  // A saída da thread pode alocar
+        return;
+      }
+
+      if (!armed && m_armGuard.load(std::memory_order_relaxed)) {
+        allocationGuardArm();
+        armed = true;
+      }
+      work(self);
+      checkOut();
+    }
+  }
+};
+
+#endif  // RENDER_POOL_HPP
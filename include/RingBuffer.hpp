@@ -0,0 +1,402 @@
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "Communication.hpp"
+#include "Futex.hpp"
+
+/**
+ * @file RingBuffer.hpp
+ * @brief Lados produtor e consumidor do anel de difusão sobre SharedBuffer.
+ *
+ * Ver a documentação de SharedBuffer para a ordem de memória e a política de
+ * overrun. O produtor guarda uma cópia local de head; cada consumidor guarda
+ * seu cursor apenas na própria memória, nunca no segmento compartilhado.
+ * Todas as contagens são em quadros (uma amostra por canal).
+ */
+
+// Codifica `count` quadros no índice lógico `pos`. A entrada é planar: o
+// canal c começa em `in + c * inStride`. O wrap é tratado com no máximo dois
+// trechos contíguos por canal.
+inline void ringCopyIn(SharedBuffer* buffer, uint64_t pos, const double* in,
+                       size_t inStride, size_t count, Dither& dither) {
+  SampleFormat format = buffer->sampleFormat;
+  size_t stride = buffer->frameStride();
+  size_t first = pos & buffer->mask();
+  size_t n1 = std::min(count, static_cast<size_t>(buffer->capacity - first));
+
+  for (uint32_t c = 0; c < buffer->channels; ++c) {
+    const double* src = in + c * inStride;
+    encodeSamples(format, src, buffer->slot(first, c), n1, dither, stride);
+    encodeSamples(format, src + n1, buffer->slot(0, c), count - n1, dither,
+                  stride);
+  }
+}
+
+// Decodifica `count` quadros a partir de `pos`. Com `channel` ==
+// ALL_CHANNELS a saída é intercalada (`channels` doubles por quadro); caso
+// contrário contém apenas o canal pedido, contíguo.
+inline void ringCopyOut(const SharedBuffer* buffer, uint64_t pos,
+                        int32_t channel, double* out, size_t count) {
+  SampleFormat format = buffer->sampleFormat;
+  uint32_t channels = buffer->channels;
+  size_t stride = buffer->frameStride();
+  size_t first = pos & buffer->mask();
+  size_t n1 = std::min(count, static_cast<size_t>(buffer->capacity - first));
+  size_t n2 = count - n1;
+
+  if (channel != ALL_CHANNELS) {
+    decodeSamples(format, buffer->slot(first, channel), out, n1, stride);
+    decodeSamples(format, buffer->slot(0, channel), out + n1, n2, stride);
+  } else if (buffer->channelLayout == LAYOUT_INTERLEAVED) {
+    // Os slots já estão na ordem da saída: decodificação contígua
+    decodeSamples(format, buffer->slot(first, 0), out, n1 * channels);
+    decodeSamples(format, buffer->slot(0, 0), out + n1 * channels,
+                  n2 * channels);
+  } else {
+    for (uint32_t c = 0; c < channels; ++c) {
+      decodeSamples(format, buffer->slot(first, c), out + c, n1, stride,
+                    channels);
+      decodeSamples(format, buffer->slot(0, c), out + n1 * channels + c, n2,
+                    stride, channels);
+    }
+  }
+}
+
+// Zera `count` quadros a partir de `pos` (silêncio: zero em todo formato)
+inline void ringZero(SharedBuffer* buffer, uint64_t pos, size_t count) {
+  bool planar = buffer->channelLayout == LAYOUT_PLANAR;
+  uint32_t planes = planar ? buffer->channels : 1;
+  size_t width = buffer->frameStride();  // Bytes por quadro em cada plano
+  size_t first = pos & buffer->mask();
+  size_t n1 = std::min(count, static_cast<size_t>(buffer->capacity - first));
+
+  for (uint32_t p = 0; p < planes; ++p) {
+    memset(buffer->slot(first, p), 0, n1 * width);
+    memset(buffer->slot(0, p), 0, (count - n1) * width);
+  }
+}
+
+/**
+ * @struct RingRegion
+ * @brief Trecho contíguo de uma reserva: quadros [0, frames) do canal c
+ * ficam em planes[c * planeStride + i], direto nos slots do anel.
+ */
+struct RingRegion {
+  double* planes;      ///< Primeiro quadro do canal 0
+  size_t planeStride;  ///< Distância entre canais (a capacidade do anel)
+  size_t frames;       ///< Quadros no trecho
+};
+
+/**
+ * @class RingWriter
+ * @brief Lado produtor: publica blocos de quadros sem nunca bloquear.
+ *
+ * Dois caminhos: write() converte um bloco planar do chamador para o
+ * formato do anel; reserve()/commit() entregam os próprios slots para o
+ * chamador gerar no lugar, sem bloco intermediário, quando o anel guarda
+ * exatamente o que os geradores produzem (supportsInPlace()).
+ */
+class RingWriter {
+ public:
+  explicit RingWriter(SharedBuffer* buffer, bool dither = true)
+      : m_buffer(buffer),
+        m_capacity(buffer->capacity),
+        m_head(buffer->head.load(std::memory_order_relaxed)),
+        m_reserved(0),
+        m_dither(dither) {}
+
+  /**
+   * @brief Publica um bloco de `frames` quadros no anel.
+   *
+   * `data` é planar: o canal c ocupa data[c * frames, (c + 1) * frames). Com
+   * um único canal isso é simplesmente o vetor de amostras.
+   *
+   * 1. Publica `claim` e emite um fence release: a reserva fica visível
+   *    antes de qualquer slot ser sobrescrito.
+   * 2. Converte o bloco para o formato do anel direto nos slots (no máximo
+   *    dois trechos contíguos; inteiros recebem dither TPDF).
+   * 3. Publica `head` com release: o bloco inteiro fica visível de uma vez.
+   * 4. Incrementa `frameSeq` e acorda os consumidores bloqueados nele (a
+   *    syscall só acontece se frameWaiters() indicar alguém dormindo).
+   */
+  void write(const double* data, size_t frames) {
+    if (frames == 0) return;
+    size_t planeStride = frames;
+
+    // Um bloco maior que o anel só preserva seus últimos m_capacity quadros
+    if (frames > m_capacity) {
+      size_t skipped = frames - m_capacity;
+      data += skipped;
+      m_head += skipped;
+      frames = m_capacity;
+    }
+
+    uint64_t end = m_head + frames;
+
+    m_buffer->claim.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    ringCopyIn(m_buffer, m_head, data, planeStride, frames, m_dither);
+    publish(end);
+  }
+
+  // Slots em double planar: cada canal é um vetor contíguo (até o wrap)
+  bool supportsInPlace() const {
+    return m_buffer->sampleFormat == FORMAT_F64 &&
+           m_buffer->channelLayout == LAYOUT_PLANAR;
+  }
+
+  /**
+   * @brief Reserva os próximos `frames` quadros (1..capacidade) para escrita
+   * no lugar e retorna em quantos trechos eles ficaram (2 se cruzam o fim
+   * do anel). Requer supportsInPlace().
+   *
+   * `claim` é publicado aqui, antes de o chamador tocar nos slots, como no
+   * passo 1 de write(); os quadros só ficam visíveis em commit(). Cada
+   * quadro reservado precisa ser escrito (silêncio inclusive).
+   */
+  size_t reserve(size_t frames, RingRegion regions[2]) {
+    m_reserved = static_cast<size_t>(
+        std::min<uint64_t>(frames, m_capacity));
+    m_buffer->claim.store(m_head + m_reserved, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t first = static_cast<size_t>(m_head & m_buffer->mask());
+    size_t n1 = std::min(m_reserved, static_cast<size_t>(m_capacity - first));
+    size_t stride = static_cast<size_t>(m_capacity);
+    regions[0] = {reinterpret_cast<double*>(m_buffer->slot(first, 0)), stride,
+                  n1};
+    regions[1] = {reinterpret_cast<double*>(m_buffer->slot(0, 0)), stride,
+                  m_reserved - n1};
+    return regions[1].frames > 0 ? 2 : 1;
+  }
+
+  // Publica a reserva inteira de uma vez (passos 3 e 4 de write())
+  void commit() {
+    publish(m_head + m_reserved);
+    m_reserved = 0;
+  }
+
+  /**
+   * @brief Avança o relógio de amostras em `frames` quadros de silêncio,
+   * numa única publicação (ex.: prazos perdidos depois de um travamento).
+   *
+   * Só os últimos min(frames, capacidade) slots são zerados; claim cobre o
+   * salto inteiro, então um leitor que estava nos quadros pulados vê a
+   * perda normalmente (ver política de overrun em SharedBuffer).
+   */
+  void skip(uint64_t frames) {
+    if (frames == 0) return;
+    uint64_t end = m_head + frames;
+    uint64_t silent = std::min(frames, m_capacity);
+
+    m_buffer->claim.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    ringZero(m_buffer, end - silent, static_cast<size_t>(silent));
+    publish(end);
+  }
+
+  uint64_t head() const { return m_head; }
+
+ private:
+  SharedBuffer* m_buffer;
+  uint64_t m_capacity;  // Capacidade do anel (lida do cabeçalho)
+  uint64_t m_head;      // Cópia local de head (único escritor)
+  size_t m_reserved;    // Quadros da reserva em aberto (0 = nenhuma)
+  Dither m_dither;  // Estado do dither para formatos inteiros
+
+  void publish(uint64_t end) {
+    m_head = end;
+    m_buffer->head.store(m_head, std::memory_order_release);
+
+    // seq_cst nos dois lados: ou o leitor vê o frameSeq novo e não dorme,
+    // ou este load vê o leitor que se contou (ver waitForData)
+    m_buffer->frameSeq.fetch_add(1, std::memory_order_seq_cst);
+    if (m_buffer->frameWaiters().load(std::memory_order_seq_cst) != 0) {
+      futexWakeAll(&m_buffer->frameSeq);
+    }
+  }
+};
+
+/**
+ * @class RingReader
+ * @brief Lado consumidor: cursor privado sobre o anel de difusão.
+ *
+ * Qualquer número de leitores pode existir ao mesmo tempo (em threads ou
+ * processos distintos); nenhum deles escreve no anel. Com setTelemetry(), o
+ * leitor publica cursor, amostras lidas e perdas no seu ConsumerSlot a cada
+ * leitura.
+ *
+ * Um gerador que reinicia reaproveitando o segmento continua head de onde
+ * parou, então o cursor segue válido e os quadros da execução anterior
+ * ainda não lidos continuam sendo entregues; a troca de `epoch` só é
+ * contada em restarts(), para o consumidor tratar a descontinuidade do
+ * sinal. Um segmento aposentado (retired()) nunca mais recebe quadros: o
+ * consumidor deve liberá-lo e conectar de novo.
+ */
+class RingReader {
+ public:
+  // Ponto de partida do cursor ao conectar
+  enum StartPosition {
+    START_LATEST,  ///< Apenas quadros publicados a partir de agora
+    START_OLDEST   ///< Tudo o que ainda está no anel
+  };
+
+  explicit RingReader(const SharedBuffer* buffer,
+                      StartPosition start = START_LATEST)
+      : m_buffer(buffer),
+        m_capacity(buffer->capacity),
+        m_tail(0),
+        m_lost(0),
+        m_overruns(0),
+        m_epoch(buffer->epoch.load(std::memory_order_acquire)),
+        m_restarts(0),
+        m_slot(nullptr) {
+    uint64_t head = buffer->head.load(std::memory_order_acquire);
+    if (start == START_LATEST) {
+      m_tail = head;
+    } else if (head > m_capacity) {
+      m_tail = head - m_capacity;
+    }
+  }
+
+  // Quadros publicados e ainda não lidos (pode exceder a capacidade)
+  uint64_t available() const {
+    return m_buffer->head.load(std::memory_order_acquire) - m_tail;
+  }
+
+  /**
+   * @brief Bloqueia até haver quadros novos ou até `timeoutMs` expirar.
+   *
+   * O leitor se conta em frameWaiters() e só então lê frameSeq e checa
+   * head: se o produtor publicar depois disso, o valor esperado já estará
+   * desatualizado e o futex retorna na hora; se publicar antes, ele já vê o
+   * contador e faz o wake. Nenhuma notificação é perdida. Um leitor que
+   * morre dormindo deixa o contador alto, o que só custa wakes a mais.
+   */
+  bool waitForData(int timeoutMs) const {
+    if (available() > 0) return true;
+    std::atomic<uint32_t>& waiters = m_buffer->frameWaiters();
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t seq = m_buffer->frameSeq.load(std::memory_order_seq_cst);
+    if (available() == 0) futexWait(&m_buffer->frameSeq, seq, timeoutMs);
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+    return available() > 0;
+  }
+
+  /**
+   * @brief Lê até `maxFrames` quadros, dos mais antigos para os mais novos.
+   *
+   * A saída é intercalada: `channels()` doubles por quadro. Após a cópia, um
+   * fence acquire seguido da leitura de `claim` revela se o produtor começou
+   * a sobrescrever algum slot copiado; esse trecho inicial é descartado e
+   * contabilizado em lost(). Retorna quantos quadros válidos foram escritos
+   * em `out`.
+   */
+  size_t read(double* out, size_t maxFrames) {
+    return readFrames(ALL_CHANNELS, out, maxFrames);
+  }
+
+  // Como read(), mas só o canal `channel` (< channels()), contíguo
+  size_t readChannel(uint32_t channel, double* out, size_t maxFrames) {
+    return readFrames(static_cast<int32_t>(channel), out, maxFrames);
+  }
+
+  uint32_t channels() const { return m_buffer->channels; }
+  uint64_t tail() const { return m_tail; }
+  uint64_t lost() const { return m_lost; }
+
+  // Reinícios do produtor observados por este leitor
+  uint32_t restarts() const { return m_restarts; }
+
+  // O nome do segmento passou a outro de layout diferente (ver SharedBuffer)
+  bool retired() const {
+    return m_buffer->magic.load(std::memory_order_acquire) != SHM_MAGIC;
+  }
+
+  // Slot de telemetria deste leitor (ver registerConsumer); nullptr desliga
+  void setTelemetry(ConsumerSlot* slot) {
+    m_slot = slot;
+    if (m_slot) m_slot->tail.store(m_tail, std::memory_order_relaxed);
+  }
+
+ private:
+  const SharedBuffer* m_buffer;
+  uint64_t m_capacity;  // Capacidade do anel (lida do cabeçalho)
+  uint64_t m_tail;  // Cursor privado: próximo quadro a ler
+  uint64_t m_lost;  // Quadros perdidos por overrun observados por este leitor
+  uint64_t m_overruns;   // Leituras que encontraram perda
+  uint32_t m_epoch;      // Última execução do produtor observada
+  uint32_t m_restarts;   // Trocas de execução observadas
+  ConsumerSlot* m_slot;  // Telemetria (opcional, só este leitor escreve)
+
+  size_t readFrames(int32_t channel, double* out, size_t maxFrames) {
+    uint64_t lostBefore = m_lost;
+    size_t n = copyFrames(channel, out, maxFrames);
+    if (m_lost != lostBefore) ++m_overruns;
+    if (m_slot && (n > 0 || m_lost != lostBefore)) {
+      size_t width = channel == ALL_CHANNELS ? m_buffer->channels : 1;
+      uint64_t consumed = m_slot->samplesConsumed.load(
+          std::memory_order_relaxed);
+      m_slot->samplesConsumed.store(consumed + n * width,
+                                    std::memory_order_relaxed);
+      m_slot->tail.store(m_tail, std::memory_order_relaxed);
+      m_slot->framesLost.store(m_lost, std::memory_order_relaxed);
+      m_slot->overruns.store(m_overruns, std::memory_order_relaxed);
+      m_slot->updatedNs.store(monotonicNs(), std::memory_order_relaxed);
+    }
+    return n;
+  }
+
+  size_t copyFrames(int32_t channel, double* out, size_t maxFrames) {
+    uint64_t head = m_buffer->head.load(std::memory_order_acquire);
+
+    uint32_t epoch = m_buffer->epoch.load(std::memory_order_relaxed);
+    if (epoch != m_epoch) {
+      m_restarts += epoch - m_epoch;
+      m_epoch = epoch;
+    }
+
+    // Atraso maior que o anel: pula direto para o quadro mais antigo válido
+    if (head - m_tail > m_capacity) {
+      m_lost += head - m_capacity - m_tail;
+      m_tail = head - m_capacity;
+    }
+
+    size_t n = static_cast<size_t>(
+        std::min<uint64_t>(head - m_tail, static_cast<uint64_t>(maxFrames)));
+    if (n == 0) return 0;
+
+    ringCopyOut(m_buffer, m_tail, channel, out, n);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t claim = m_buffer->claim.load(std::memory_order_relaxed);
+    uint64_t end = m_tail + n;
+
+    // Slots com índice < firstValid podem ter sido sobrescritos na cópia
+    uint64_t firstValid = claim > m_capacity ? claim - m_capacity : 0;
+    if (firstValid > m_tail) {
+      m_lost += firstValid - m_tail;
+      if (firstValid >= end) {
+        n = 0;
+        end = firstValid;
+      } else {
+        size_t width = channel == ALL_CHANNELS ? m_buffer->channels : 1;
+        size_t torn = static_cast<size_t>(firstValid - m_tail);
+        memmove(out, out + torn * width, (n - torn) * width * sizeof(double));
+        n -= torn;
+      }
+    }
+
+    m_tail = end;
+    return n;
+  }
+};
+
+#endif  // RING_BUFFER_HPP
@@ -0,0 +1,208 @@
+#ifndef SAMPLE_FORMAT_HPP
+#define SAMPLE_FORMAT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @file SampleFormat.hpp
+ * @brief Formatos de amostra do anel compartilhado e conversões de/para
+ * double.
+ *
+ * O produtor sintetiza em double e converte uma única vez ao publicar; os
+ * consumidores decodificam de volta para double (ou usam os bytes crus, caso
+ * de sinks que já esperam o formato). Formatos inteiros usam escala simétrica
+ * (±1.0 → ±(2^(N-1) - 1)) com saturação; int24 é empacotado em 3 bytes
+ * little-endian.
+ */
+
+enum SampleFormat : uint32_t {
+  FORMAT_F64,  ///< double (sem conversão)
+  FORMAT_F32,  ///< float IEEE-754
+  FORMAT_S16,  ///< inteiro de 16 bits com sinal
+  FORMAT_S24   ///< inteiro de 24 bits com sinal, empacotado
+};
+
+constexpr size_t MAX_SAMPLE_BYTES = sizeof(double);  ///< Maior slot possível
+
+constexpr double S16_SCALE = 32767.0;    ///< Fundo de escala de int16
+constexpr double S24_SCALE = 8388607.0;  ///< Fundo de escala de int24
+
+// Bytes ocupados por uma amostra no formato
+inline size_t sampleFormatSize(SampleFormat format) {
+  switch (format) {
+    case FORMAT_F32:
+      return 4;
+    case FORMAT_S16:
+      return 2;
+    case FORMAT_S24:
+      return 3;
+    default:
+      return 8;
+  }
+}
+
+inline const char* sampleFormatName(SampleFormat format) {
+  switch (format) {
+    case FORMAT_F32:
+      return "f32";
+    case FORMAT_S16:
+      return "s16";
+    case FORMAT_S24:
+      return "s24";
+    default:
+      return "f64";
+  }
+}
+
+// Converte o nome usado na linha de comando; retorna false se desconhecido
+inline bool parseSampleFormat(const char* name, SampleFormat& format) {
+  const SampleFormat all[] = {FORMAT_F64, FORMAT_F32, FORMAT_S16, FORMAT_S24};
+  for (SampleFormat f : all) {
+    if (strcmp(name, sampleFormatName(f)) == 0) {
+      format = f;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @class Dither
+ * @brief Ruído TPDF (densidade triangular, ±1 LSB) para quantização inteira.
+ *
+ * Soma de dois uniformes independentes gerados por xorshift64: descorrelaciona
+ * o erro de quantização do sinal, evitando distorção harmônica em sinais de
+ * baixa amplitude. Estado privado do produtor.
+ */
+class Dither {
+ public:
+  explicit Dither(bool enabled = true, uint64_t seed = 0x9E3779B97F4A7C15ull)
+      : m_state(seed), m_enabled(enabled) {}
+
+  // Valor em LSBs, no intervalo (-1, 1)
+  double next() {
+    if (!m_enabled) return 0.0;
+    return uniform() - uniform();
+  }
+
+  bool enabled() const { return m_enabled; }
+
+ private:
+  uint64_t m_state;
+  bool m_enabled;
+
+  double uniform() {
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 7;
+    m_state ^= m_state << 17;
+    return (m_state >> 11) * (1.0 / 9007199254740992.0);  // [0, 1)
+  }
+};
+
+// Quantiza para inteiro no fundo de escala `scale`, com dither e saturação
+inline int32_t quantizeSample(double value, double scale, Dither& dither) {
+  double q = std::nearbyint(value * scale + dither.next());
+  return static_cast<int32_t>(std::clamp(q, -scale, scale));
+}
+
+/**
+ * @brief Converte `count` amostras double para `format` em `out`.
+ *
+ * `out` não precisa estar alinhado (slots de 3 bytes nunca estão). Com
+ * `outStride` (em bytes) diferente de 0, as amostras são espalhadas com esse
+ * passo, como num anel intercalado; 0 significa slots contíguos.
+ */
+inline void encodeSamples(SampleFormat format, const double* in, void* out,
+                          size_t count, Dither& dither, size_t outStride = 0) {
+  unsigned char* bytes = static_cast<unsigned char*>(out);
+  size_t step = outStride ? outStride : sampleFormatSize(format);
+  switch (format) {
+    case FORMAT_F64:
+      if (step == sizeof(double)) {
+        memcpy(out, in, count * sizeof(double));
+      } else {
+        for (size_t i = 0; i < count; ++i) {
+          memcpy(bytes + i * step, in + i, sizeof(double));
+        }
+      }
+      break;
+    case FORMAT_F32:
+      for (size_t i = 0; i < count; ++i) {
+        float v = static_cast<float>(in[i]);
+        memcpy(bytes + i * step, &v, 4);
+      }
+      break;
+    case FORMAT_S16:
+      for (size_t i = 0; i < count; ++i) {
+        int16_t v = static_cast<int16_t>(quantizeSample(in[i], S16_SCALE,
+                                                        dither));
+        memcpy(bytes + i * step, &v, 2);
+      }
+      break;
+    case FORMAT_S24:
+      for (size_t i = 0; i < count; ++i) {
+        uint32_t v = static_cast<uint32_t>(quantizeSample(in[i], S24_SCALE,
+                                                          dither));
+        bytes[i * step] = static_cast<unsigned char>(v);
+        bytes[i * step + 1] = static_cast<unsigned char>(v >> 8);
+        bytes[i * step + 2] = static_cast<unsigned char>(v >> 16);
+      }
+      break;
+  }
+}
+
+/**
+ * @brief Operação inversa de encodeSamples (sem dither).
+ *
+ * `inStride` é o passo em bytes entre amostras de entrada (0 = contíguas) e
+ * `outStride` o passo, em doubles, entre amostras de saída.
+ */
+inline void decodeSamples(SampleFormat format, const void* in, double* out,
+                          size_t count, size_t inStride = 0,
+                          size_t outStride = 1) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(in);
+  size_t step = inStride ? inStride : sampleFormatSize(format);
+  switch (format) {
+    case FORMAT_F64:
+      if (step == sizeof(double) && outStride == 1) {
+        memcpy(out, in, count * sizeof(double));
+      } else {
+        for (size_t i = 0; i < count; ++i) {
+          memcpy(out + i * outStride, bytes + i * step, sizeof(double));
+        }
+      }
+      break;
+    case FORMAT_F32:
+      for (size_t i = 0; i < count; ++i) {
+        float v;
+        memcpy(&v, bytes + i * step, 4);
+        out[i * outStride] = v;
+      }
+      break;
+    case FORMAT_S16:
+      for (size_t i = 0; i < count; ++i) {
+        int16_t v;
+        memcpy(&v, bytes + i * step, 2);
+        out[i * outStride] = v * (1.0 / S16_SCALE);
+      }
+      break;
+    case FORMAT_S24:
+      for (size_t i = 0; i < count; ++i) {
+        // Monta nos 24 bits altos e desloca de volta para estender o sinal
+        const unsigned char* p = bytes + i * step;
+        int32_t v = static_cast<int32_t>(
+                        (static_cast<uint32_t>(p[0]) << 8) |
+                        (static_cast<uint32_t>(p[1]) << 16) |
+                        (static_cast<uint32_t>(p[2]) << 24)) >>
+                    8;
+        out[i * outStride] = v * (1.0 / S24_SCALE);
+      }
+      break;
+  }
+}
+
+#endif  // SAMPLE_FORMAT_HPP
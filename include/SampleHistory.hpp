@@ -0,0 +1,65 @@
+#ifndef SAMPLE_HISTORY_HPP
+#define SAMPLE_HISTORY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class SampleHistory
+ * @brief Janela deslizante das últimas `capacity` amostras, sempre contígua.
+ *
+ * Cada amostra é gravada duas vezes (posição i e i + capacity), então as
+ * últimas n amostras ocupam sempre um trecho contíguo do vetor: latest(n)
+ * devolve um ponteiro direto, sem montar cópias nem desalocar ao descartar
+ * amostras antigas. push() é O(1) e nunca aloca.
+ *
+ * A memória é do chamador (ex.: um bloco de BlockArena), com
+ * storageFor(capacity) doubles, e precisa viver mais que o histórico.
+ */
+class SampleHistory {
+ public:
+  SampleHistory(double* storage, size_t capacity)
+      : m_data(storage),
+        m_capacity(capacity),
+        m_next(0),
+        m_size(0),
+        m_total(0) {}
+
+  void push(double sample) {
+    m_data[m_next] = sample;
+    m_data[m_next + m_capacity] = sample;
+    if (++m_next == m_capacity) m_next = 0;
+    m_size = std::min(m_size + 1, m_capacity);
+    ++m_total;
+  }
+
+  void clear() {
+    m_next = 0;
+    m_size = 0;
+  }
+
+  // Doubles de memória para um histórico de `capacity` amostras
+  static size_t storageFor(size_t capacity) { return 2 * capacity; }
+
+  size_t size() const { return m_size; }
+  size_t capacity() const { return m_capacity; }
+
+  // Amostras já recebidas desde a criação (índice absoluto da próxima)
+  uint64_t total() const { return m_total; }
+
+  // Ponteiro para as últimas `n` amostras (n <= size()), da mais antiga
+  // para a mais recente
+  const double* latest(size_t n) const {
+    return m_data + m_next + m_capacity - n;
+  }
+
+ private:
+  double* m_data;  // Duas cópias da janela circular
+  size_t m_capacity;
+  size_t m_next;     // Posição da próxima escrita em [0, capacity)
+  size_t m_size;     // Amostras válidas (até capacity)
+  uint64_t m_total;  // Contador absoluto de amostras
+};
+
+#endif  // SAMPLE_HISTORY_HPP
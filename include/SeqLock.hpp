@@ -0,0 +1,123 @@
+#ifndef SEQ_LOCK_HPP
+#define SEQ_LOCK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @file SeqLock.hpp
+ * @brief Bloco de parâmetros publicado por seqlock: leituras coerentes e sem
+ * locks de vários campos escritos juntos.
+ *
+ * O contador `m_seq` é ímpar enquanto uma escrita está em andamento e avança
+ * de 2 a cada publicação completa. O leitor copia o bloco entre duas
+ * leituras do contador e repete se ele mudou ou estava ímpar; assim nunca vê
+ * metade de uma atualização. O valor fica guardado em palavras atômicas
+ * relaxadas para que a cópia concorrente não seja uma data race em C++.
+ *
+ * Escritores disputam o contador com CAS (par -> ímpar), então várias
+ * threads de controle podem publicar; entre si elas só esperam durante a
+ * cópia de poucos bytes. O leitor (caminho de áudio) nunca bloqueia um
+ * escritor.
+ */
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock exige um tipo trivialmente copiável");
+
+ public:
+  explicit SeqLock(const T& initial = T()) : m_seq(0) { writeWords(initial); }
+
+  SeqLock(const SeqLock&) = delete;
+  SeqLock& operator=(const SeqLock&) = delete;
+
+  // Cópia coerente do bloco
+  T load() const {
+    uint32_t version;
+    return load(version);
+  }
+
+  // Cópia coerente do bloco e a versão (par) em que ela foi publicada
+  T load(uint32_t& version) const {
+    uint64_t words[WORDS];
+    uint32_t before, after;
+    do {
+      before = m_seq.load(std::memory_order_acquire);
+      for (size_t i = 0; i < WORDS; ++i) {
+        words[i] = m_words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = m_seq.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    version = before;
+    T value;
+    memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+  // Versão atual (par); muda a cada publicação
+  uint32_t version() const { return m_seq.load(std::memory_order_acquire); }
+
+  // Publica um bloco inteiro
+  void store(const T& value) {
+    uint32_t seq = lockWriter();
+    writeWords(value);
+    m_seq.store(seq + 2, std::memory_order_release);
+  }
+
+  // Leitura-modificação-escrita atômica em relação a outros escritores:
+  // `fn(T&)` altera só os campos que lhe interessam
+  template <typename Fn>
+  void update(Fn fn) {
+    uint32_t seq = lockWriter();
+    T value = readWords();
+    fn(value);
+    writeWords(value);
+    m_seq.store(seq + 2, std::memory_order_release);
+  }
+
+ private:
+  static constexpr size_t WORDS = (sizeof(T) + 7) / 8;
+
+  std::atomic<uint32_t> m_seq;           // Ímpar durante uma escrita
+  std::atomic<uint64_t> m_words[WORDS];  // Conteúdo de T em palavras
+
+  // Torna o contador ímpar; retorna o valor par anterior
+  uint32_t lockWriter() {
+    uint32_t seq = m_seq.load(std::memory_order_relaxed);
+    while ((seq & 1) ||
+           !m_seq.compare_exchange_weak(seq, seq + 1,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+      seq = m_seq.load(std::memory_order_relaxed);
+    }
+    // Os dados só podem ser alterados depois que o contador ímpar for visível
+    std::atomic_thread_fence(std::memory_order_release);
+    return seq;
+  }
+
+  void writeWords(const T& value) {
+    uint64_t words[WORDS] = {};
+    memcpy(words, &value, sizeof(T));
+    for (size_t i = 0; i < WORDS; ++i) {
+      m_words[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  // Só chamado com o contador ímpar (escritor exclusivo)
+  T readWords() const {
+    uint64_t words[WORDS];
+    for (size_t i = 0; i < WORDS; ++i) {
+      words[i] = m_words[i].load(std::memory_order_relaxed);
+    }
+    T value;
+    memcpy(&value, words, sizeof(T));
+    return value;
+  }
+};
+
+#endif  // SEQ_LOCK_HPP
@@ -0,0 +1,367 @@
+#ifndef SHARED_MEMORY_HPP
+#define SHARED_MEMORY_HPP
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <new>
+
+#include "Communication.hpp"
+#include "Futex.hpp"
+#include "RingBuffer.hpp"
+
+/**
+ * @file SharedMemory.hpp
+ * @brief Criação (produtor) e mapeamento (consumidores) do segmento POSIX
+ * descrito por SharedBuffer.
+ *
+ * As funções não imprimem nada: em caso de falha retornam nullptr e apontam
+ * `error` para uma descrição do passo que falhou, para o chamador reportar
+ * com o prefixo do seu processo.
+ */
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;  ///< Página grande (THP)
+constexpr int SHM_WAIT_INTERVAL_MS = 100;  ///< Espera pelo produtor
+
+// Falhas de attachSharedBuffer que o tempo resolve (ver waitForSharedBuffer)
+constexpr const char* SHM_ERROR_NOT_FOUND =
+    "Shared memory not found (generator not running?)";
+constexpr const char* SHM_ERROR_NOT_INITIALIZED =
+    "Shared memory not initialized";
+
+// Verifica se o layout pedido é utilizável
+inline bool isValidLayout(const RingLayout& layout) {
+  return layout.capacity >= 2 &&
+         (layout.capacity & (layout.capacity - 1)) == 0 &&
+         layout.channels >= 1 && layout.channels <= MAX_CHANNELS;
+}
+
+// Segmento com exatamente este layout e tamanho (pode ser reaproveitado)
+inline bool matchesLayout(const SharedBuffer* buffer, const RingLayout& layout,
+                          size_t size) {
+  return buffer->magic.load(std::memory_order_acquire) == SHM_MAGIC &&
+         buffer->version == SHM_VERSION && buffer->totalSize == size &&
+         buffer->sampleFormat == layout.format &&
+         buffer->channels == layout.channels &&
+         buffer->channelLayout == layout.channelLayout &&
+         buffer->capacity == layout.capacity &&
+         buffer->sampleRate.load() == layout.sampleRate;
+}
+
+// Processo `pid` ainda existe (0 = nenhum)
+inline bool processAlive(uint32_t pid) {
+  return pid != 0 &&
+         !(kill(static_cast<pid_t>(pid), 0) < 0 && errno == ESRCH);
+}
+
+/**
+ * @brief Assume o segmento `name` como produtor, reaproveitando-o se já
+ * existir com o mesmo layout, e inicializa o cabeçalho se for novo.
+ *
+ * Reaproveitar é o caminho de um gerador que reinicia: o mapeamento dos
+ * consumidores continua válido, head/claim seguem de onde pararam (os
+ * cursores continuam coerentes; quadros reservados e não publicados por
+ * um produtor que caiu viram silêncio), a telemetria dos consumidores é mantida e
+ * a do produtor recomeça. `epochStart` recebe o head atual e `epoch` é
+ * incrementado, nessa ordem; os leitores ressincronizam sozinhos (ver
+ * RingReader). Se o segmento existente tiver outro layout, ele é aposentado
+ * (`magic` = 0, e os leitores bloqueados são acordados para notar) e um
+ * segmento novo toma o nome. Falha se outro produtor vivo já ocupa o
+ * segmento.
+ *
+ * Com `hugePages`, o tamanho é arredondado para múltiplos de 2 MiB e o
+ * mapeamento recebe MADV_HUGEPAGE antes de ser tocado (depende de
+ * /sys/kernel/mm/transparent_hugepage/shmem_enabled). Se o kernel recusar,
+ * o segmento é criado normalmente e `error` descreve o aviso.
+ */
+inline SharedBuffer* createSharedBuffer(const char* name,
+                                        const RingLayout& layout,
+                                        bool hugePages, const char*& error) {
+  error = nullptr;
+  if (!isValidLayout(layout)) {
+    error = "Invalid ring layout (capacity must be a power of 2, "
+            "1 to MAX_CHANNELS channels)";
+    return nullptr;
+  }
+
+  size_t size = SharedBuffer::segmentBytes(layout);
+  if (hugePages) size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+  // Segmento de uma execução anterior (ou de outro produtor ainda ativo)
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd >= 0) {
+    struct stat st;
+    void* address = MAP_FAILED;
+    size_t existing = 0;
+    if (fstat(fd, &st) == 0 &&
+        st.st_size >= static_cast<off_t>(sizeof(SharedBuffer))) {
+      existing = static_cast<size_t>(st.st_size);
+      address = mmap(nullptr, existing, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fd, 0);
+    }
+    close(fd);
+    if (address != MAP_FAILED) {
+      SharedBuffer* buffer = static_cast<SharedBuffer*>(address);
+      bool valid = buffer->magic.load(std::memory_order_acquire) == SHM_MAGIC &&
+                   buffer->version == SHM_VERSION;
+      if (valid && processAlive(buffer->producerPid.load())) {
+        munmap(address, existing);
+        error = "Shared memory is in use by another generator";
+        return nullptr;
+      }
+      if (existing == size && matchesLayout(buffer, layout, size)) {
+        // Um produtor que caiu entre reservar e publicar deixou claim > head
+        // e já sobrescreveu quadros até claim - capacity: claim nunca
+        // recua, e o trecho vira silêncio publicado (os leitores veem a
+        // perda como overrun)
+        uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        uint64_t claim = buffer->claim.load(std::memory_order_relaxed);
+        if (claim > head) {
+          RingWriter(buffer, false).skip(claim - head);
+          head = claim;
+        }
+        new (&buffer->telemetry) ProducerTelemetry();
+        for (std::atomic<double>& f : buffer->frequency) f.store(0.0);
+        buffer->producerPid.store(static_cast<uint32_t>(getpid()));
+        buffer->epochStart.store(head, std::memory_order_relaxed);
+        buffer->epoch.fetch_add(1, std::memory_order_release);
+        futexWakeAll(&buffer->frameSeq);
+        return buffer;
+      }
+      // Outro layout: aposenta o segmento para os leitores ainda mapeados
+      if (valid) {
+        buffer->magic.store(0, std::memory_order_release);
+        buffer->frameSeq.fetch_add(1, std::memory_order_release);
+        futexWakeAll(&buffer->frameSeq);
+      }
+      munmap(address, existing);
+    }
+  }
+
+  shm_unlink(name);
+  fd = shm_open(name, O_CREAT | O_RDWR, 0666);
+  if (fd < 0) {
+    error = "Failed to create shared memory";
+    return nullptr;
+  }
+
+  if (ftruncate(fd, size) < 0) {
+    error = "Failed to set shared memory size";
+    close(fd);
+    return nullptr;
+  }
+
+  void* address =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    error = "Failed to map shared memory";
+    return nullptr;
+  }
+
+  if (hugePages && madvise(address, size, MADV_HUGEPAGE) < 0) {
+    error = "Huge pages unavailable, using regular pages";
+  }
+
+  SharedBuffer* buffer = new (address) SharedBuffer(layout, size);
+  buffer->magic.store(SHM_MAGIC, std::memory_order_release);
+  return buffer;
+}
+
+/**
+ * @brief Mapeia somente leitura um segmento existente, qualquer que seja
+ * seu tamanho, validando magic, versão e consistência do cabeçalho.
+ *
+ * A página da tabela de consumidores é remapeada com escrita por cima, para
+ * o leitor poder se contar em SharedBuffer::frameWaiters(). Sem permissão de
+ * escrita no segmento ela vira uma cópia privada: o leitor funciona, mas o
+ * produtor não o vê dormindo e cada espera dura o timeout inteiro.
+ */
+inline const SharedBuffer* attachSharedBuffer(const char* name,
+                                              const char*& error) {
+  error = nullptr;
+  bool writable = true;
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0 && errno == EACCES) {
+    writable = false;
+    fd = shm_open(name, O_RDONLY, 0);
+  }
+  if (fd < 0) {
+    error = SHM_ERROR_NOT_FOUND;
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 ||
+      st.st_size < static_cast<off_t>(sizeof(SharedBuffer))) {
+    error = SHM_ERROR_NOT_INITIALIZED;
+    close(fd);
+    return nullptr;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (address == MAP_FAILED) {
+    error = "Failed to map shared memory";
+    close(fd);
+    return nullptr;
+  }
+
+  const SharedBuffer* buffer = static_cast<const SharedBuffer*>(address);
+  if (buffer->magic.load(std::memory_order_acquire) != SHM_MAGIC) {
+    error = SHM_ERROR_NOT_INITIALIZED;
+  } else if (buffer->version != SHM_VERSION) {
+    error = "Shared memory layout version mismatch";
+  } else if (buffer->totalSize != size ||
+             buffer->headerSize < sizeof(SharedBuffer) ||
+             buffer->consumersOffset % CONSUMER_TABLE_BYTES != 0 ||
+             buffer->consumersOffset < sizeof(SharedBuffer) ||
+             buffer->consumersOffset + CONSUMER_TABLE_BYTES >
+                 buffer->headerSize ||
+             buffer->capacity < 2 ||
+             (buffer->capacity & (buffer->capacity - 1)) != 0 ||
+             buffer->channels < 1 || buffer->channels > MAX_CHANNELS ||
+             buffer->headerSize + buffer->capacity * buffer->channels *
+                                      buffer->sampleBytes() >
+                 size) {
+    error = "Shared memory header is inconsistent";
+  }
+
+  // Em páginas maiores que a tabela, a página que a contém; uma cópia
+  // privada só é segura se não levar junto head, claim ou o anel
+  if (!error) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t offset = buffer->consumersOffset & ~(page - 1);
+    bool tableOnly = offset >= buffer->consumersOffset &&
+                     offset + page <= buffer->headerSize;
+    void* table =
+        (writable || tableOnly)
+            ? mmap(static_cast<unsigned char*>(address) + offset, page,
+                   PROT_READ | PROT_WRITE,
+                   (writable ? MAP_SHARED : MAP_PRIVATE) | MAP_FIXED, fd,
+                   static_cast<off_t>(offset))
+            : MAP_FAILED;
+    if (table == MAP_FAILED) error = "Failed to map consumer table";
+  }
+  close(fd);
+
+  if (error) {
+    munmap(address, size);
+    return nullptr;
+  }
+  return buffer;
+}
+
+/**
+ * @brief Como attachSharedBuffer, mas espera o segmento aparecer enquanto
+ * `keepWaiting` for verdadeiro: o consumidor pode subir antes do gerador.
+ *
+ * Só as falhas que o tempo resolve (segmento inexistente ou ainda sendo
+ * inicializado) fazem esperar; as demais retornam na hora. `onWait` é
+ * chamado uma vez, antes da primeira espera (ex.: para avisar o usuário).
+ */
+template <typename OnWait>
+inline const SharedBuffer* waitForSharedBuffer(
+    const char* name, const std::atomic<bool>& keepWaiting, OnWait onWait,
+    const char*& error) {
+  bool waited = false;
+  while (true) {
+    const SharedBuffer* buffer = attachSharedBuffer(name, error);
+    if (buffer || (error != SHM_ERROR_NOT_FOUND &&
+                   error != SHM_ERROR_NOT_INITIALIZED)) {
+      return buffer;
+    }
+    if (!keepWaiting) return nullptr;
+    if (!waited) onWait();
+    waited = true;
+    usleep(SHM_WAIT_INTERVAL_MS * 1000);
+  }
+}
+
+/**
+ * @brief Registra um consumidor na tabela de telemetria do segmento `name`
+ * (já validado por attachSharedBuffer em `buffer`).
+ *
+ * Mapeia com escrita apenas a página da tabela e toma um slot livre (ou de
+ * um processo que já morreu), gravando `label` como nome. O ponteiro
+ * retornado vai para RingReader::setTelemetry(); libere com
+ * unregisterConsumer(). Falhar aqui não impede a leitura do anel: o
+ * consumidor só fica invisível para a telemetria.
+ */
+inline ConsumerSlot* registerConsumer(const char* name,
+                                      const SharedBuffer* buffer,
+                                      const char* label, const char*& error) {
+  error = nullptr;
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) {
+    error = "Failed to open shared memory for telemetry";
+    return nullptr;
+  }
+
+  // Em páginas maiores que a tabela, mapeia a página que a contém
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t offset = buffer->consumersOffset & ~(page - 1);
+  void* address = mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                       static_cast<off_t>(offset));
+  close(fd);
+  if (address == MAP_FAILED) {
+    error = "Failed to map telemetry table";
+    return nullptr;
+  }
+
+  ConsumerSlot* slots = reinterpret_cast<ConsumerSlot*>(
+      static_cast<unsigned char*>(address) + buffer->consumersOffset - offset);
+  uint32_t self = static_cast<uint32_t>(getpid());
+  for (size_t i = 0; i < MAX_CONSUMERS; ++i) {
+    uint32_t owner = slots[i].pid.load(std::memory_order_relaxed);
+    bool reusable = owner == 0 || (kill(static_cast<pid_t>(owner), 0) < 0 &&
+                                   errno == ESRCH);
+    if (!reusable || !slots[i].pid.compare_exchange_strong(owner, self)) {
+      continue;
+    }
+    ConsumerSlot& slot = slots[i];
+    strncpy(slot.name, label, CONSUMER_NAME_SIZE - 1);
+    slot.name[CONSUMER_NAME_SIZE - 1] = '\0';
+    slot.tail.store(buffer->head.load(std::memory_order_relaxed));
+    slot.samplesConsumed.store(0);
+    slot.framesLost.store(0);
+    slot.overruns.store(0);
+    slot.updatedNs.store(monotonicNs());
+    return &slot;
+  }
+
+  munmap(address, page);
+  error = "No free telemetry slot";
+  return nullptr;
+}
+
+// Libera o slot e desfaz o mapeamento feito por registerConsumer
+inline void unregisterConsumer(ConsumerSlot* slot) {
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  slot->pid.store(0, std::memory_order_release);
+  uintptr_t address = reinterpret_cast<uintptr_t>(slot) & ~(page - 1);
+  munmap(reinterpret_cast<void*>(address), page);
+}
+
+/**
+ * @brief Encerra a execução do produtor: o segmento fica sem dono mas
+ * continua existindo, com os consumidores mapeados, até o próximo
+ * createSharedBuffer. Desfaz o mapeamento do produtor.
+ */
+inline void releaseProducerBuffer(SharedBuffer* buffer) {
+  buffer->producerPid.store(0, std::memory_order_release);
+  munmap(buffer, buffer->totalSize);
+}
+
+// Desfaz o mapeamento feito por attachSharedBuffer
+inline void releaseSharedBuffer(const SharedBuffer* buffer) {
+  size_t size = buffer->totalSize;
+  munmap(const_cast<SharedBuffer*>(buffer), size);
+}
+
+#endif  // SHARED_MEMORY_HPP
@@ -4,17 +4,28 @@
 #include <algorithm>
 #include <atomic>
 #include <cmath>
-#include <vector>
 
 #include "ISignalGenerator.hpp"
+#include "OscillatorControl.hpp"
+#include "SineKernel.hpp"
+
+class SineGenerator final : public ISignalGenerator {
+ public:
+  // Modos de geração
+  enum Mode {
+    MODE_VISUAL,   ///< Forma de onda ajustada para a tela (legado)
+    MODE_PHYSICAL  ///< Oscilador real: fase avança 2πf/fs por amostra
+  };
 
-class SineGenerator : public ISignalGenerator {
  private:
-  // Parâmetros atômicos para acesso thread-safe entre UI e áudio
-  std::atomic<double> m_frequency;  // Frequência da onda em Hz
-  std::atomic<double> m_amplitude;  // Amplitude (0.0 a 1.0)
-  std::atomic<bool> m_running;      // Se a thread de áudio está rodando
+  // Frequência, amplitude e rampas: publicados pelo controle via seqlock e
+  // lidos pelo áudio uma vez por bloco (ver OscillatorControl)
+  OscillatorControl m_control;
+  std::atomic<bool> m_running;  // Se a thread de áudio está rodando
+  std::atomic<Mode> m_mode;     // Modo de geração (visual ou físico)
+  double m_sampleRate;          // Taxa de amostragem em Hz
   double m_phase;  // Fase acumulada (não atômica, só acessada pela áudio)
+  SineKernelFn m_kernel;  // Kernel de bloco (SIMD por padrão, ver SineKernel)
 
   // Constantes para controle visual da onda
   static constexpr double BASE_FREQUENCY =
@@ -29,11 +40,24 @@ class SineGenerator : public ISignalGenerator {
   static constexpr double MAX_CYCLES =
       12.0;  // Máximo de ciclos na tela (zoom mínimo)
 
-  // Parâmetros visuais calculados dinamicamente
+  // log10(MIN_FREQ) e log10(MAX_FREQ) calculados em tempo de compilação
+  // (std::log10 não é constexpr, então entram como literais)
+  static constexpr double LOG_MIN_FREQ = 0.0;
+  static constexpr double LOG_MAX_FREQ = 4.342422680822207;
+  static constexpr double INV_LOG_RANGE = 1.0 / (LOG_MAX_FREQ - LOG_MIN_FREQ);
+  static constexpr double MAX_VELOCITY = 0.03;  // Teto da rolagem por bloco
+
+  // Parâmetros visuais, derivados da frequência e recalculados só quando ela
+  // muda (só a thread de áudio escreve nestes campos)
   double m_displayCycles;  // Quantos ciclos da onda aparecem na tela (varia com
                            // frequência)
   double m_currentZoom;    // Fator de zoom relativo à base (calculado de
                            // displayCycles)
+  double m_velocity;       // Avanço de m_phase por bloco (rolagem)
+  double m_displayFrequency;  // Frequência de que os campos acima derivam
+                              // (-1 = nenhuma)
+  double m_phaseStep;         // 2π * displayCycles / m_phaseStepCount
+  size_t m_phaseStepCount;    // Tamanho de bloco de m_phaseStep (0 = inválido)
 
   /**
    * Mapeia a frequência (escala log) para número de ciclos na tela (linear)
@@ -47,35 +71,116 @@ class SineGenerator : public ISignalGenerator {
    * 2. Calcula onde a frequência está entre min e max (ratio 0..1)
    * 3. Mapeia ratio linearmente entre min_cycles e max_cycles
    * 4. Calcula zoom como fator relativo à base
+   *
+   * Chamado a cada bloco, mas só faz contas quando `freq` difere da última
+   * frequência vista; o incremento de fase por amostra, que depende também
+   * do tamanho do bloco, é invalidado junto.
    */
-  void updateDisplayParameters() {
-    double freq = m_frequency.load();
+  void updateDisplayParameters(double freq) {
+    if (freq == m_displayFrequency) return;
+    m_displayFrequency = freq;
+    m_phaseStepCount = 0;
 
     // Log da frequência para mapeamento perceptual
     double logFreq = log10(freq);
-    double logMin = log10(MIN_FREQ);
-    double logMax = log10(MAX_FREQ);
 
     // Posição relativa na faixa de frequências (0 = mínima, 1 = máxima)
-    double ratio = std::clamp((logFreq - logMin) / (logMax - logMin), 0.0, 1.0);
+    double ratio =
+        std::clamp((logFreq - LOG_MIN_FREQ) * INV_LOG_RANGE, 0.0, 1.0);
 
     // Interpola linearmente entre mínimo e máximo de ciclos
     m_displayCycles = MIN_CYCLES + ratio * (MAX_CYCLES - MIN_CYCLES);
 
     // Calcula zoom: >1 = mais zoom, <1 = menos zoom
     m_currentZoom = std::clamp(BASE_CYCLES / m_displayCycles, 0.5, 2.0);
+
+    // Velocidade de rolagem: cresce com o log da frequência, com teto
+    m_velocity = std::min(
+        BASE_VELOCITY * (1.0 + log10(freq / BASE_FREQUENCY + 1.0)),
+        MAX_VELOCITY);
+  }
+
+  // Incremento de fase por amostra para blocos de `count` amostras
+  double displayPhaseStep(size_t count) {
+    if (count != m_phaseStepCount) {
+      // Fase total para percorrer displayCycles ciclos na tela
+      m_phaseStep = 2.0 * M_PI * m_displayCycles / count;
+      m_phaseStepCount = count;
+    }
+    return m_phaseStep;
+  }
+
+  // Aplica um pedido de fase do controle (radianos, qualquer valor)
+  void applyPhase(const OscillatorSnapshot& params) {
+    if (!params.phaseChanged) return;
+    m_phase = std::fmod(params.phase, 2.0 * M_PI);
+    if (m_phase < 0.0) m_phase += 2.0 * M_PI;
+  }
+
+  // Modo físico: divide o bloco nos pontos em que alguma rampa termina.
+  // Trechos sem rampa usam o kernel SIMD; trechos com rampa, sineBlockRamp.
+  // Os parâmetros vêm de um único snapshot e avançam em variáveis locais.
+  void generatePhysical(double* out, size_t count,
+                        const OscillatorSnapshot& params) {
+    LinearRamp& frequencyRamp = m_control.frequencyRamp();
+    LinearRamp& amplitudeRamp = m_control.amplitudeRamp();
+    bool ramping = m_control.rampActive();
+    double nyquist = 0.5 * m_sampleRate;
+    double frequency = params.frequency;
+    double amplitude = params.amplitude;
+    size_t done = 0;
+
+    while (done < count) {
+      size_t n = count - done;
+      if (frequencyRamp.active()) n = frequencyRamp.span(n);
+      if (amplitudeRamp.active()) n = amplitudeRamp.span(n);
+
+      double freq = std::min(frequency, nyquist);
+      double phaseStep = 2.0 * M_PI * freq / m_sampleRate;
+
+      if (!frequencyRamp.active() && !amplitudeRamp.active()) {
+        m_kernel(out + done, n, m_phase, phaseStep, amplitude);
+        m_phase = std::fmod(m_phase + n * phaseStep, 2.0 * M_PI);
+      } else {
+        double stepDelta =
+            frequencyRamp.active()
+                ? 2.0 * M_PI * frequencyRamp.delta / m_sampleRate
+                : 0.0;
+        double ampDelta = amplitudeRamp.active() ? amplitudeRamp.delta : 0.0;
+        sineBlockRamp(out + done, n, m_phase, phaseStep, stepDelta, amplitude,
+                      ampDelta);
+        m_phase = std::fmod(
+            m_phase + n * phaseStep + 0.5 * n * (n - 1.0) * stepDelta,
+            2.0 * M_PI);
+
+        if (frequencyRamp.active()) frequency = frequencyRamp.advance(freq, n);
+        if (amplitudeRamp.active()) {
+          amplitude = amplitudeRamp.advance(amplitude, n);
+        }
+      }
+      done += n;
+    }
+
+    if (ramping) m_control.publish(frequency, amplitude);
   }
 
  public:
-  explicit SineGenerator(double /*sampleRate*/ = 44100.0,
-                         double frequency = 100.0, double amplitude = 0.8)
-      : m_frequency(frequency),
-        m_amplitude(std::clamp(amplitude, 0.0, 1.0)),
+  explicit SineGenerator(double sampleRate = 44100.0,
+                         double frequency = 100.0, double amplitude = 0.8,
+                         Mode mode = MODE_VISUAL)
+      : m_control(frequency, std::clamp(amplitude, 0.0, 1.0)),
         m_running(false),
+        m_mode(mode),
+        m_sampleRate(sampleRate),
         m_phase(0.0),
+        m_kernel(sineKernelBest()),
         m_displayCycles(BASE_CYCLES),
-        m_currentZoom(1.0) {
-    updateDisplayParameters();
+        m_currentZoom(1.0),
+        m_velocity(BASE_VELOCITY),
+        m_displayFrequency(-1.0),
+        m_phaseStep(0.0),
+        m_phaseStepCount(0) {
+    updateDisplayParameters(frequency);
   }
 
   void start() override { m_running = true; }
@@ -128,6 +233,10 @@ class SineGenerator : public ISignalGenerator {
    *    currentPhase = m_phase + i * phaseStep
    *    sample[i] = amplitude * sin(currentPhase)
    *
+   *    A fase é calculada a partir do índice (e não somando phaseStep a cada
+   *    amostra), então não há dependência serial e o bloco inteiro é
+   *    avaliado pelo kernel vetorizado de SineKernel.hpp.
+   *
    *    Isto garante que:
    *    - A fase não "reseta" entre blocos (evita clicks)
    *    - A frequência instantânea é mantida
@@ -139,60 +248,124 @@ class SineGenerator : public ISignalGenerator {
    *
    * O resultado é uma onda matematicamente contínua através dos blocos,
    * com parâmetros visuais ajustáveis independentemente da geração do áudio.
+   *
+   * 7. Modo físico (MODE_PHYSICAL): aplica literalmente o item 3,
+   *    Δθ = 2π * f / sampleRate, e avança m_phase por count * Δθ ao fim do
+   *    bloco. A saída é um sinal real amostrado em sampleRate (a frequência
+   *    é limitada a Nyquist); o mapeamento de zoom fica a cargo do viewer.
+   *    Rampas (rampParameter) variam Δθ e a amplitude amostra a amostra,
+   *    sem degraus entre blocos.
+   *
+   * 8. Frequência, amplitude e fase são lidas de um único snapshot no início
+   *    do bloco: uma atualização concorrente de vários campos entra inteira
+   *    no próximo bloco, nunca pela metade no meio deste.
    */
-  std::vector<double> generateSamples(size_t count) override {
-    std::vector<double> samples;
-    if (!m_running) return samples;
+  size_t generateSamples(double* out, size_t count) override {
+    if (!m_running) return 0;
 
-    updateDisplayParameters();
+    OscillatorSnapshot params = m_control.acquire();
+    applyPhase(params);
 
-    // Fase total para percorrer displayCycles ciclos na tela
-    double totalPhase = 2.0 * M_PI * m_displayCycles;
+    if (m_mode == MODE_PHYSICAL) {
+      generatePhysical(out, count, params);
+      return count;
+    }
 
-    // Incremento de fase por amostra (taxa de variação da fase)
-    double phaseStep = totalPhase / count;
+    updateDisplayParameters(params.frequency);
 
-    // Fase corrente = fase acumulada global + avanço intra-bloco
-    double currentPhase = m_phase;
+    // Incremento de fase por amostra (taxa de variação da fase)
+    double phaseStep = displayPhaseStep(count);
 
-    // Gera amostras aplicando seno à fase acumulada
-    for (size_t i = 0; i < count; ++i) {
-      samples.push_back(m_amplitude * std::sin(currentPhase));
-      currentPhase += phaseStep;  // Avança fase para próxima amostra
-    }
+    // Gera amostras aplicando seno à fase m_phase + i * phaseStep
+    m_kernel(out, count, m_phase, phaseStep, params.amplitude);
 
     // Avança fase global para próximo bloco (garante continuidade)
-    double freq = m_frequency.load();
-    double velocity =
-        BASE_VELOCITY * (1.0 + log10(freq / BASE_FREQUENCY + 1.0));
-    velocity = std::min(velocity, 0.03);
-    m_phase += velocity;
+    m_phase += m_velocity;
 
     // Wrap-around para evitar perda de precisão
     while (m_phase > 2.0 * M_PI) m_phase -= 2.0 * M_PI;
 
-    return samples;
+    return count;
   }
 
-  void setParameter(const std::string& name, double value) override {
-    if (name == "frequency") {
-      value = std::clamp(value, MIN_FREQ, MAX_FREQ);
-      m_frequency = value;
-      updateDisplayParameters();
-    } else if (name == "amplitude") {
-      m_amplitude = std::clamp(value, 0.0, 1.0);
+  using ISignalGenerator::generateSamples;
+  using ISignalGenerator::getParameter;
+  using ISignalGenerator::rampParameter;
+  using ISignalGenerator::setParameter;
+
+  // Pode ser chamado de qualquer thread; vale a partir do próximo bloco
+  void setParameter(ParameterId id, double value) override {
+    switch (id) {
+      case PARAM_FREQUENCY:
+        m_control.setFrequency(std::clamp(value, MIN_FREQ, MAX_FREQ));
+        break;
+      case PARAM_AMPLITUDE:
+        m_control.setAmplitude(std::clamp(value, 0.0, 1.0));
+        break;
+      case PARAM_MODE:
+        m_mode = value >= 0.5 ? MODE_PHYSICAL : MODE_VISUAL;
+        break;
+      case PARAM_PHASE:
+        m_control.setPhase(value);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Frequência e amplitude publicadas juntas (entram no mesmo bloco)
+  void setParameters(double frequency, double amplitude) {
+    m_control.set(std::clamp(frequency, MIN_FREQ, MAX_FREQ),
+                  std::clamp(amplitude, 0.0, 1.0));
+  }
+
+  // Rampas só existem no modo físico; no visual viram degraus. Só a thread
+  // que renderiza pode iniciar rampas.
+  void rampParameter(ParameterId id, double value, size_t frames) override {
+    if (frames == 0 || m_mode != MODE_PHYSICAL) {
+      setParameter(id, value);
+    } else if (id == PARAM_FREQUENCY) {
+      double nyquist = 0.5 * m_sampleRate;
+      value = std::clamp(value, MIN_FREQ, std::min(MAX_FREQ, nyquist));
+      m_control.beginFrequencyRamp(
+          std::min(m_control.load().frequency, nyquist), value, frames);
+    } else if (id == PARAM_AMPLITUDE) {
+      m_control.beginAmplitudeRamp(m_control.load().amplitude,
+                                   std::clamp(value, 0.0, 1.0), frames);
+    } else {
+      setParameter(id, value);
+    }
+  }
+
+  double getParameter(ParameterId id) const override {
+    switch (id) {
+      case PARAM_FREQUENCY:
+        return m_control.load().frequency;
+      case PARAM_AMPLITUDE:
+        return m_control.load().amplitude;
+      case PARAM_MODE:
+        return m_mode == MODE_PHYSICAL ? 1.0 : 0.0;
+      case PARAM_PHASE:
+        return m_phase;
+      default:
+        return 0.0;
     }
   }
 
   // Public getters (usados pelo controller)
-  double getFrequency() const { return m_frequency; }
-  double getAmplitude() const { return m_amplitude; }
+  double getFrequency() const { return m_control.load().frequency; }
+  double getAmplitude() const { return m_control.load().amplitude; }
   double getPhase() const { return m_phase; }
+  double getSampleRate() const { return m_sampleRate; }
+  Mode getMode() const { return m_mode; }
   double getDisplayCycles() const { return m_displayCycles; }
   double getCurrentZoom() const { return m_currentZoom; }
   bool isRunning() const { return m_running; }
 
   void resetPhase() { m_phase = 0.0; }
+
+  // Troca o kernel de bloco (ex.: sineBlockReference para checar precisão)
+  void setKernel(SineKernelFn kernel) { m_kernel = kernel; }
 };
 
 #endif  // SINE_GENERATOR_HPP
@@ -0,0 +1,286 @@
+#ifndef SINE_KERNEL_HPP
+#define SINE_KERNEL_HPP
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SINE_KERNEL_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SINE_KERNEL_NEON 1
+#endif
+
+/**
+ * @file SineKernel.hpp
+ * @brief Kernels de bloco para y[i] = amplitude * sin(phase0 + i * step).
+ *
+ * A fase de cada amostra é calculada diretamente a partir do índice, sem a
+ * dependência serial `fase += passo`, o que permite processar várias amostras
+ * por instrução. Variantes disponíveis:
+ *
+ * - reference: std::sin por amostra; referência para checagem de precisão.
+ * - scalar:    mesma aproximação polinomial das variantes SIMD, sem SIMD
+ *              e sem FMA.
+ * - avx2/avx512/neon: 4, 8 ou 2 amostras por iteração.
+ *
+ * Aproximação: redução de argumento de Cody-Waite para r = x - kπ com
+ * r ∈ [-π/2, π/2] (π dividido em duas parcelas para não perder bits),
+ * sin(x) = (-1)^k sin(r), e sin(r) pela série de Taylor até r^15 avaliada por
+ * Horner em r². O erro absoluto é dominado pelo primeiro termo omitido,
+ * (π/2)^17 / 17! < 1e-11, para as fases usadas pelos geradores (|x| < 1e4
+ * rad); acima disso cresce o erro de arredondamento da redução.
+ *
+ * As variantes SIMD calculam x = phase0 + i * step, a redução e o Horner
+ * com FMA e a escalar não (std::fma sem FMA na CPU alvo vira uma rotina de
+ * software lenta), então os resultados não são idênticos bit a bit: diferem
+ * pelos arredondamentos de x e de k * π, até cerca de |x| * 2^-52 (~3e-12 em
+ * |x| = 1e4), abaixo do erro da própria aproximação.
+ *
+ * sineBlock() escolhe a melhor variante suportada pela CPU na primeira
+ * chamada (cpuid em x86, NEON é obrigatório em aarch64).
+ */
+
+// Assinatura comum dos kernels
+using SineKernelFn = void (*)(double* out, size_t count, double phase0,
+                              double step, double amplitude);
+
+enum SineKernelType {
+  KERNEL_REFERENCE,  ///< std::sin por amostra
+  KERNEL_SCALAR,     ///< Polinômio, uma amostra por vez
+  KERNEL_AVX2,       ///< Polinômio, 4 amostras por iteração (AVX2 + FMA)
+  KERNEL_AVX512,     ///< Polinômio, 8 amostras por iteração (AVX-512F)
+  KERNEL_NEON        ///< Polinômio, 2 amostras por iteração (aarch64)
+};
+
+// Constantes da aproximação
+constexpr double SINE_INV_PI = 0.318309886183790671538;
+constexpr double SINE_PI_HI = 3.141592653589793116;    // π arredondado
+constexpr double SINE_PI_LO = 1.2246467991473532e-16;  // π - SINE_PI_HI
+constexpr double SINE_C3 = -1.0 / 6.0;
+constexpr double SINE_C5 = 1.0 / 120.0;
+constexpr double SINE_C7 = -1.0 / 5040.0;
+constexpr double SINE_C9 = 1.0 / 362880.0;
+constexpr double SINE_C11 = -1.0 / 39916800.0;
+constexpr double SINE_C13 = 1.0 / 6227020800.0;
+constexpr double SINE_C15 = -1.0 / 1307674368000.0;
+
+inline void sineBlockReference(double* out, size_t count, double phase0,
+                               double step, double amplitude) {
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = amplitude * std::sin(phase0 + i * step);
+  }
+}
+
+// Aproximação polinomial para uma única fase (também usada nas sobras dos
+// kernels SIMD, que diferem das faixas vetoriais só pelo FMA; ver acima)
+inline double sinePoly(double x) {
+  double k = std::nearbyint(x * SINE_INV_PI);
+  double r = (x - k * SINE_PI_HI) - k * SINE_PI_LO;
+  double r2 = r * r;
+  double p = SINE_C15;
+  p = p * r2 + SINE_C13;
+  p = p * r2 + SINE_C11;
+  p = p * r2 + SINE_C9;
+  p = p * r2 + SINE_C7;
+  p = p * r2 + SINE_C5;
+  p = p * r2 + SINE_C3;
+  double s = r + r * r2 * p;
+  // k ímpar inverte o sinal
+  double parity = k - 2.0 * std::floor(k * 0.5);
+  return s * (1.0 - 2.0 * parity);
+}
+
+inline void sineBlockScalar(double* out, size_t count, double phase0,
+                            double step, double amplitude) {
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = amplitude * sinePoly(phase0 + i * step);
+  }
+}
+
+#ifdef SINE_KERNEL_X86
+__attribute__((target("avx2,fma"))) inline void sineBlockAvx2(
+    double* out, size_t count, double phase0, double step, double amplitude) {
+  const __m256d vPhase0 = _mm256_set1_pd(phase0);
+  const __m256d vStep = _mm256_set1_pd(step);
+  const __m256d vAmp = _mm256_set1_pd(amplitude);
+  const __m256d vInvPi = _mm256_set1_pd(SINE_INV_PI);
+  const __m256d vPiHi = _mm256_set1_pd(SINE_PI_HI);
+  const __m256d vPiLo = _mm256_set1_pd(SINE_PI_LO);
+  const __m256d vHalf = _mm256_set1_pd(0.5);
+  const __m256d vOne = _mm256_set1_pd(1.0);
+  const __m256d vTwo = _mm256_set1_pd(2.0);
+  const __m256d vLanes = _mm256_set1_pd(4.0);
+  __m256d vIndex = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d x = _mm256_fmadd_pd(vIndex, vStep, vPhase0);
+    __m256d k = _mm256_round_pd(_mm256_mul_pd(x, vInvPi),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(k, vPiLo, _mm256_fnmadd_pd(k, vPiHi, x));
+    __m256d r2 = _mm256_mul_pd(r, r);
+    __m256d p = _mm256_set1_pd(SINE_C15);
+    p = _mm256_fmadd_pd(p, r2, _mm256_set1_pd(SINE_C13));
+    p = _mm256_fmadd_pd(p, r2, _mm256_set1_pd(SINE_C11));
+    p = _mm256_fmadd_pd(p, r2, _mm256_set1_pd(SINE_C9));
+    p = _mm256_fmadd_pd(p, r2, _mm256_set1_pd(SINE_C7));
+    p = _mm256_fmadd_pd(p, r2, _mm256_set1_pd(SINE_C5));
+    p = _mm256_fmadd_pd(p, r2, _mm256_set1_pd(SINE_C3));
+    __m256d s = _mm256_fmadd_pd(_mm256_mul_pd(r, r2), p, r);
+    __m256d half = _mm256_floor_pd(_mm256_mul_pd(k, vHalf));
+    __m256d parity = _mm256_fnmadd_pd(half, vTwo, k);
+    __m256d sign = _mm256_fnmadd_pd(parity, vTwo, vOne);
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_mul_pd(s, sign), vAmp));
+    vIndex = _mm256_add_pd(vIndex, vLanes);
+  }
+  for (; i < count; ++i) out[i] = amplitude * sinePoly(phase0 + i * step);
+}
+
+__attribute__((target("avx512f"))) inline void sineBlockAvx512(
+    double* out, size_t count, double phase0, double step, double amplitude) {
+  const __m512d vPhase0 = _mm512_set1_pd(phase0);
+  const __m512d vStep = _mm512_set1_pd(step);
+  const __m512d vAmp = _mm512_set1_pd(amplitude);
+  const __m512d vInvPi = _mm512_set1_pd(SINE_INV_PI);
+  const __m512d vPiHi = _mm512_set1_pd(SINE_PI_HI);
+  const __m512d vPiLo = _mm512_set1_pd(SINE_PI_LO);
+  const __m512d vHalf = _mm512_set1_pd(0.5);
+  const __m512d vOne = _mm512_set1_pd(1.0);
+  const __m512d vTwo = _mm512_set1_pd(2.0);
+  const __m512d vLanes = _mm512_set1_pd(8.0);
+  __m512d vIndex = _mm512_setr_pd(0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0);
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m512d x = _mm512_fmadd_pd(vIndex, vStep, vPhase0);
+    // Variantes mascaradas (máscara cheia) evitam o operando indefinido que
+    // _mm512_roundscale_pd passa adiante e que gera falso aviso no GCC
+    __m512d q = _mm512_mul_pd(x, vInvPi);
+    __m512d k = _mm512_mask_roundscale_pd(
+        q, 0xFF, q, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(k, vPiLo, _mm512_fnmadd_pd(k, vPiHi, x));
+    __m512d r2 = _mm512_mul_pd(r, r);
+    __m512d p = _mm512_set1_pd(SINE_C15);
+    p = _mm512_fmadd_pd(p, r2, _mm512_set1_pd(SINE_C13));
+    p = _mm512_fmadd_pd(p, r2, _mm512_set1_pd(SINE_C11));
+    p = _mm512_fmadd_pd(p, r2, _mm512_set1_pd(SINE_C9));
+    p = _mm512_fmadd_pd(p, r2, _mm512_set1_pd(SINE_C7));
+    p = _mm512_fmadd_pd(p, r2, _mm512_set1_pd(SINE_C5));
+    p = _mm512_fmadd_pd(p, r2, _mm512_set1_pd(SINE_C3));
+    __m512d s = _mm512_fmadd_pd(_mm512_mul_pd(r, r2), p, r);
+    __m512d kHalf = _mm512_mul_pd(k, vHalf);
+    __m512d half = _mm512_mask_roundscale_pd(
+        kHalf, 0xFF, kHalf, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    __m512d parity = _mm512_fnmadd_pd(half, vTwo, k);
+    __m512d sign = _mm512_fnmadd_pd(parity, vTwo, vOne);
+    _mm512_storeu_pd(out + i, _mm512_mul_pd(_mm512_mul_pd(s, sign), vAmp));
+    vIndex = _mm512_add_pd(vIndex, vLanes);
+  }
+  for (; i < count; ++i) out[i] = amplitude * sinePoly(phase0 + i * step);
+}
+#endif  // SINE_KERNEL_X86
+
+#ifdef SINE_KERNEL_NEON
+inline void sineBlockNeon(double* out, size_t count, double phase0,
+                          double step, double amplitude) {
+  const float64x2_t vPhase0 = vdupq_n_f64(phase0);
+  const float64x2_t vStep = vdupq_n_f64(step);
+  const float64x2_t vInvPi = vdupq_n_f64(SINE_INV_PI);
+  const float64x2_t vPiHi = vdupq_n_f64(SINE_PI_HI);
+  const float64x2_t vPiLo = vdupq_n_f64(SINE_PI_LO);
+  const float64x2_t vOne = vdupq_n_f64(1.0);
+  const float64x2_t vTwo = vdupq_n_f64(2.0);
+  const float64x2_t vLanes = vdupq_n_f64(2.0);
+  const double index0[2] = {0.0, 1.0};
+  float64x2_t vIndex = vld1q_f64(index0);
+
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    float64x2_t x = vfmaq_f64(vPhase0, vIndex, vStep);
+    float64x2_t k = vrndnq_f64(vmulq_f64(x, vInvPi));
+    float64x2_t r = vfmsq_f64(vfmsq_f64(x, k, vPiHi), k, vPiLo);
+    float64x2_t r2 = vmulq_f64(r, r);
+    float64x2_t p = vdupq_n_f64(SINE_C15);
+    p = vfmaq_f64(vdupq_n_f64(SINE_C13), p, r2);
+    p = vfmaq_f64(vdupq_n_f64(SINE_C11), p, r2);
+    p = vfmaq_f64(vdupq_n_f64(SINE_C9), p, r2);
+    p = vfmaq_f64(vdupq_n_f64(SINE_C7), p, r2);
+    p = vfmaq_f64(vdupq_n_f64(SINE_C5), p, r2);
+    p = vfmaq_f64(vdupq_n_f64(SINE_C3), p, r2);
+    float64x2_t s = vfmaq_f64(r, vmulq_f64(r, r2), p);
+    float64x2_t half = vrndmq_f64(vmulq_n_f64(k, 0.5));
+    float64x2_t parity = vfmsq_f64(k, half, vTwo);
+    float64x2_t sign = vfmsq_f64(vOne, parity, vTwo);
+    vst1q_f64(out + i, vmulq_n_f64(vmulq_f64(s, sign), amplitude));
+    vIndex = vaddq_f64(vIndex, vLanes);
+  }
+  for (; i < count; ++i) out[i] = amplitude * sinePoly(phase0 + i * step);
+}
+#endif  // SINE_KERNEL_NEON
+
+/**
+ * @brief Bloco com frequência e amplitude variando linearmente (rampas).
+ *
+ * Com passo de fase step0 + i * dstep na amostra i, a fase acumulada é
+ * phase0 + i * step0 + dstep * i * (i - 1) / 2, de novo sem dependência
+ * serial; a amplitude é amp0 + i * damp. Usa a mesma aproximação de
+ * sinePoly; rampas são transitórias, então não há variante SIMD.
+ */
+inline void sineBlockRamp(double* out, size_t count, double phase0,
+                          double step0, double dstep, double amp0,
+                          double damp) {
+  for (size_t i = 0; i < count; ++i) {
+    double n = static_cast<double>(i);
+    double phase = phase0 + n * step0 + 0.5 * n * (n - 1.0) * dstep;
+    out[i] = (amp0 + n * damp) * sinePoly(phase);
+  }
+}
+
+// Retorna o kernel pedido, ou nullptr se a CPU/compilação não o suporta.
+inline SineKernelFn sineKernelFor(SineKernelType type) {
+  switch (type) {
+    case KERNEL_REFERENCE:
+      return sineBlockReference;
+    case KERNEL_SCALAR:
+      return sineBlockScalar;
+#ifdef SINE_KERNEL_X86
+    case KERNEL_AVX2:
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return sineBlockAvx2;
+      }
+      return nullptr;
+    case KERNEL_AVX512:
+      if (__builtin_cpu_supports("avx512f")) return sineBlockAvx512;
+      return nullptr;
+#endif
+#ifdef SINE_KERNEL_NEON
+    case KERNEL_NEON:
+      return sineBlockNeon;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+// Melhor kernel disponível nesta máquina (resolvido uma única vez)
+inline SineKernelFn sineKernelBest() {
+  static const SineKernelFn best = [] {
+    const SineKernelType preferred[] = {KERNEL_AVX512, KERNEL_AVX2,
+                                        KERNEL_NEON, KERNEL_SCALAR};
+    for (SineKernelType type : preferred) {
+      if (SineKernelFn fn = sineKernelFor(type)) return fn;
+    }
+    return sineBlockScalar;
+  }();
+  return best;
+}
+
+// Ponto de entrada com despacho em tempo de execução
+inline void sineBlock(double* out, size_t count, double phase0, double step,
+                      double amplitude) {
+  sineKernelBest()(out, count, phase0, step, amplitude);
+}
+
+#endif  // SINE_KERNEL_HPP
@@ -0,0 +1,186 @@
+#ifndef SPECTRUM_ANALYZER_HPP
+#define SPECTRUM_ANALYZER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "FFT.hpp"
+
+/**
+ * @file SpectrumAnalyzer.hpp
+ * @brief Espectro de magnitude contínuo: FFT janelada (Hann) com
+ * sobreposição, retenção de pico e medidas da componente principal.
+ *
+ * As amostras entram uma vez, em qualquer tamanho de bloco, numa janela
+ * circular de size() amostras; a cada `hop` amostras novas a janela inteira
+ * é transformada. Todo o trabalho é feito em buffers alocados no construtor.
+ *
+ * As magnitudes são lineares e normalizadas pelo ganho da janela: uma
+ * senoide de amplitude A num bin aparece com magnitude ~A (0 dBFS para
+ * A = 1). O pico retido decai `peakDecay` dB por quadro analisado.
+ */
+class SpectrumAnalyzer {
+ public:
+  static constexpr size_t MAX_HARMONICS = 10;  ///< Harmônicas usadas na THD
+
+  // Componente mais forte do espectro atual
+  struct Measurement {
+    double frequency;  ///< Hz, interpolada entre bins (0 se não há sinal)
+    double magnitude;  ///< Amplitude estimada (magnitude linear corrigida)
+    double thd;        ///< Distorção harmônica total (razão, não %)
+  };
+
+  // `size` precisa ser potência de 2; 0 < hop <= size
+  SpectrumAnalyzer(size_t size, size_t hop)
+      : m_fft(size),
+        m_hop(hop),
+        m_window(size),
+        m_input(size, 0.0),
+        m_work(size),
+        m_magnitude(size / 2 + 1, 0.0f),
+        m_peak(size / 2 + 1, 0.0f),
+        m_peakDecay(1.0f),
+        m_position(0),
+        m_filled(0),
+        m_sinceFrame(0),
+        m_frames(0) {
+    // Hann periódica; a soma normaliza a magnitude (ganho coerente)
+    double sum = 0.0;
+    for (size_t i = 0; i < size; ++i) {
+      m_window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * static_cast<double>(i) / size);
+      sum += m_window[i];
+    }
+    for (double& w : m_window) w *= 2.0 / sum;
+  }
+
+  size_t size() const { return m_fft.size(); }
+  size_t hop() const { return m_hop; }
+  size_t bins() const { return m_magnitude.size(); }
+  uint64_t frames() const { return m_frames; }  ///< Quadros já analisados
+
+  // Decaimento do pico retido, em dB por quadro analisado
+  void setPeakDecay(double decibelsPerFrame) {
+    m_peakDecay = static_cast<float>(pow(10.0, -decibelsPerFrame / 20.0));
+  }
+
+  // Descarta a janela e o espectro (ex.: mudança de taxa de amostragem)
+  void reset() {
+    std::fill(m_input.begin(), m_input.end(), 0.0);
+    std::fill(m_magnitude.begin(), m_magnitude.end(), 0.0f);
+    std::fill(m_peak.begin(), m_peak.end(), 0.0f);
+    m_position = m_filled = m_sinceFrame = 0;
+  }
+
+  // Acrescenta `count` amostras; retorna quantos quadros foram analisados
+  size_t push(const double* samples, size_t count) {
+    size_t analyzed = 0;
+    for (size_t i = 0; i < count; ++i) {
+      m_input[m_position] = samples[i];
+      m_position = (m_position + 1) & (size() - 1);
+      if (m_filled < size()) ++m_filled;
+      if (++m_sinceFrame >= m_hop && m_filled == size()) {
+        m_sinceFrame = 0;
+        analyze();
+        ++analyzed;
+      }
+    }
+    return analyzed;
+  }
+
+  const std::vector<float>& magnitude() const { return m_magnitude; }
+  const std::vector<float>& peak() const { return m_peak; }
+
+  // Componente principal (ignorando DC) interpolada e a THD em relação a ela
+  Measurement measure(double sampleRate) const {
+    Measurement result = {0.0, 0.0, 0.0};
+    size_t strongest = 0;
+    for (size_t k = 2; k + 1 < bins(); ++k) {
+      if (m_magnitude[k] > result.magnitude) {
+        result.magnitude = m_magnitude[k];
+        strongest = k;
+      }
+    }
+    if (strongest == 0 || result.magnitude <= 0.0) return result;
+
+    // Estimador exato para a Hann (Grandke): com α = razão entre o maior
+    // vizinho e o máximo, o deslocamento é (2α - 1) / (α + 1) bins. A
+    // magnitude é corrigida pela resposta da janela nesse deslocamento
+    double center = m_magnitude[strongest];
+    double left = m_magnitude[strongest - 1];
+    double right = m_magnitude[strongest + 1];
+    double alpha = std::max(left, right) / center;
+    double delta = std::max(0.0, (2.0 * alpha - 1.0) / (alpha + 1.0));
+    if (delta > 0.0) {
+      double sinc = sin(M_PI * delta) / (M_PI * delta);
+      result.magnitude = center * (1.0 - delta * delta) / sinc;
+    }
+    double binHz = sampleRate / size();
+    double offset = right >= left ? delta : -delta;
+    result.frequency = (strongest + offset) * binHz;
+
+    // Energia de cada harmônica somada no lóbulo principal da Hann (±2 bins)
+    double fundamental = bandPower(strongest);
+    double harmonics = 0.0;
+    for (size_t h = 2; h <= MAX_HARMONICS; ++h) {
+      double bin = h * result.frequency / binHz;
+      if (bin + 2.0 >= bins()) break;
+      harmonics += bandPower(static_cast<size_t>(lround(bin)));
+    }
+    result.thd = fundamental > 0.0 ? sqrt(harmonics / fundamental) : 0.0;
+    return result;
+  }
+
+  // Magnitude linear em dBFS (limitada em -200 dB para o silêncio)
+  static double decibels(double magnitude) {
+    return 20.0 * log10(std::max(magnitude, 1e-10));
+  }
+
+ private:
+  FFT m_fft;
+  size_t m_hop;                  // Amostras novas entre quadros
+  std::vector<double> m_window;  // Hann já normalizada
+  std::vector<double> m_input;   // Janela circular de entrada
+  std::vector<std::complex<double>> m_work;  // Buffer da FFT in-place
+  std::vector<float> m_magnitude;  // Espectro do último quadro
+  std::vector<float> m_peak;       // Pico retido por bin
+  float m_peakDecay;               // Fator linear aplicado ao pico por quadro
+  size_t m_position;    // Próxima escrita em m_input (a mais antiga)
+  size_t m_filled;      // Amostras válidas em m_input
+  size_t m_sinceFrame;  // Amostras desde o último quadro
+  uint64_t m_frames;
+
+  void analyze() {
+    // Desenrola a janela circular da amostra mais antiga para a mais nova
+    size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+      m_work[i] = m_input[(m_position + i) & (n - 1)] * m_window[i];
+    }
+    m_fft.forward(m_work.data());
+
+    // Sinal real: o espectro é simétrico, bins 0..N/2 bastam. DC e Nyquist
+    // não têm o par espelhado e ficam com metade do ganho
+    for (size_t k = 0; k < bins(); ++k) {
+      float magnitude = static_cast<float>(std::abs(m_work[k]));
+      if (k == 0 || k == n / 2) magnitude *= 0.5f;
+      m_magnitude[k] = magnitude;
+      m_peak[k] = std::max(magnitude, m_peak[k] * m_peakDecay);
+    }
+    ++m_frames;
+  }
+
+  double bandPower(size_t bin) const {
+    double power = 0.0;
+    size_t first = bin >= 2 ? bin - 2 : 0;
+    size_t last = std::min(bin + 2, bins() - 1);
+    for (size_t k = first; k <= last; ++k) {
+      power += static_cast<double>(m_magnitude[k]) * m_magnitude[k];
+    }
+    return power;
+  }
+};
+
+#endif  // SPECTRUM_ANALYZER_HPP
@@ -0,0 +1,61 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "Communication.hpp"
+
+/**
+ * @class SpscQueue
+ * @brief Fila circular sem locks de um produtor e um consumidor.
+ *
+ * Capacidade fixa (potência de 2) alocada junto com o objeto; push() e
+ * pop() nunca bloqueiam nem alocam. Os índices são contadores de 64 bits
+ * (não dão a volta), cada um na sua linha de cache.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "Capacidade da fila precisa ser potência de 2");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SpscQueue guarda apenas tipos trivialmente copiáveis");
+
+ public:
+  SpscQueue() : m_head(0), m_tail(0) {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Produtor: copia `item` para a fila; false se estiver cheia
+  bool push(const T& item) {
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) == Capacity) return false;
+    m_items[head & (Capacity - 1)] = item;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumidor: retira o item mais antigo; false se estiver vazia
+  bool pop(T& item) {
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) return false;
+    item = m_items[tail & (Capacity - 1)];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return m_tail.load(std::memory_order_acquire) ==
+           m_head.load(std::memory_order_acquire);
+  }
+
+ private:
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_head;  // Próxima escrita
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_tail;  // Próxima leitura
+  alignas(CACHE_LINE_SIZE) T m_items[Capacity];
+};
+
+#endif  // SPSC_QUEUE_HPP
@@ -0,0 +1,136 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file Telemetry.hpp
+ * @brief Contadores e histogramas de saúde do pipeline, mantidos no próprio
+ * segmento compartilhado.
+ *
+ * Tudo aqui é atômico de 64 bits e de escritor único (relaxed load + store,
+ * sem RMW no caminho quente, exceto onde indicado): uma ferramenta externa
+ * mapeia o segmento somente leitura e raspa os valores a qualquer momento,
+ * sem locks e sem pausar ninguém. Leituras de campos diferentes não formam um
+ * instantâneo consistente, mas cada campo é sempre um valor válido.
+ *
+ * - ProducerTelemetry fica no cabeçalho do SharedBuffer e só o produtor
+ *   escreve nele.
+ * - ConsumerSlot fica numa página própria do segmento (ver
+ *   SharedBuffer::consumersOffset), a única que os consumidores mapeiam com
+ *   escrita; cada consumidor registrado atualiza só o seu slot. O atraso de
+ *   um consumidor é head - tail.
+ * - O contador de leitores bloqueados em frameSeq fica na mesma página,
+ *   após os slots (ver SharedBuffer::frameWaiters()).
+ */
+
+constexpr size_t TELEMETRY_BUCKETS = 32;  ///< Faixas log2 em nanossegundos
+constexpr size_t MAX_CONSUMERS = 16;      ///< Slots de consumidores
+constexpr size_t CONSUMER_NAME_SIZE = 16;  ///< Nome com terminador
+
+// Relógio monotônico em nanossegundos (mesmo relógio no processo todo)
+inline uint64_t monotonicNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL +
+         static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @struct TelemetryHistogram
+ * @brief Histograma log2 de durações: a faixa b conta valores em
+ * [2^b, 2^(b+1)) ns (a 0 inclui o zero, a última tudo acima de ~1 s).
+ */
+struct TelemetryHistogram {
+  std::atomic<uint64_t> buckets[TELEMETRY_BUCKETS];  ///< Contagem por faixa
+  std::atomic<uint64_t> count;  ///< Total de amostras
+  std::atomic<uint64_t> sumNs;  ///< Soma (média = sumNs / count)
+  std::atomic<uint64_t> maxNs;  ///< Maior valor visto
+
+  static size_t bucketFor(uint64_t ns) {
+    if (ns == 0) return 0;
+    size_t bucket = static_cast<size_t>(63 - __builtin_clzll(ns));
+    return bucket < TELEMETRY_BUCKETS ? bucket : TELEMETRY_BUCKETS - 1;
+  }
+
+  // Só o dono do histograma chama (escritor único)
+  void record(uint64_t ns) {
+    std::atomic<uint64_t>& bucket = buckets[bucketFor(ns)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+    count.store(count.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+    sumNs.store(sumNs.load(std::memory_order_relaxed) + ns,
+                std::memory_order_relaxed);
+    if (ns > maxNs.load(std::memory_order_relaxed)) {
+      maxNs.store(ns, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Limite superior (ns) da faixa que contém o percentil `p` (0..1),
+   * sem passar do máximo visto; 0 sem amostras. A resolução é a das faixas
+   * (fator 2).
+   */
+  uint64_t percentileNs(double p) const {
+    uint64_t total = count.load(std::memory_order_relaxed);
+    uint64_t max = maxNs.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(p * (total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < TELEMETRY_BUCKETS; ++b) {
+      seen += buckets[b].load(std::memory_order_relaxed);
+      if (seen >= rank) return std::min<uint64_t>((2ULL << b) - 1, max);
+    }
+    return max;
+  }
+};
+
+/**
+ * @struct ProducerTelemetry
+ * @brief Estado do produtor (gerador), atualizado a cada quadro de relógio.
+ */
+struct ProducerTelemetry {
+  std::atomic<uint64_t> samplesProduced;  ///< Amostras publicadas (× canais)
+  std::atomic<uint64_t> framesRendered;   ///< Quadros de relógio gerados
+  std::atomic<uint64_t> framesSkipped;    ///< Quadros perdidos por atraso
+  std::atomic<uint64_t> commandsApplied;  ///< Comandos aceitos
+  // Comandos recusados (fila cheia, lote inválido); mais de uma thread
+  // incrementa, então este usa fetch_add
+  std::atomic<uint64_t> commandsDropped;
+  std::atomic<uint64_t> updatedNs;  ///< monotonicNs() da última atualização
+  TelemetryHistogram framePeriodJitter;  ///< |período real - nominal|
+  TelemetryHistogram generateTime;       ///< Renderização de um quadro
+  TelemetryHistogram copyTime;           ///< Publicação no anel (RingWriter)
+};
+
+/**
+ * @struct ConsumerSlot
+ * @brief Estado de um consumidor registrado (pid 0 = slot livre).
+ *
+ * O slot é tomado por CAS em `pid`; slots de processos que morreram sem se
+ * desregistrar são reaproveitados no próximo registro.
+ */
+struct alignas(64) ConsumerSlot {
+  std::atomic<uint32_t> pid;     ///< Dono do slot (0 = livre)
+  char name[CONSUMER_NAME_SIZE];  ///< Ex.: "viewer", "recorder"
+  std::atomic<uint64_t> tail;    ///< Próximo quadro a ler (lag = head - tail)
+  std::atomic<uint64_t> samplesConsumed;  ///< Amostras entregues
+  std::atomic<uint64_t> framesLost;   ///< Quadros perdidos por overrun
+  std::atomic<uint64_t> overruns;     ///< Eventos de overrun
+  std::atomic<uint64_t> updatedNs;    ///< monotonicNs() da última leitura
+};
+
+constexpr size_t CONSUMER_TABLE_BYTES = 4096;  ///< Uma página
+// Leitores dormindo em frameSeq: logo após os slots, na mesma página
+constexpr size_t FRAME_WAITERS_OFFSET = sizeof(ConsumerSlot) * MAX_CONSUMERS;
+static_assert(FRAME_WAITERS_OFFSET + sizeof(std::atomic<uint32_t>) <=
+                  CONSUMER_TABLE_BYTES,
+              "A tabela de consumidores precisa caber numa página");
+
+#endif  // TELEMETRY_HPP
@@ -0,0 +1,39 @@
+#ifndef TOOL_SUPPORT_HPP
+#define TOOL_SUPPORT_HPP
+
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @file ToolSupport.hpp
+ * @brief Utilitários comuns aos binários de src/: leitura de argumentos
+ * numéricos e sinalização por eventfd entre threads.
+ */
+
+// Converte um argumento numérico; retorna false se inválido
+inline bool parseNumber(const char* text, double& value) {
+  try {
+    size_t used;
+    value = std::stod(text, &used);
+    return text[used] == '\0';
+  } catch (...) {
+    return false;
+  }
+}
+
+// Sinaliza/consome um eventfd usado para acordar a outra thread
+inline void notify(int fd) {
+  uint64_t one = 1;
+  ssize_t written = write(fd, &one, sizeof(one));
+  (void)written;  // Contador saturado já acorda o leitor
+}
+inline void drain(int fd) {
+  uint64_t count;
+  ssize_t got = read(fd, &count, sizeof(count));
+  (void)got;  // EAGAIN: nada pendente
+}
+
+#endif  // TOOL_SUPPORT_HPP
@@ -0,0 +1,76 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class TripleBuffer
+ * @brief Troca sem locks do valor mais recente entre um produtor e um
+ * consumidor.
+ *
+ * Três instâncias de T: o produtor escreve em back() e chama publish(); o
+ * consumidor chama update() e lê front() diretamente, sem cópia. A terceira
+ * instância fica "no meio" e é trocada atomicamente (um índice de 2 bits e
+ * um bit de novidade numa palavra), então nenhum lado espera pelo outro e o
+ * consumidor nunca vê um valor sendo escrito. Valores intermediários podem
+ * ser pulados: só o último publicado interessa.
+ *
+ * T é reaproveitado: com buffers pré-alocados (ex.: vetores com capacidade
+ * fixa, ou blocos de uma arena entregues por instance()) publicar não aloca
+ * nada.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  explicit TripleBuffer(const T& initial = T())
+      : m_buffers{initial, initial, initial},
+        m_middle(1),
+        m_front(0),
+        m_back(2) {}
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  static constexpr size_t INSTANCES = 3;  ///< Instâncias de T
+
+  // Instância `index` (< INSTANCES), para preparar cada uma antes de
+  // produtor e consumidor começarem (ex.: apontar para memórias distintas)
+  T& instance(size_t index) { return m_buffers[index]; }
+
+  // --- Produtor ---
+
+  // Buffer livre para escrita (conteúdo antigo, de duas publicações atrás)
+  T& back() { return m_buffers[m_back]; }
+
+  // Entrega back() ao consumidor e recebe outro buffer livre
+  void publish() {
+    uint8_t old = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel);
+    m_back = old & INDEX_MASK;
+  }
+
+  // --- Consumidor ---
+
+  // Passa a ler o último valor publicado; false se não houve publicação
+  bool update() {
+    if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) return false;
+    uint8_t old = m_middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front = old & INDEX_MASK;
+    return true;
+  }
+
+  // Valor atual do consumidor (estável até o próximo update())
+  const T& front() const { return m_buffers[m_front]; }
+
+ private:
+  static constexpr uint8_t INDEX_MASK = 0x3;
+  static constexpr uint8_t FRESH = 0x4;  // Meio contém valor não lido
+
+  T m_buffers[INSTANCES];
+  std::atomic<uint8_t> m_middle;  // Índice do buffer do meio | FRESH
+  uint8_t m_front;                // Só o consumidor acessa
+  uint8_t m_back;                 // Só o produtor acessa
+};
+
+#endif  // TRIPLE_BUFFER_HPP
@@ -0,0 +1,172 @@
+#ifndef WAV_FORMAT_HPP
+#define WAV_FORMAT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "SampleFormat.hpp"
+
+/**
+ * @file WavFormat.hpp
+ * @brief Cabeçalho RIFF/WAVE: escrita de tamanho fixo para gravação em
+ * blocos alinhados e leitura para reprodução.
+ *
+ * O cabeçalho ocupa exatamente WAV_HEADER_BYTES: RIFF, um `fmt ` no formato
+ * WAVE_FORMAT_EXTENSIBLE (vale para qualquer número de canais e para float),
+ * um chunk `JUNK` de preenchimento e o cabeçalho do chunk `data`. As
+ * amostras começam num offset alinhado a página, o que permite escrever o
+ * arquivo inteiro com O_DIRECT e reescrever o cabeçalho no lugar ao final.
+ */
+
+constexpr size_t WAV_HEADER_BYTES = 4096;  ///< Início das amostras no arquivo
+
+/// Maior chunk `data` representável (tamanhos RIFF são de 32 bits)
+constexpr uint64_t WAV_MAX_DATA_BYTES = 0xFFFFFFFFull - WAV_HEADER_BYTES;
+
+namespace wav_detail {
+
+inline void put16(unsigned char* out, uint16_t value) {
+  out[0] = static_cast<unsigned char>(value);
+  out[1] = static_cast<unsigned char>(value >> 8);
+}
+
+inline void put32(unsigned char* out, uint32_t value) {
+  put16(out, static_cast<uint16_t>(value));
+  put16(out + 2, static_cast<uint16_t>(value >> 16));
+}
+
+inline void putTag(unsigned char* out, const char* tag) { memcpy(out, tag, 4); }
+
+inline uint16_t get16(const unsigned char* in) {
+  return static_cast<uint16_t>(in[0] | in[1] << 8);
+}
+
+inline uint32_t get32(const unsigned char* in) {
+  return get16(in) | static_cast<uint32_t>(get16(in + 2)) << 16;
+}
+
+}  // namespace wav_detail
+
+/**
+ * @brief Escreve WAV_HEADER_BYTES bytes de cabeçalho em `out`.
+ *
+ * `dataBytes` é o tamanho do chunk `data` (limitado a WAV_MAX_DATA_BYTES);
+ * durante a gravação pode ser 0 e ser corrigido ao fechar o arquivo.
+ */
+inline void buildWavHeader(unsigned char* out, SampleFormat format,
+                           uint32_t channels, double sampleRate,
+                           uint64_t dataBytes) {
+  using namespace wav_detail;
+  const uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+  const size_t FMT_BYTES = 40;  // Corpo do `fmt ` extensível
+  const size_t JUNK_OFFSET = 12 + 8 + FMT_BYTES;
+  const size_t DATA_OFFSET = WAV_HEADER_BYTES - 8;
+
+  if (dataBytes > WAV_MAX_DATA_BYTES) dataBytes = WAV_MAX_DATA_BYTES;
+  uint32_t sampleBytes = static_cast<uint32_t>(sampleFormatSize(format));
+  uint32_t rate = static_cast<uint32_t>(std::lround(sampleRate));
+  uint16_t blockAlign = static_cast<uint16_t>(channels * sampleBytes);
+  bool isFloat = format == FORMAT_F64 || format == FORMAT_F32;
+
+  memset(out, 0, WAV_HEADER_BYTES);
+  putTag(out, "RIFF");
+  put32(out + 4, static_cast<uint32_t>(WAV_HEADER_BYTES - 8 + dataBytes));
+  putTag(out + 8, "WAVE");
+
+  unsigned char* fmt = out + 12;
+  putTag(fmt, "fmt ");
+  put32(fmt + 4, FMT_BYTES);
+  put16(fmt + 8, FORMAT_EXTENSIBLE);
+  put16(fmt + 10, static_cast<uint16_t>(channels));
+  put32(fmt + 12, rate);
+  put32(fmt + 16, rate * blockAlign);
+  put16(fmt + 20, blockAlign);
+  put16(fmt + 22, static_cast<uint16_t>(sampleBytes * 8));
+  put16(fmt + 24, 22);  // Bytes da extensão
+  put16(fmt + 26, static_cast<uint16_t>(sampleBytes * 8));  // Bits válidos
+  put32(fmt + 28, 0);  // Sem mapa de alto-falantes
+  // GUID do subformato: 0000000X-0000-0010-8000-00AA00389B71
+  static const unsigned char GUID_TAIL[14] = {0x00, 0x00, 0x00, 0x00, 0x10,
+                                              0x00, 0x80, 0x00, 0x00, 0xAA,
+                                              0x00, 0x38, 0x9B, 0x71};
+  put16(fmt + 32, isFloat ? 3 : 1);  // IEEE float ou PCM
+  memcpy(fmt + 34, GUID_TAIL, sizeof(GUID_TAIL));
+
+  putTag(out + JUNK_OFFSET, "JUNK");
+  put32(out + JUNK_OFFSET + 4,
+        static_cast<uint32_t>(DATA_OFFSET - JUNK_OFFSET - 8));
+
+  putTag(out + DATA_OFFSET, "data");
+  put32(out + DATA_OFFSET + 4, static_cast<uint32_t>(dataBytes));
+}
+
+// Descrição das amostras de um arquivo WAV existente
+struct WavInfo {
+  SampleFormat format;  ///< Formato de cada amostra
+  uint32_t channels;    ///< Canais intercalados por quadro
+  double sampleRate;    ///< Hz
+  size_t dataOffset;    ///< Início do chunk `data` no arquivo
+  uint64_t dataBytes;   ///< Tamanho do chunk `data` (limitado ao arquivo)
+};
+
+/**
+ * @brief Interpreta o cabeçalho de um WAV mapeado em `data` (`size` bytes).
+ *
+ * Aceita PCM de 16/24 bits e float de 32/64 bits, no `fmt ` simples ou
+ * extensível; chunks desconhecidos são pulados. Um tamanho de `data` maior
+ * que o arquivo (gravação interrompida) é limitado ao que existe. Retorna
+ * false e preenche `error` se o arquivo não puder ser reproduzido.
+ */
+inline bool parseWavHeader(const unsigned char* data, size_t size,
+                           WavInfo& info, const char*& error) {
+  using namespace wav_detail;
+  error = nullptr;
+  if (size < 12 || memcmp(data, "RIFF", 4) != 0 ||
+      memcmp(data + 8, "WAVE", 4) != 0) {
+    error = "Not a WAV file";
+    return false;
+  }
+
+  bool haveFormat = false;
+  size_t position = 12;
+  while (position + 8 <= size) {
+    const unsigned char* chunk = data + position;
+    uint64_t chunkBytes = get32(chunk + 4);
+    if (memcmp(chunk, "fmt ", 4) == 0 && chunkBytes >= 16 &&
+        position + 8 + 16 <= size) {
+      uint16_t tag = get16(chunk + 8);
+      if (tag == 0xFFFE && chunkBytes >= 40 && position + 8 + 40 <= size) {
+        tag = get16(chunk + 32);  // Subformato do fmt extensível
+      }
+      uint16_t bits = get16(chunk + 22);
+      if (tag == 1 && bits == 16) {
+        info.format = FORMAT_S16;
+      } else if (tag == 1 && bits == 24) {
+        info.format = FORMAT_S24;
+      } else if (tag == 3 && bits == 32) {
+        info.format = FORMAT_F32;
+      } else if (tag == 3 && bits == 64) {
+        info.format = FORMAT_F64;
+      } else {
+        error = "Unsupported WAV sample format";
+        return false;
+      }
+      info.channels = get16(chunk + 10);
+      info.sampleRate = get32(chunk + 12);
+      haveFormat = info.channels > 0 && info.sampleRate > 0.0;
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      if (!haveFormat) break;
+      info.dataOffset = position + 8;
+      info.dataBytes = std::min<uint64_t>(chunkBytes, size - info.dataOffset);
+      return true;
+    }
+    position += 8 + chunkBytes + (chunkBytes & 1);  // Chunks têm tamanho par
+  }
+  error = haveFormat ? "WAV file has no data chunk" : "Invalid WAV header";
+  return false;
+}
+
+#endif  // WAV_FORMAT_HPP
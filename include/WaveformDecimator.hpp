@@ -0,0 +1,41 @@
+#ifndef WAVEFORM_DECIMATOR_HPP
+#define WAVEFORM_DECIMATOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+/**
+ * @file WaveformDecimator.hpp
+ * @brief Redução de um trecho de amostras a uma coluna de min/max por pixel.
+ *
+ * Desenhar a extensão (mínimo e máximo) de cada coluna preserva picos e
+ * envoltória para qualquer número de amostras por pixel, ao contrário de
+ * pular amostras. O traço resultante tem 2 pontos por coluna: o custo de
+ * desenho passa a depender só da largura da janela.
+ */
+
+// Extensão vertical das amostras que caem numa coluna
+struct ColumnExtent {
+  double min;
+  double max;
+};
+
+/**
+ * @brief Preenche `columns` colunas com o min/max de `samples[0, count)`.
+ *
+ * A coluna x cobre as amostras [x * count / columns, (x + 1) * count /
+ * columns); as faixas vizinhas compartilham a amostra da fronteira para o
+ * traço ficar contínuo. Requer count >= columns >= 1 (com menos amostras
+ * que colunas o chamador desenha as amostras diretamente).
+ */
+inline void decimateMinMax(const double* samples, size_t count,
+                           ColumnExtent* out, size_t columns) {
+  for (size_t x = 0; x < columns; ++x) {
+    size_t begin = x * count / columns;
+    size_t end = std::min(count, (x + 1) * count / columns + 1);
+    auto [low, high] = std::minmax_element(samples + begin, samples + end);
+    out[x] = {*low, *high};
+  }
+}
+
+#endif  // WAVEFORM_DECIMATOR_HPP
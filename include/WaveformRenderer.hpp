@@ -0,0 +1,155 @@
+#ifndef WAVEFORM_RENDERER_HPP
+#define WAVEFORM_RENDERER_HPP
+
+#include <cairomm/cairomm.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "WaveformDecimator.hpp"
+
+constexpr int PLOT_MARGIN = 20;    // Margem em pixels em volta da área do traço
+constexpr int TIME_DIVISIONS = 4;  // Divisões horizontais da grade (tempo/div)
+
+// Janela de amostras pronta para desenhar (capacidade fixa, sem realocação)
+struct WaveSnapshot {
+  double* samples = nullptr;  // Memória reservada por quem publica
+  size_t count = 0;           // Amostras válidas em samples
+  bool triggered = false;     // Janela alinhada num disparo
+  size_t triggerIndex = 0;    // Amostra do disparo dentro da janela
+  double triggerLevel = 0.0;  // Nível usado no disparo
+};
+
+/**
+ * @class WaveformRenderer
+ * @brief Desenha uma WaveSnapshot (fundo, grade, traço e marcas do disparo)
+ * em qualquer contexto Cairo.
+ *
+ * Só depende do cairomm: o mesmo código roda no canvas do viewer e em
+ * superfícies fora da tela (bench). Guarda o buffer de colunas da decimação
+ * para não alocar por quadro.
+ */
+class WaveformRenderer {
+ public:
+  /**
+   * @brief Desenha um quadro completo em `width` x `height` pixels.
+   *
+   * Retorna false, com só o fundo pintado, se a janela tem menos de duas
+   * amostras; quem chama decide o que mostrar nesse caso.
+   */
+  bool draw(const Cairo::RefPtr<Cairo::Context>& cr, int width, int height,
+            const WaveSnapshot& snapshot) {
+    // Fundo preto
+    cr->set_source_rgb(0, 0, 0);
+    cr->paint();
+    if (snapshot.count < 2) return false;
+
+    // Desenha grade de referência (linhas horizontais e verticais), toda
+    // num só caminho
+    cr->set_source_rgba(0, 0.5, 0, 0.2);  // Verde transparente
+    cr->set_line_width(0.5);
+
+    // Linha central (zero)
+    int centerY = height / 2;
+    cr->move_to(PLOT_MARGIN, centerY);
+    cr->line_to(width - PLOT_MARGIN, centerY);
+
+    // Linhas horizontais de referência (amplitudes ±1/3 e ±2/3)
+    for (int i = -2; i <= 2; i += 2) {
+      double y = centerY + i * (static_cast<double>(height) / 6);
+      cr->move_to(PLOT_MARGIN, y);
+      cr->line_to(width - PLOT_MARGIN, y);
+    }
+
+    // Linhas verticais de referência (divisões de tempo)
+    for (int i = 0; i <= TIME_DIVISIONS; i++) {
+      double plotSpan = width - 2 * PLOT_MARGIN;
+      double x = PLOT_MARGIN + i * plotSpan / TIME_DIVISIONS;
+      cr->move_to(x, PLOT_MARGIN);
+      cr->line_to(x, height - PLOT_MARGIN);
+    }
+    cr->stroke();
+
+    // Desenha a forma de onda: um único caminho e um único stroke, recortado
+    // nas margens pelo Cairo (em vez de limitar cada ponto)
+    cr->set_source_rgb(0, 1, 0);  // Verde brilhante
+    cr->set_line_width(2);
+
+    double plotWidth = width - 2 * PLOT_MARGIN;
+    double verticalScale =
+        (height - 60) / 2.0;  // Escala vertical (reserva margem de 30px)
+    if (plotWidth < 1.0) return true;
+
+    cr->save();
+    cr->rectangle(PLOT_MARGIN, PLOT_MARGIN, plotWidth,
+                  height - 2 * PLOT_MARGIN);
+    cr->clip();
+    traceWaveform(cr, snapshot.samples, snapshot.count, PLOT_MARGIN,
+                  plotWidth, centerY, verticalScale);
+    cr->stroke();
+    cr->restore();
+
+    // Marcas do disparo: nível na margem esquerda, instante na superior
+    if (snapshot.triggered) {
+      double x = PLOT_MARGIN + plotWidth * snapshot.triggerIndex /
+                                   static_cast<double>(snapshot.count - 1);
+      double y = centerY - snapshot.triggerLevel * verticalScale;
+      cr->set_source_rgb(1, 0.6, 0);  // Laranja
+      cr->set_line_width(2);
+      cr->move_to(PLOT_MARGIN - 10, y);
+      cr->line_to(PLOT_MARGIN, y);
+      cr->move_to(x, PLOT_MARGIN - 10);
+      cr->line_to(x, PLOT_MARGIN);
+      cr->stroke();
+    }
+    return true;
+  }
+
+ private:
+  std::vector<ColumnExtent> m_columns;  // Min/max por coluna (reaproveitado)
+
+  /**
+   * Monta o traço inteiro como um único caminho. Com até duas amostras por
+   * pixel liga as amostras diretamente; acima disso cada coluna vira um
+   * segmento vertical entre o mínimo e o máximo das amostras que ela cobre,
+   * então o número de pontos (e o custo do stroke) depende só da largura.
+   */
+  void traceWaveform(const Cairo::RefPtr<Cairo::Context>& cr,
+                     const double* samples, size_t n, double left,
+                     double plotWidth, double centerY, double verticalScale) {
+    size_t columns = std::max<size_t>(1, static_cast<size_t>(plotWidth));
+
+    if (n <= 2 * columns) {
+      double stepX = plotWidth / (n - 1);  // Espaçamento entre pontos
+      cr->move_to(left, centerY - samples[0] * verticalScale);
+      for (size_t i = 1; i < n; ++i) {
+        cr->line_to(left + i * stepX, centerY - samples[i] * verticalScale);
+      }
+      return;
+    }
+
+    m_columns.resize(columns);
+    decimateMinMax(samples, n, m_columns.data(), columns);
+    double stepX = plotWidth / columns;
+    double previous = samples[0];
+    for (size_t x = 0; x < columns; ++x) {
+      // Entra na coluna pelo extremo mais próximo do fim da anterior, para
+      // não riscar diagonais desnecessárias entre colunas
+      const ColumnExtent& extent = m_columns[x];
+      bool rising = previous - extent.min <= extent.max - previous;
+      double first = rising ? extent.min : extent.max;
+      double last = rising ? extent.max : extent.min;
+      double px = left + (x + 0.5) * stepX;
+      if (x == 0) {
+        cr->move_to(px, centerY - first * verticalScale);
+      } else {
+        cr->line_to(px, centerY - first * verticalScale);
+      }
+      cr->line_to(px, centerY - last * verticalScale);
+      previous = last;
+    }
+  }
+};
+
+#endif  // WAVEFORM_RENDERER_HPP
@@ -0,0 +1,178 @@
+#ifndef WAVETABLE_HPP
+#define WAVETABLE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "SineKernel.hpp"
+
+/**
+ * @file Wavetable.hpp
+ * @brief Tabelas de um ciclo com níveis mip de banda limitada.
+ *
+ * Cada forma de onda é sintetizada aditivamente (série de Fourier) em
+ * WAVETABLE_LEVELS níveis: o nível L contém apenas os harmônicos
+ * 1..(WAVETABLE_MAX_HARMONICS >> L). O oscilador escolhe, para cada bloco, o
+ * nível cujo harmônico mais alto fica abaixo de Nyquist, então ondas
+ * quadrada/dente de serra/triangular não geram aliasing em nenhuma
+ * frequência. O harmônico máximo do nível 0 é um quarto do tamanho da
+ * tabela, o que mantém o erro da interpolação baixo mesmo no topo da banda.
+ *
+ * Um nível ocupa WAVETABLE_SIZE doubles (16 KiB), com pontos de guarda nas
+ * duas pontas para a interpolação cúbica dispensar o wrap do índice.
+ */
+
+constexpr size_t WAVETABLE_SIZE = 2048;  ///< Amostras por ciclo (potência de 2)
+constexpr size_t WAVETABLE_GUARD = 1;    ///< Pontos de guarda antes de x[0]
+constexpr size_t WAVETABLE_STRIDE =
+    WAVETABLE_SIZE + 3;  ///< x[-1], x[0..N-1], x[N], x[N+1]
+constexpr size_t WAVETABLE_MAX_HARMONICS =
+    WAVETABLE_SIZE / 4;  ///< Harmônicos do nível 0
+constexpr size_t WAVETABLE_LEVELS = 10;  ///< 512, 256, ..., 1 harmônico(s)
+
+static_assert((WAVETABLE_MAX_HARMONICS >> (WAVETABLE_LEVELS - 1)) == 1,
+              "O último nível mip deve conter só a fundamental");
+
+// Formas de onda disponíveis
+enum Waveform {
+  WAVE_SINE,      ///< Senoide pura (um harmônico)
+  WAVE_SQUARE,    ///< Quadrada: harmônicos ímpares, 1/h
+  WAVE_SAW,       ///< Dente de serra: todos os harmônicos, 1/h
+  WAVE_TRIANGLE   ///< Triangular: harmônicos ímpares, 1/h², sinal alternado
+};
+
+inline const char* waveformName(Waveform waveform) {
+  switch (waveform) {
+    case WAVE_SQUARE:
+      return "square";
+    case WAVE_SAW:
+      return "saw";
+    case WAVE_TRIANGLE:
+      return "triangle";
+    default:
+      return "sine";
+  }
+}
+
+// Converte o nome usado na linha de comando; retorna false se desconhecido
+inline bool parseWaveform(const char* name, Waveform& waveform) {
+  const Waveform all[] = {WAVE_SINE, WAVE_SQUARE, WAVE_SAW, WAVE_TRIANGLE};
+  for (Waveform w : all) {
+    if (strcmp(name, waveformName(w)) == 0) {
+      waveform = w;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Coeficiente de sin(h·θ) na série de Fourier da forma de onda (pico ~1)
+inline double harmonicCoefficient(Waveform waveform, size_t h) {
+  switch (waveform) {
+    case WAVE_SQUARE:
+      return h % 2 ? 4.0 / (M_PI * h) : 0.0;
+    case WAVE_SAW:
+      return (h % 2 ? 2.0 : -2.0) / (M_PI * h);
+    case WAVE_TRIANGLE:
+      if (h % 2 == 0) return 0.0;
+      return (h % 4 == 1 ? 8.0 : -8.0) / (M_PI * M_PI * h * h);
+    default:
+      return h == 1 ? 1.0 : 0.0;
+  }
+}
+
+/**
+ * @class Wavetable
+ * @brief Conjunto imutável de níveis mip de uma forma de onda.
+ *
+ * Construída uma única vez por forma de onda (ver stock()) e compartilhada
+ * por todos os osciladores, que só a leem.
+ */
+class Wavetable {
+ public:
+  explicit Wavetable(Waveform waveform)
+      : m_samples(WAVETABLE_LEVELS * WAVETABLE_STRIDE, 0.0) {
+    std::vector<double> partial(WAVETABLE_SIZE);
+    double step = 2.0 * M_PI / WAVETABLE_SIZE;
+
+    for (size_t level = 0; level < WAVETABLE_LEVELS; ++level) {
+      double* table = m_samples.data() + level * WAVETABLE_STRIDE +
+                      WAVETABLE_GUARD;
+      size_t harmonics = WAVETABLE_MAX_HARMONICS >> level;
+
+      // Soma harmônico a harmônico usando o kernel de bloco vetorizado
+      for (size_t h = 1; h <= harmonics; ++h) {
+        double coefficient = harmonicCoefficient(waveform, h);
+        if (coefficient == 0.0) continue;
+        sineBlock(partial.data(), WAVETABLE_SIZE, 0.0, h * step, coefficient);
+        for (size_t i = 0; i < WAVETABLE_SIZE; ++i) table[i] += partial[i];
+      }
+
+      // Normaliza o pico (o fenômeno de Gibbs passa de 1 na quadrada)
+      double peak = 0.0;
+      for (size_t i = 0; i < WAVETABLE_SIZE; ++i) {
+        peak = std::max(peak, std::fabs(table[i]));
+      }
+      if (peak > 0.0) {
+        for (size_t i = 0; i < WAVETABLE_SIZE; ++i) table[i] /= peak;
+      }
+
+      // Pontos de guarda: cópias circulares para a interpolação
+      table[-1] = table[WAVETABLE_SIZE - 1];
+      table[WAVETABLE_SIZE] = table[0];
+      table[WAVETABLE_SIZE + 1] = table[1];
+    }
+  }
+
+  // Início (x[0]) do nível `level`; x[-1] e x[N], x[N+1] são válidos
+  const double* level(size_t level) const {
+    return m_samples.data() + level * WAVETABLE_STRIDE + WAVETABLE_GUARD;
+  }
+
+  /**
+   * @brief Nível mip sem aliasing para a razão `frequency / sampleRate`.
+   *
+   * Usa o nível mais rico cujo harmônico mais alto fique abaixo de Nyquist;
+   * acima de fs/2 só resta a fundamental (nível mais alto).
+   */
+  static size_t levelFor(double frequency, double sampleRate) {
+    double maxHarmonic = 0.5 * sampleRate / frequency;
+    size_t level = 0;
+    while (level + 1 < WAVETABLE_LEVELS &&
+           static_cast<double>(WAVETABLE_MAX_HARMONICS >> level) >
+               maxHarmonic) {
+      ++level;
+    }
+    return level;
+  }
+
+  // Tabelas de fábrica, construídas sob demanda e compartilhadas
+  static const Wavetable& stock(Waveform waveform) {
+    switch (waveform) {
+      case WAVE_SQUARE: {
+        static const Wavetable square(WAVE_SQUARE);
+        return square;
+      }
+      case WAVE_SAW: {
+        static const Wavetable saw(WAVE_SAW);
+        return saw;
+      }
+      case WAVE_TRIANGLE: {
+        static const Wavetable triangle(WAVE_TRIANGLE);
+        return triangle;
+      }
+      default: {
+        static const Wavetable sine(WAVE_SINE);
+        return sine;
+      }
+    }
+  }
+
+ private:
+  std::vector<double> m_samples;  // WAVETABLE_LEVELS níveis consecutivos
+};
+
+#endif  // WAVETABLE_HPP
@@ -0,0 +1,293 @@
+#ifndef WAVETABLE_GENERATOR_HPP
+#define WAVETABLE_GENERATOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "ISignalGenerator.hpp"
+#include "OscillatorControl.hpp"
+#include "Wavetable.hpp"
+
+/**
+ * @class WavetableGenerator
+ * @brief Oscilador por tabela (wavetable) com níveis mip de banda limitada.
+ *
+ * Alternativa ao SineGenerator para muitos canais e formas de onda não
+ * senoidais: cada amostra custa uma leitura interpolada de uma tabela que
+ * cabe no cache, em vez de uma avaliação polinomial completa. Funciona
+ * sempre em taxa de amostragem física (equivale ao MODE_PHYSICAL).
+ *
+ * A fase é um acumulador de ponto fixo de 64 bits em que 2^64 = um ciclo: o
+ * wrap é o próprio overflow inteiro, os 11 bits altos indexam a tabela e os
+ * 53 restantes dão a fração da interpolação, exata em double.
+ */
+class WavetableGenerator final : public ISignalGenerator {
+ public:
+  // Interpolação entre pontos da tabela
+  enum Interpolation {
+    INTERP_LINEAR,  ///< 2 pontos; suficiente para tabelas de banda limitada
+    INTERP_CUBIC    ///< 4 pontos (Hermite/Catmull-Rom), menos ruído
+  };
+
+ private:
+  OscillatorControl m_control;  // Frequência, amplitude e rampas (seqlock)
+  std::atomic<bool> m_running;  // Se o oscilador está gerando
+  std::atomic<Waveform> m_waveform;  // Forma de onda atual
+  std::atomic<Interpolation> m_interpolation;  // Interpolação atual
+  double m_sampleRate;  // Taxa de amostragem em Hz
+  uint64_t m_phase;     // Fase em ponto fixo (2^64 = um ciclo)
+
+  static constexpr double MIN_FREQ = 1.0;      // Limite inferior de frequência
+  static constexpr double MAX_FREQ = 22000.0;  // Limite superior de frequência
+
+  static constexpr int INDEX_SHIFT = 53;  // 64 - log2(WAVETABLE_SIZE)
+  static constexpr uint64_t FRACTION_MASK = (uint64_t(1) << INDEX_SHIFT) - 1;
+  static constexpr double FRACTION_SCALE = 1.0 / (FRACTION_MASK + 1.0);
+
+  static_assert(WAVETABLE_SIZE == uint64_t(1) << (64 - INDEX_SHIFT),
+                "INDEX_SHIFT precisa acompanhar WAVETABLE_SIZE");
+
+  // Converte uma fração de ciclo (qualquer valor real) para ponto fixo
+  static uint64_t toFixedPhase(double cycles) {
+    cycles -= std::floor(cycles);
+    double scaled = std::ldexp(cycles, 64);
+    return scaled >= 0x1p64 ? 0 : static_cast<uint64_t>(scaled);
+  }
+
+  // Leitura com interpolação linear entre x[i] e x[i+1]
+  static double lookupLinear(const double* table, size_t i, double t) {
+    return table[i] + t * (table[i + 1] - table[i]);
+  }
+
+  // Leitura com interpolação cúbica de Hermite (usa x[i-1] .. x[i+2])
+  static double lookupCubic(const double* table, size_t i, double t) {
+    double xm1 = table[i - 1], x0 = table[i], x1 = table[i + 1],
+           x2 = table[i + 2];
+    double c1 = 0.5 * (x1 - xm1);
+    double c2 = xm1 - 2.5 * x0 + 2.0 * x1 - 0.5 * x2;
+    double c3 = 0.5 * (x2 - xm1) + 1.5 * (x0 - x1);
+    return ((c3 * t + c2) * t + c1) * t + x0;
+  }
+
+  // Preenche o bloco: posição calculada do índice, sem dependência serial
+  template <double (*Lookup)(const double*, size_t, double)>
+  void render(double* out, size_t count, const double* table, uint64_t step,
+              double amplitude) const {
+    for (size_t i = 0; i < count; ++i) {
+      uint64_t phase = m_phase + i * step;  // Wrap módulo 2^64 = um ciclo
+      double t = (phase & FRACTION_MASK) * FRACTION_SCALE;
+      out[i] = amplitude * Lookup(table, phase >> INDEX_SHIFT, t);
+    }
+  }
+
+  // Variante com rampas: passo step + i * stepDelta e amplitude linear. A
+  // fase é m_phase + i * step + stepDelta * i(i-1)/2, em aritmética modular
+  template <double (*Lookup)(const double*, size_t, double)>
+  void renderRamp(double* out, size_t count, const double* table,
+                  uint64_t step, int64_t stepDelta, double amplitude,
+                  double ampDelta) const {
+    for (size_t i = 0; i < count; ++i) {
+      uint64_t bend = static_cast<uint64_t>(stepDelta) * (i * (i - 1) / 2);
+      uint64_t phase = m_phase + i * step + bend;
+      double t = (phase & FRACTION_MASK) * FRACTION_SCALE;
+      out[i] = (amplitude + i * ampDelta) *
+               Lookup(table, phase >> INDEX_SHIFT, t);
+    }
+  }
+
+  // Trecho de `count` amostras com rampas ativas (não cruza o fim delas);
+  // avança `frequency`/`amplitude` até o fim do trecho
+  void generateRamp(double* out, size_t count, const Wavetable& wavetable,
+                    bool cubic, double& frequency, double& amplitude) {
+    LinearRamp& frequencyRamp = m_control.frequencyRamp();
+    LinearRamp& amplitudeRamp = m_control.amplitudeRamp();
+    double freq = std::min(frequency, 0.5 * m_sampleRate);
+    uint64_t step = toFixedPhase(freq / m_sampleRate);
+    double endFreq = freq;
+    int64_t stepDelta = 0;
+    if (frequencyRamp.active()) {
+      endFreq = freq + count * frequencyRamp.delta;
+      stepDelta = static_cast<int64_t>(
+          std::ldexp(frequencyRamp.delta / m_sampleRate, 64));
+    }
+    double ampDelta = amplitudeRamp.active() ? amplitudeRamp.delta : 0.0;
+
+    // O nível precisa servir para a maior frequência do trecho
+    const double* table = wavetable.level(
+        Wavetable::levelFor(std::max(freq, endFreq), m_sampleRate));
+    if (cubic) {
+      renderRamp<lookupCubic>(out, count, table, step, stepDelta, amplitude,
+                              ampDelta);
+    } else {
+      renderRamp<lookupLinear>(out, count, table, step, stepDelta, amplitude,
+                               ampDelta);
+    }
+
+    m_phase += count * step +
+               static_cast<uint64_t>(stepDelta) * (count * (count - 1) / 2);
+    if (frequencyRamp.active()) frequency = frequencyRamp.advance(freq, count);
+    if (amplitudeRamp.active()) {
+      amplitude = amplitudeRamp.advance(amplitude, count);
+    }
+  }
+
+ public:
+  explicit WavetableGenerator(double sampleRate = 44100.0,
+                              double frequency = 100.0,
+                              double amplitude = 0.8,
+                              Waveform waveform = WAVE_SINE,
+                              Interpolation interpolation = INTERP_LINEAR)
+      : m_control(std::clamp(frequency, MIN_FREQ, MAX_FREQ),
+                  std::clamp(amplitude, 0.0, 1.0)),
+        m_running(false),
+        m_waveform(waveform),
+        m_interpolation(interpolation),
+        m_sampleRate(sampleRate),
+        m_phase(0) {
+    Wavetable::stock(waveform);  // Constrói a tabela fora do caminho quente
+  }
+
+  void start() override { m_running = true; }
+  void stop() override { m_running = false; }
+
+  /**
+   * @brief Gera um bloco de amostras lendo a tabela da forma de onda.
+   *
+   * A fase avança f/fs ciclos por amostra (frequência limitada a Nyquist);
+   * o nível mip é escolhido uma vez por bloco a partir da frequência atual,
+   * de modo que nenhum harmônico tabelado ultrapasse Nyquist. Com rampas
+   * ativas o bloco é dividido nos pontos em que cada rampa termina. Todos
+   * os parâmetros são lidos uma única vez, no início do bloco.
+   */
+  size_t generateSamples(double* out, size_t count) override {
+    if (!m_running) return 0;
+
+    OscillatorSnapshot params = m_control.acquire();
+    if (params.phaseChanged) {
+      // Radianos, como no SineGenerator
+      m_phase = toFixedPhase(params.phase / (2.0 * M_PI));
+    }
+    const Wavetable& wavetable = Wavetable::stock(m_waveform);
+    bool cubic = m_interpolation == INTERP_CUBIC;
+    bool ramping = m_control.rampActive();
+    double frequency = params.frequency;
+    double amplitude = params.amplitude;
+
+    size_t done = 0;
+    while (done < count) {
+      size_t n = count - done;
+      if (m_control.frequencyRamp().active()) {
+        n = m_control.frequencyRamp().span(n);
+      }
+      if (m_control.amplitudeRamp().active()) {
+        n = m_control.amplitudeRamp().span(n);
+      }
+
+      if (m_control.rampActive()) {
+        generateRamp(out + done, n, wavetable, cubic, frequency, amplitude);
+      } else {
+        double freq = std::min(frequency, 0.5 * m_sampleRate);
+        uint64_t step = toFixedPhase(freq / m_sampleRate);
+        const double* table =
+            wavetable.level(Wavetable::levelFor(freq, m_sampleRate));
+        if (cubic) {
+          render<lookupCubic>(out + done, n, table, step, amplitude);
+        } else {
+          render<lookupLinear>(out + done, n, table, step, amplitude);
+        }
+        m_phase += n * step;
+      }
+      done += n;
+    }
+
+    if (ramping) m_control.publish(frequency, amplitude);
+    return count;
+  }
+
+  using ISignalGenerator::generateSamples;
+  using ISignalGenerator::getParameter;
+  using ISignalGenerator::rampParameter;
+  using ISignalGenerator::setParameter;
+
+  // Pode ser chamado de qualquer thread; vale a partir do próximo bloco
+  void setParameter(ParameterId id, double value) override {
+    switch (id) {
+      case PARAM_FREQUENCY:
+        m_control.setFrequency(std::clamp(value, MIN_FREQ, MAX_FREQ));
+        break;
+      case PARAM_AMPLITUDE:
+        m_control.setAmplitude(std::clamp(value, 0.0, 1.0));
+        break;
+      case PARAM_PHASE:
+        m_control.setPhase(value);
+        break;
+      case PARAM_WAVEFORM: {
+        Waveform waveform = static_cast<Waveform>(
+            std::clamp(static_cast<int>(value), static_cast<int>(WAVE_SINE),
+                       static_cast<int>(WAVE_TRIANGLE)));
+        Wavetable::stock(waveform);
+        m_waveform = waveform;
+        break;
+      }
+      case PARAM_INTERPOLATION:
+        m_interpolation = value >= 0.5 ? INTERP_CUBIC : INTERP_LINEAR;
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Frequência e amplitude publicadas juntas (entram no mesmo bloco)
+  void setParameters(double frequency, double amplitude) {
+    m_control.set(std::clamp(frequency, MIN_FREQ, MAX_FREQ),
+                  std::clamp(amplitude, 0.0, 1.0));
+  }
+
+  // Só a thread que renderiza pode iniciar rampas
+  void rampParameter(ParameterId id, double value, size_t frames) override {
+    if (frames == 0) {
+      setParameter(id, value);
+    } else if (id == PARAM_FREQUENCY) {
+      double nyquist = 0.5 * m_sampleRate;
+      value = std::clamp(value, MIN_FREQ, std::min(MAX_FREQ, nyquist));
+      m_control.beginFrequencyRamp(
+          std::min(m_control.load().frequency, nyquist), value, frames);
+    } else if (id == PARAM_AMPLITUDE) {
+      m_control.beginAmplitudeRamp(m_control.load().amplitude,
+                                   std::clamp(value, 0.0, 1.0), frames);
+    } else {
+      setParameter(id, value);
+    }
+  }
+
+  double getParameter(ParameterId id) const override {
+    switch (id) {
+      case PARAM_FREQUENCY:
+        return m_control.load().frequency;
+      case PARAM_AMPLITUDE:
+        return m_control.load().amplitude;
+      case PARAM_PHASE:
+        return 2.0 * M_PI * std::ldexp(m_phase, -64);
+      case PARAM_WAVEFORM:
+        return m_waveform;
+      case PARAM_INTERPOLATION:
+        return m_interpolation;
+      default:
+        return 0.0;
+    }
+  }
+
+  double getFrequency() const { return m_control.load().frequency; }
+  double getAmplitude() const { return m_control.load().amplitude; }
+  double getSampleRate() const { return m_sampleRate; }
+  Waveform getWaveform() const { return m_waveform; }
+  Interpolation getInterpolation() const { return m_interpolation; }
+  bool isRunning() const { return m_running; }
+
+  void resetPhase() { m_phase = 0; }
+};
+
+#endif  // WAVETABLE_GENERATOR_HPP
@@ -0,0 +1,546 @@
+// bench.cpp - Microbenchmarks dos caminhos quentes
+// Geradores por bloco, transferência pelo anel compartilhado e desenho do
+// traço do viewer. Uma linha JSON por medida na saída padrão, para comparar
+// execuções (ex.: antes e depois de uma atualização de compilador).
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/ChannelEngine.hpp"
+#include "../include/Communication.hpp"
+#include "../include/EffectChain.hpp"
+#include "../include/RingBuffer.hpp"
+#include "../include/SampleFormat.hpp"
+#include "../include/SharedMemory.hpp"
+#include "../include/SineGenerator.hpp"
+#include "../include/SineKernel.hpp"
+#include "../include/ToolSupport.hpp"
+#include "../include/WavetableGenerator.hpp"
+
+#ifdef BENCH_CAIRO
+#include "../include/WaveformRenderer.hpp"
+#endif
+
+using BenchClock = std::chrono::steady_clock;
+
+const double BENCH_SAMPLE_RATE = 48000.0;  // Taxa usada pelos geradores
+const size_t BLOCK_SIZES[] = {64, 256, 1024, 4096};  // Amostras por chamada
+const char* const BENCH_SHM_NAME = "/sine_bench";    // Anel privado do bench
+const uint64_t BENCH_RING_CAPACITY = 65536;          // Quadros
+const size_t RING_BLOCK_FRAMES = 256;      // Quadros por write() no anel
+const size_t RING_TRANSFER_SAMPLES = 1 << 22;  // Amostras por medida
+const size_t LATENCY_BLOCKS = 20000;       // Blocos medidos por configuração
+const int LATENCY_PERIOD_US = 50;          // Intervalo entre blocos medidos
+const int DRAW_WIDTH = 800;                // Tamanho da superfície de desenho
+const int DRAW_HEIGHT = 400;
+const size_t DRAW_FRAMES = 500;            // Quadros desenhados por caso
+const uint32_t ENGINE_CHANNELS = 8;        // Canais dos casos engine/*
+
+// Opções de linha de comando
+struct BenchOptions {
+  std::string filter;  // Só medidas cujo nome contém este texto
+  int trials = 9;      // Repetições por medida (mediana entre elas)
+  double minTimeMs = 20.0;  // Duração mínima de cada repetição
+};
+
+static BenchOptions options;
+static volatile double sink;  // Impede que o compilador descarte o trabalho
+
+static void printUsage(const char* prog) {
+  std::cerr << "Usage: " << prog << " [options]\n"
+            << "  --filter TEXT   run only benchmarks whose name contains "
+               "TEXT\n"
+            << "  --trials N      repetitions per measurement (default 9)\n"
+            << "  --min-time MS   minimum duration of each repetition "
+               "(default 20)\n"
+            << "Output: one JSON object per line on stdout." << std::endl;
+}
+
+static bool parseOptions(int argc, char* argv[]) {
+  double value;
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+      options.filter = argv[++i];
+    } else if (strcmp(argv[i], "--trials") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 1.0 || value > 1000.0) {
+        std::cerr << "[BENCH] Invalid trial count" << std::endl;
+        return false;
+      }
+      options.trials = static_cast<int>(value);
+    } else if (strcmp(argv[i], "--min-time") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value <= 0.0) {
+        std::cerr << "[BENCH] Invalid minimum time" << std::endl;
+        return false;
+      }
+      options.minTimeMs = value;
+    } else {
+      printUsage(argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool selected(const std::string& name) {
+  return name.find(options.filter) != std::string::npos;
+}
+
+static double secondsSince(BenchClock::time_point start) {
+  return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+static int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             BenchClock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief Mede a taxa de `body` (que processa `work` unidades por chamada).
+ *
+ * Calibra quantas chamadas cabem em --min-time, descarta uma repetição de
+ * aquecimento e imprime mediana, mínimo e máximo das --trials repetições.
+ * A mediana é a estatística estável; min/max mostram o ruído da máquina.
+ */
+template <class Body>
+static void reportRate(const std::string& name, const char* unit, double work,
+                       Body body) {
+  size_t calls = 1;
+  for (;;) {
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < calls; ++i) body();
+    double elapsed = secondsSince(start);
+    if (elapsed * 1000.0 >= options.minTimeMs) break;
+    double scale = elapsed > 0.0 ? options.minTimeMs / 1000.0 / elapsed : 10;
+    calls = static_cast<size_t>(calls * std::clamp(scale * 1.2, 1.5, 10.0));
+  }
+
+  std::vector<double> rates;
+  for (int t = 0; t < options.trials; ++t) {
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < calls; ++i) body();
+    rates.push_back(work * calls / secondsSince(start));
+  }
+  std::sort(rates.begin(), rates.end());
+  printf("{\"name\":\"%s\",\"unit\":\"%s\",\"median\":%.6g,\"min\":%.6g,"
+         "\"max\":%.6g,\"trials\":%d}\n",
+         name.c_str(), unit, rates[rates.size() / 2], rates.front(),
+         rates.back(), options.trials);
+  fflush(stdout);
+}
+
+// Percentis de uma amostra de durações (ordena `values`)
+static void reportPercentiles(const std::string& name, const char* unit,
+                              std::vector<double>& values,
+                              const char* extra = "") {
+  std::sort(values.begin(), values.end());
+  auto at = [&](double p) {
+    size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    return values[index];
+  };
+  printf("{\"name\":\"%s\",\"unit\":\"%s\",\"p50\":%.6g,\"p90\":%.6g,"
+         "\"p99\":%.6g,\"p999\":%.6g,\"max\":%.6g,\"samples\":%zu%s}\n",
+         name.c_str(), unit, at(0.5), at(0.9), at(0.99), at(0.999),
+         values.back(), values.size(), extra);
+  fflush(stdout);
+}
+
+// ---------------------------------------------------------------------------
+// Geradores: amostras/s por kernel e tamanho de bloco
+// ---------------------------------------------------------------------------
+
+static void benchGenerators() {
+  const struct {
+    SineKernelType type;
+    const char* name;
+  } kernels[] = {{KERNEL_REFERENCE, "reference"}, {KERNEL_SCALAR, "scalar"},
+                 {KERNEL_AVX2, "avx2"},           {KERNEL_AVX512, "avx512"},
+                 {KERNEL_NEON, "neon"}};
+  std::vector<double> out(BLOCK_SIZES[3]);
+
+  for (const auto& kernel : kernels) {
+    SineKernelFn fn = sineKernelFor(kernel.type);
+    if (!fn) continue;  // Não suportado nesta CPU
+    for (size_t block : BLOCK_SIZES) {
+      std::string name = std::string("sine/") + kernel.name + "/" +
+                         std::to_string(block);
+      if (!selected(name)) continue;
+      SineGenerator generator(BENCH_SAMPLE_RATE, 1000.0, 0.8,
+                              SineGenerator::MODE_PHYSICAL);
+      generator.setKernel(fn);
+      generator.start();
+      reportRate(name, "samples/s", static_cast<double>(block), [&] {
+        generator.generateSamples(out.data(), block);
+        sink = out[block - 1];
+      });
+    }
+  }
+
+  // Modo visual: custo fixo por bloco (parâmetros de tela) sobre o kernel
+  for (size_t block : BLOCK_SIZES) {
+    std::string name = "sine/visual/" + std::to_string(block);
+    if (!selected(name)) continue;
+    SineGenerator generator(BENCH_SAMPLE_RATE, 1000.0, 0.8,
+                            SineGenerator::MODE_VISUAL);
+    generator.start();
+    reportRate(name, "samples/s", static_cast<double>(block), [&] {
+      generator.generateSamples(out.data(), block);
+      sink = out[block - 1];
+    });
+  }
+
+  const struct {
+    WavetableGenerator::Interpolation interpolation;
+    const char* name;
+  } modes[] = {{WavetableGenerator::INTERP_LINEAR, "linear"},
+               {WavetableGenerator::INTERP_CUBIC, "cubic"}};
+  for (const auto& mode : modes) {
+    for (size_t block : BLOCK_SIZES) {
+      std::string name = std::string("wavetable/saw/") + mode.name + "/" +
+                         std::to_string(block);
+      if (!selected(name)) continue;
+      WavetableGenerator generator(BENCH_SAMPLE_RATE, 1000.0, 0.8, WAVE_SAW,
+                                   mode.interpolation);
+      generator.start();
+      reportRate(name, "samples/s", static_cast<double>(block), [&] {
+        generator.generateSamples(out.data(), block);
+        sink = out[block - 1];
+      });
+    }
+  }
+}
+
+/**
+ * Um quadro do gerador: render() de todos os canais e a leitura da
+ * frequência de cada um (publishFrequencies). `Generator` escolhe entre a
+ * interface polimórfica e o tipo concreto.
+ */
+template <typename Generator>
+static void benchEngine(const char* kind) {
+  for (size_t block : BLOCK_SIZES) {
+    std::string name = std::string("engine/") + kind + "/" +
+                       std::to_string(ENGINE_CHANNELS) + "x" +
+                       std::to_string(block);
+    if (!selected(name)) continue;
+    BasicChannelEngine<Generator> engine;
+    for (uint32_t c = 0; c < ENGINE_CHANNELS; ++c) {
+      engine.addChannel(std::make_unique<SineGenerator>(
+          BENCH_SAMPLE_RATE, 100.0 * (c + 1), 0.8,
+          SineGenerator::MODE_PHYSICAL));
+    }
+    engine.start();
+    std::vector<double> planar(ENGINE_CHANNELS * block);
+    uint64_t frame = 0;
+    reportRate(name, "samples/s", static_cast<double>(ENGINE_CHANNELS * block),
+               [&] {
+                 engine.render(planar.data(), block, frame, true);
+                 frame += block;
+                 double sum = 0.0;
+                 for (uint32_t c = 0; c < ENGINE_CHANNELS; ++c) {
+                   sum += engine.channel(c).getParameter(PARAM_FREQUENCY);
+                 }
+                 sink = sum + planar[block - 1];
+               });
+  }
+}
+
+/**
+ * Cadeia de efeitos: um estágio de cada tipo sobre um bloco já gerado. O
+ * bloco é recopiado a cada chamada (passar o efeito sobre a própria saída
+ * levaria o sinal a subnormais); a cópia entra na medida
+ */
+static void benchEffects() {
+  std::vector<double> source(BLOCK_SIZES[3]);
+  std::vector<double> out(BLOCK_SIZES[3]);
+  for (int k = EFFECT_LOWPASS; k < static_cast<int>(EFFECT_KIND_COUNT); ++k) {
+    EffectKind kind = static_cast<EffectKind>(k);
+    for (size_t block : BLOCK_SIZES) {
+      std::string name = std::string("fx/") + EFFECT_KIND_NAMES[kind] + "/" +
+                         std::to_string(block);
+      if (!selected(name)) continue;
+      EffectChain chain(BENCH_SAMPLE_RATE);
+      auto set = [&](EffectParam param, double value) {
+        Command cmd(CMD_SET_EFFECT, value);
+        cmd.arg = effectArg(0, param);
+        chain.apply(cmd);
+      };
+      set(FX_PARAM_KIND, kind);
+      set(FX_PARAM_FREQUENCY, 1000.0);
+      set(FX_PARAM_GAIN, 0.5);
+      set(FX_PARAM_LEVEL, 0.1);
+      SineGenerator generator(BENCH_SAMPLE_RATE, 440.0, 0.8,
+                              SineGenerator::MODE_PHYSICAL);
+      generator.start();
+      generator.generateSamples(source.data(), block);
+      reportRate(name, "samples/s", static_cast<double>(block), [&] {
+        std::copy(source.begin(), source.begin() + block, out.begin());
+        chain.process(out.data(), block);
+        sink = out[block - 1];
+      });
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Anel compartilhado: vazão produtor→consumidor e latência de entrega
+// ---------------------------------------------------------------------------
+
+struct RingCase {
+  SampleFormat format;
+  uint32_t channels;
+  ChannelLayout layout;
+};
+
+static std::string ringCaseName(const RingCase& ring) {
+  return std::string(sampleFormatName(ring.format)) + "x" +
+         std::to_string(ring.channels) +
+         (ring.layout == LAYOUT_PLANAR ? "/planar" : "/interleaved");
+}
+
+static SharedBuffer* createBenchRing(const RingCase& ring) {
+  RingLayout layout;
+  layout.capacity = BENCH_RING_CAPACITY;
+  layout.format = ring.format;
+  layout.channels = ring.channels;
+  layout.channelLayout = ring.layout;
+  layout.sampleRate = BENCH_SAMPLE_RATE;
+  const char* error;
+  SharedBuffer* buffer = createSharedBuffer(BENCH_SHM_NAME, layout, false,
+                                            error);
+  if (!buffer) std::cerr << "[BENCH] " << error << std::endl;
+  return buffer;
+}
+
+/**
+ * Vazão: o produtor escreve o mais rápido que pode, mas nunca abre mais de
+ * meia capacidade de vantagem sobre o consumidor (o anel real não espera
+ * leitores; aqui a contrapressão evita medir descarte em vez de cópia). A
+ * taxa é de quadros entregues ao consumidor por segundo, já decodificados.
+ */
+static void benchRingThroughput(const RingCase& ring) {
+  std::string name = "ring/throughput/" + ringCaseName(ring);
+  if (!selected(name)) return;
+  SharedBuffer* buffer = createBenchRing(ring);
+  if (!buffer) return;
+
+  size_t frames = RING_TRANSFER_SAMPLES / ring.channels;
+  std::vector<double> block(RING_BLOCK_FRAMES * ring.channels, 0.25);
+  std::vector<double> out(4096 * ring.channels);
+  RingWriter writer(buffer, false);
+  uint64_t lost = 0;
+
+  reportRate(name, "frames/s", static_cast<double>(frames), [&] {
+    RingReader reader(buffer);
+    std::atomic<uint64_t> consumed(reader.tail());
+    uint64_t target = reader.tail() + frames;
+    std::thread producer([&] {
+      while (writer.head() < target) {
+        while (writer.head() + RING_BLOCK_FRAMES - consumed.load() >
+               BENCH_RING_CAPACITY / 2) {
+          std::this_thread::yield();
+        }
+        writer.write(block.data(), RING_BLOCK_FRAMES);
+      }
+    });
+    while (reader.tail() < target) {
+      if (reader.read(out.data(), 4096) == 0) {
+        reader.waitForData(100);
+      }
+      consumed.store(reader.tail());
+    }
+    producer.join();
+    lost += reader.lost();
+    sink = out[0];
+  });
+
+  if (lost > 0) {
+    std::cerr << "[BENCH] " << name << ": " << lost << " frames lost"
+              << std::endl;
+  }
+  releaseSharedBuffer(buffer);
+  shm_unlink(BENCH_SHM_NAME);
+}
+
+/**
+ * Latência: o produtor publica um bloco a cada LATENCY_PERIOD_US e anota o
+ * instante antes do write(); o consumidor dorme no futex como o viewer e o
+ * recorder, e mede quando cada bloco fica legível. Inclui cópia, codificação
+ * e o acordar da thread.
+ */
+static void benchRingLatency(const RingCase& ring) {
+  std::string name = "ring/latency/" + ringCaseName(ring);
+  if (!selected(name)) return;
+  SharedBuffer* buffer = createBenchRing(ring);
+  if (!buffer) return;
+
+  std::vector<double> block(RING_BLOCK_FRAMES * ring.channels, 0.25);
+  std::vector<double> out(BENCH_RING_CAPACITY * ring.channels);
+  // Escrito antes do write(); a publicação de head (release) o torna
+  // visível ao consumidor junto com o bloco
+  std::vector<int64_t> stamps(LATENCY_BLOCKS);
+  std::vector<double> latencies;
+  latencies.reserve(LATENCY_BLOCKS);
+  RingWriter writer(buffer, false);
+  RingReader reader(buffer);
+  uint64_t first = reader.tail();
+
+  std::thread producer([&] {
+    for (size_t k = 0; k < LATENCY_BLOCKS; ++k) {
+      int64_t start = nowNs();
+      stamps[k] = start;
+      writer.write(block.data(), RING_BLOCK_FRAMES);
+      while (nowNs() - start < LATENCY_PERIOD_US * 1000) {
+      }
+    }
+  });
+
+  size_t measured = 0;
+  while (measured < LATENCY_BLOCKS) {
+    if (reader.read(out.data(), BENCH_RING_CAPACITY) == 0) {
+      reader.waitForData(100);
+      continue;
+    }
+    int64_t now = nowNs();
+    size_t complete = (reader.tail() - first) / RING_BLOCK_FRAMES;
+    for (; measured < complete; ++measured) {
+      latencies.push_back(static_cast<double>(now - stamps[measured]));
+    }
+  }
+  producer.join();
+
+  std::string extra = ",\"lost\":" + std::to_string(reader.lost());
+  reportPercentiles(name, "ns", latencies, extra.c_str());
+  releaseSharedBuffer(buffer);
+  shm_unlink(BENCH_SHM_NAME);
+}
+
+/**
+ * Publicação, só o lado do produtor: "copy" gera num bloco planar e o
+ * publica com write() (o caminho genérico do generator); "in-place" gera
+ * direto nos slots com reserve()/commit(). A geração é um preenchimento,
+ * para que a diferença seja o tráfego de memória da cópia.
+ */
+static void benchRingPublish(uint32_t channels, bool inPlace) {
+  std::string name = "ring/publish/f64x" + std::to_string(channels) +
+                     (inPlace ? "/planar/in-place" : "/planar/copy");
+  if (!selected(name)) return;
+  SharedBuffer* buffer = createBenchRing({FORMAT_F64, channels,
+                                          LAYOUT_PLANAR});
+  if (!buffer) return;
+
+  const size_t frames = 2400;  // Um quadro de 50 ms a 48 kHz
+  std::vector<double> block(frames * channels);
+  RingWriter writer(buffer, false);
+  double value = 0.0;
+
+  reportRate(name, "samples/s", static_cast<double>(frames * channels), [&] {
+    value += 1.0;
+    if (!inPlace) {
+      std::fill(block.begin(), block.end(), value);
+      writer.write(block.data(), frames);
+      return;
+    }
+    RingRegion regions[2];
+    size_t count = writer.reserve(frames, regions);
+    for (size_t r = 0; r < count; ++r) {
+      for (uint32_t c = 0; c < channels; ++c) {
+        std::fill_n(regions[r].planes + c * regions[r].planeStride,
+                    regions[r].frames, value);
+      }
+    }
+    writer.commit();
+  });
+
+  releaseSharedBuffer(buffer);
+  shm_unlink(BENCH_SHM_NAME);
+}
+
+static void benchRing() {
+  const RingCase cases[] = {
+      {FORMAT_F64, 1, LAYOUT_INTERLEAVED}, {FORMAT_F32, 1, LAYOUT_INTERLEAVED},
+      {FORMAT_S16, 1, LAYOUT_INTERLEAVED}, {FORMAT_S24, 1, LAYOUT_INTERLEAVED},
+      {FORMAT_F32, 8, LAYOUT_INTERLEAVED}, {FORMAT_F32, 8, LAYOUT_PLANAR},
+      {FORMAT_S16, 8, LAYOUT_INTERLEAVED}, {FORMAT_S16, 8, LAYOUT_PLANAR}};
+  for (const RingCase& ring : cases) benchRingThroughput(ring);
+  for (uint32_t channels : {1u, 8u}) {
+    benchRingPublish(channels, false);
+    benchRingPublish(channels, true);
+  }
+  benchRingLatency({FORMAT_F32, 1, LAYOUT_INTERLEAVED});
+  benchRingLatency({FORMAT_F32, 8, LAYOUT_INTERLEAVED});
+}
+
+// ---------------------------------------------------------------------------
+// Viewer: tempo por quadro do traço numa superfície Cairo fora da tela
+// ---------------------------------------------------------------------------
+
+#ifdef BENCH_CAIRO
+static void benchDraw() {
+  const struct {
+    size_t samples;
+    bool triggered;
+    const char* name;
+  } cases[] = {{800, false, "draw/800"},  // Modo visual: polilinha direta
+               {16384, false, "draw/16384"},  // Modo físico: min/max
+               {16384, true, "draw/16384/trigger"}};
+
+  auto surface = Cairo::ImageSurface::create(Cairo::Surface::Format::ARGB32,
+                                             DRAW_WIDTH, DRAW_HEIGHT);
+  auto cr = Cairo::Context::create(surface);
+  WaveformRenderer renderer;
+
+  for (const auto& c : cases) {
+    if (!selected(c.name)) continue;
+    std::vector<double> samples(c.samples);
+    for (size_t i = 0; i < c.samples; ++i) {
+      samples[i] = 0.8 * std::sin(2.0 * M_PI * 12.0 * i / c.samples);
+    }
+    WaveSnapshot snapshot;
+    snapshot.samples = samples.data();
+    snapshot.count = c.samples;
+    snapshot.triggered = c.triggered;
+    snapshot.triggerIndex = c.samples / 2;
+    snapshot.triggerLevel = 0.0;
+
+    std::vector<double> times;
+    for (size_t f = 0; f < DRAW_FRAMES + 10; ++f) {
+      auto start = BenchClock::now();
+      renderer.draw(cr, DRAW_WIDTH, DRAW_HEIGHT, snapshot);
+      surface->flush();
+      if (f >= 10) times.push_back(secondsSince(start) * 1e6);  // Aquecido
+    }
+    reportPercentiles(c.name, "us", times);
+  }
+}
+#endif
+
+int main(int argc, char* argv[]) {
+  if (!parseOptions(argc, argv)) return 1;
+
+  benchGenerators();
+  benchEngine<ISignalGenerator>("virtual");
+  benchEngine<SineGenerator>("typed");
+  benchEffects();
+  benchRing();
+#ifdef BENCH_CAIRO
+  benchDraw();
+#else
+  if (selected("draw/")) {
+    std::cerr << "[BENCH] draw/*: skipped (built without cairomm)"
+              << std::endl;
+  }
+#endif
+  return 0;
+}
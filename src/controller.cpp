@@ -1,69 +1,628 @@
 // src/controller.cpp
 #include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 
+#include "../include/CommandProtocol.hpp"
+#include "../include/CommandScript.hpp"
 #include "../include/Communication.hpp"
+#include "../include/EffectChain.hpp"
+#include "../include/SharedMemory.hpp"
+#include "../include/ToolSupport.hpp"
+
+const int REPLY_TIMEOUT_MS = 500;  // Espera máxima pela confirmação
+
+// Opções de linha de comando (sem --script/--binary: modo interativo)
+struct ControllerOptions {
+  std::string script;        // Arquivo de script ("-" = stdin)
+  bool binary = false;       // Script é um fluxo de Commands (--binary)
+  double leadMs = 100.0;     // Folga entre ler o relógio e o instante 0
+  double horizonMs = 250.0;  // Antecedência máxima de envio dos agendados
+};
+
+static void printUsage(const char* prog) {
+  std::cerr << "Usage: " << prog << " [options]\n"
+            << "  --script FILE     play a timed command script "
+               "(- = stdin) and exit\n"
+            << "  --binary FILE     play a stream of protocol Command "
+               "records (atFrame =\n"
+            << "                    frames from the start; - = stdin)\n"
+            << "  --lead MS         delay before the script's time 0 "
+               "(default 100)\n"
+            << "  --horizon MS      send scheduled commands up to MS "
+               "ahead (default 250)"
+            << std::endl;
+}
+
+static bool parseOptions(int argc, char* argv[], ControllerOptions& options) {
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if ((strcmp(argv[i], "--script") == 0 ||
+         strcmp(argv[i], "--binary") == 0) &&
+        hasValue) {
+      options.binary = strcmp(argv[i], "--binary") == 0;
+      options.script = argv[++i];
+    } else if (strcmp(argv[i], "--lead") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], options.leadMs) || options.leadMs < 0.0) {
+        std::cerr << "[CONTROLLER] Invalid lead time" << std::endl;
+        return false;
+      }
+    } else if (strcmp(argv[i], "--horizon") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], options.horizonMs) ||
+          options.horizonMs < 0.0) {
+        std::cerr << "[CONTROLLER] Invalid send horizon" << std::endl;
+        return false;
+      }
+    } else {
+      printUsage(argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Espera a confirmação do frame `expected`, descartando respostas antigas;
+// false se não chegou em REPLY_TIMEOUT_MS
+static bool readReply(int replyFd, uint32_t expected, CommandReply& reply) {
+  struct pollfd pfd = {replyFd, POLLIN, 0};
+  while (poll(&pfd, 1, REPLY_TIMEOUT_MS) > 0) {
+    if (read(replyFd, &reply, sizeof(reply)) != sizeof(reply)) continue;
+    if (reply.magic == CMD_REPLY_MAGIC && reply.seq == expected) return true;
+  }
+  return false;
+}
+
+/**
+ * Abre o FIFO de comandos para escrita. O FIFO sobrevive ao gerador: se
+ * existir sem leitor (gerador parado ou reiniciando), avisa e bloqueia até
+ * o próximo gerador abri-lo. Retorna -1 se o FIFO nem existe.
+ */
+static int openCommandFifo() {
+  int fd = open(FIFO_COMMAND, O_WRONLY | O_NONBLOCK);
+  if (fd < 0 && errno == ENXIO) {
+    std::cout << "[CONTROLLER] Waiting for the generator..." << std::endl;
+    fd = open(FIFO_COMMAND, O_WRONLY);
+  } else if (fd >= 0) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+  }
+  return fd;
+}
+
+static void sleepUntilNs(uint64_t deadlineNs) {
+  struct timespec ts;
+  ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ULL);
+  ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000ULL);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+         EINTR) {
+  }
+}
+
+/**
+ * Reproduz um script já expandido.
+ *
+ * O instante 0 é ancorado no relógio de amostras (head + lead) e no
+ * monotônico ao mesmo tempo. Os comandos saem em frames de até
+ * MAX_BATCH_COMMANDS, com atFrame absoluto, assim que entram na janela de
+ * `horizon` à frente do relógio de parede, e o gerador os aplica na amostra
+ * exata. START e QUIT são aplicados na chegada e por isso saem no próprio
+ * instante. START no instante 0 sai antes da ancoragem, já que com o
+ * gerador parado o relógio de amostras não anda. Uma confirmação "fila
+ * cheia" faz o mesmo frame ser reenviado um quadro depois.
+ */
+static int playScript(const ControllerOptions& options,
+                      const CommandScript& script, double framesPerSecond,
+                      int commandFd, int replyFd, const SharedBuffer* shm) {
+  const std::vector<CommandScript::Entry>& entries = script.entries();
+  auto nsToFrames = [&](uint64_t ns) {
+    return static_cast<uint64_t>(ns * framesPerSecond / 1e9);
+  };
+  auto framesToNs = [&](uint64_t frames) {
+    return static_cast<uint64_t>(frames * 1e9 / framesPerSecond);
+  };
+  uint64_t leadNs = static_cast<uint64_t>(options.leadMs * 1e6);
+  uint64_t horizonFrames = nsToFrames(
+      static_cast<uint64_t>(options.horizonMs * 1e6));
+
+  uint32_t seq = 0;
+  size_t frames = 0, rejected = 0, retries = 0;
+  CommandReply reply;
+  // Envia o lote num frame; false se o gerador pediu para reenviar depois
+  auto sendFrame = [&](CommandBatch& batch) {
+    uint32_t frameSeq = ++seq;
+    size_t count = batch.size();
+    if (!batch.send(commandFd, frameSeq)) {
+      std::cerr << "[CONTROLLER] Error: failed to send command frame"
+                << std::endl;
+      batch.clear();
+      return true;
+    }
+    ++frames;
+    if (replyFd < 0) return true;
+    if (!readReply(replyFd, frameSeq, reply)) {
+      std::cerr << "[CONTROLLER] Warning: no reply for seq " << frameSeq
+                << std::endl;
+      return true;
+    }
+    if (reply.status == REPLY_QUEUE_FULL) {
+      --frames;
+      ++retries;
+      return false;
+    }
+    if (reply.status != REPLY_OK) {
+      rejected += count;
+      std::cerr << "[CONTROLLER] Frame seq " << frameSeq << " ("
+                << count << " commands) rejected: "
+                << replyStatusName(reply.status) << std::endl;
+    }
+    return true;
+  };
+
+  CommandBatch batch;
+  size_t next = 0;
+  while (next < entries.size() && entries[next].frame == 0 &&
+         entries[next].cmd.type == CMD_START) {
+    batch.add(entries[next++].cmd);
+  }
+  if (!batch.empty()) sendFrame(batch);
+
+  uint64_t origin = shm->head.load() + nsToFrames(leadNs);
+  uint64_t originNs = monotonicNs() + leadNs;
+  std::cout << "[CONTROLLER] Playing " << entries.size() << " commands over "
+            << script.duration() / framesPerSecond << " s" << std::endl;
+
+  while (next < entries.size()) {
+    uint64_t now = monotonicNs();
+    uint64_t elapsed = now > originNs ? nsToFrames(now - originNs) : 0;
+    size_t first = next;
+    bool immediate = false;
+    while (next < entries.size()) {
+      const CommandScript::Entry& entry = entries[next];
+      immediate = entry.cmd.type == CMD_START || entry.cmd.type == CMD_QUIT;
+      if (entry.frame > elapsed + (immediate ? 0 : horizonFrames)) break;
+      // Os comandos de um grupo (joined) vão sempre no mesmo frame
+      size_t groupEnd = next + 1;
+      while (groupEnd < entries.size() && entries[groupEnd].joined) {
+        ++groupEnd;
+      }
+      if (batch.size() + (groupEnd - next) > MAX_BATCH_COMMANDS) break;
+      for (; next < groupEnd; ++next) {
+        Command cmd = entries[next].cmd;
+        cmd.atFrame = immediate ? 0 : origin + entries[next].frame;
+        batch.add(cmd);
+      }
+    }
+    if (!batch.empty()) {
+      if (!sendFrame(batch)) {
+        next = first;  // Remonta o mesmo frame
+        sleepUntilNs(monotonicNs() + FRAME_INTERVAL_MS * 1000000ULL);
+      }
+      continue;
+    }
+    // Nada na janela: dorme até o próximo comando entrar nela. Agendados
+    // esperam ao menos meia janela desde o último envio, para sair em
+    // frames cheios e ainda com meia janela de antecedência
+    uint64_t due = entries[next].frame;
+    if (!immediate) {
+      due = due > horizonFrames ? due - horizonFrames : 0;
+      due = std::max(due, elapsed + horizonFrames / 2);
+    }
+    sleepUntilNs(originNs + framesToNs(due));
+  }
+
+  // Termina no instante do último comando, e não no seu envio, com um
+  // quadro de folga (head avança de bloco em bloco): o próximo controlador
+  // não encontra comandos deste ainda pendentes
+  sleepUntilNs(originNs + framesToNs(script.duration()) +
+               FRAME_INTERVAL_MS * 1000000ULL);
+
+  std::cout << "[CONTROLLER] Script done: " << entries.size()
+            << " commands in " << frames << " frames";
+  if (rejected) std::cout << ", " << rejected << " rejected";
+  if (retries) std::cout << ", " << retries << " retries (queue full)";
+  std::cout << std::endl;
+  return rejected ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+  ControllerOptions options;
+  if (!parseOptions(argc, argv, options)) return 1;
 
-int main() {
   std::cout << "\n[CONTROLLER] PID: " << getpid() << std::endl;
 
+  // Um gerador que sai fecha o FIFO: a escrita seguinte falha com EPIPE
+  // (tratado em flush) em vez de matar o processo
+  signal(SIGPIPE, SIG_IGN);
+
   // Abre o FIFO criado pelo gerador para enviar comandos
-  int commandFd = open(FIFO_COMMAND, O_WRONLY);
+  int commandFd = openCommandFifo();
   if (commandFd < 0) {
     std::cerr << "[CONTROLLER] Error: generator not running?" << std::endl;
     return 1;
   }
 
+  // Confirmações chegam pelo FIFO_REPLY (aberto antes do primeiro envio
+  // para o gerador encontrar um leitor)
+  int replyFd = open(FIFO_REPLY, O_RDONLY | O_NONBLOCK);
+  if (replyFd < 0) {
+    std::cerr << "[CONTROLLER] Warning: no reply channel, commands will "
+                 "not be confirmed"
+              << std::endl;
+  }
+
+  // O cabeçalho da memória compartilhada dá a taxa de amostragem (para
+  // converter ms em quadros) e o relógio de amostras atual (para agendar)
+  const char* shmError;
+  const SharedBuffer* shm = attachSharedBuffer(SHARED_MEMORY_NAME, shmError);
+  if (!shm) {
+    std::cerr << "[CONTROLLER] Warning: " << shmError
+              << " (ramps use the visual frame rate, 'at' unavailable)"
+              << std::endl;
+  }
+  auto framesPerSecond = [&]() {
+    double rate = shm ? shm->sampleRate.load() : 0.0;
+    return rate > 0.0 ? rate : SAMPLES_PER_FRAME * 1000.0 / FRAME_INTERVAL_MS;
+  };
+  auto msToFrames = [&](double ms) {
+    return static_cast<uint64_t>(std::llround(ms * framesPerSecond() / 1000.0));
+  };
+
+  // Modo script: lê e expande tudo antes do primeiro envio
+  if (!options.script.empty()) {
+    if (!shm) {
+      std::cerr << "[CONTROLLER] Error: script mode needs the shared memory "
+                   "(sample clock)"
+                << std::endl;
+      return 1;
+    }
+    std::ifstream file;
+    if (options.script != "-") {
+      file.open(options.script, std::ios::binary);
+      if (!file) {
+        std::cerr << "[CONTROLLER] Error: cannot open " << options.script
+                  << std::endl;
+        return 1;
+      }
+    }
+    std::istream& in = options.script == "-" ? std::cin : file;
+    CommandScript script;
+    const char* error;
+    bool loaded = options.binary
+                      ? script.loadBinary(in, error)
+                      : script.parse(in, framesPerSecond(), error);
+    if (!loaded) {
+      std::cerr << "[CONTROLLER] Error: " << options.script << ":"
+                << script.errorPosition() << ": " << error << std::endl;
+      return 1;
+    }
+    if (replyFd < 0) {
+      std::cerr << "[CONTROLLER] Warning: without replies a full command "
+                   "queue drops frames"
+                << std::endl;
+    }
+    int status = playScript(options, script, framesPerSecond(), commandFd,
+                            replyFd, shm);
+    if (replyFd >= 0) close(replyFd);
+    close(commandFd);
+    return status;
+  }
+
   // Mapa que associa nomes de comandos a funções que os executam.
   // A função recebe o valor (string) e o descritor do FIFO.
   std::map<std::string, std::function<void(const std::string&, int)>> handlers;
 
-  handlers["start"] = [&](const std::string&, int fd) {
-    Command cmd(CMD_START, 0.0);
-    write(fd, &cmd, sizeof(Command));
-    std::cout << "START sent" << std::endl;
+  // Canal alvo dos próximos comandos (persistente até novo "channel")
+  int32_t channel = ALL_CHANNELS;
+  // Atraso (ms) aplicado aos próximos comandos; negativo = imediato
+  double delayMs = -1.0;
+
+  CommandBatch batch;     // Comandos acumulados entre "begin" e "commit"
+  bool batching = false;  // Se está dentro de um begin/commit
+  uint32_t seq = 0;       // Número de sequência do último frame enviado
+
+  // Sufixo " (ch N)" para as confirmações; vazio quando o alvo é todos
+  auto target = [&]() {
+    return channel == ALL_CHANNELS ? std::string()
+                                   : " (ch " + std::to_string(channel) + ")";
   };
 
-  handlers["stop"] = [&](const std::string&, int fd) {
-    Command cmd(CMD_STOP, 0.0);
-    write(fd, &cmd, sizeof(Command));
-    std::cout << "STOP sent" << std::endl;
+  // Espera a confirmação do frame `expected`, descartando respostas antigas
+  auto waitReply = [&](uint32_t expected) {
+    if (replyFd < 0) return;
+    CommandReply reply;
+    if (!readReply(replyFd, expected, reply)) {
+      std::cout << "  [no reply for seq " << expected << "]" << std::endl;
+      return;
+    }
+    std::cout << "  [" << replyStatusName(reply.status) << ", seq "
+              << reply.seq << ", frame " << reply.frame << "]" << std::endl;
   };
 
-  handlers["freq"] = [&](const std::string& value, int fd) {
+  // O gerador saiu (EPIPE): espera o próximo e reconecta o FIFO e, se o
+  // segmento foi aposentado por uma troca de layout, a memória compartilhada
+  auto reconnect = [&]() {
+    close(commandFd);
+    commandFd = openCommandFifo();
+    if (commandFd < 0) return false;
+    if (shm && shm->magic.load() != SHM_MAGIC) {
+      releaseSharedBuffer(shm);
+      shm = attachSharedBuffer(SHARED_MEMORY_NAME, shmError);
+    }
+    return true;
+  };
+
+  // Envia o lote atual como um único frame atômico e aguarda a confirmação.
+  // Se o gerador tiver reiniciado, o frame é reenviado ao novo uma vez
+  auto flush = [&](int fd) {
+    if (batch.empty()) return;
+    uint32_t frameSeq = ++seq;
+    bool sent = batch.send(fd, frameSeq);
+    if (!sent && errno == EPIPE && reconnect()) {
+      sent = batch.send(commandFd, frameSeq);
+    }
+    if (!sent) {
+      std::cout << "Error: failed to send command frame" << std::endl;
+      batch.clear();
+      return;
+    }
+    waitReply(frameSeq);
+  };
+
+  // Completa canal/instante dos comandos e os envia juntos, num único frame
+  // (ou os enfileira no lote)
+  auto submitGroup = [&](Command* cmds, size_t count, int fd,
+                         const std::string& description) {
+    if (batch.size() + count > MAX_BATCH_COMMANDS) {
+      std::cout << "Error: batch full (" << MAX_BATCH_COMMANDS
+                << " commands), use 'commit'" << std::endl;
+      return;
+    }
+    uint64_t atFrame = 0;
+    if (delayMs >= 0.0 && shm) {
+      atFrame = shm->head.load() + msToFrames(delayMs);
+    }
+    for (size_t i = 0; i < count; ++i) {
+      cmds[i].channel = channel;
+      if (atFrame) cmds[i].atFrame = atFrame;
+      batch.add(cmds[i]);
+    }
+    if (batching) {
+      std::cout << description << target() << " queued (" << batch.size()
+                << " in batch)" << std::endl;
+    } else {
+      std::cout << description << " sent" << target() << std::endl;
+      flush(fd);
+    }
+  };
+
+  auto submit = [&](Command cmd, int fd, const std::string& description) {
+    submitGroup(&cmd, 1, fd, description);
+  };
+
+  // Comando com valor numérico e rampa opcional em ms ("freq 440 250")
+  auto valueCommand = [&](CommandType type, const std::string& label,
+                          const std::string& unit, const std::string& args,
+                          int fd) {
+    std::istringstream iss(args);
+    double value, rampMs = 0.0;
+    if (!(iss >> value) || (!(iss >> std::ws).eof() && !(iss >> rampMs)) ||
+        rampMs < 0.0) {
+      std::cout << "Error: invalid " << label << " value" << std::endl;
+      return;
+    }
+    if (rampMs * framesPerSecond() / 1000.0 > MAX_RAMP_FRAMES) {
+      std::cout << "Error: ramp too long" << std::endl;
+      return;
+    }
+    Command cmd(type, value);
+    cmd.rampFrames = static_cast<uint32_t>(msToFrames(rampMs));
+    std::ostringstream description;
+    description << label << "=" << value << unit;
+    if (cmd.rampFrames) description << " ramp " << rampMs << " ms";
+    submit(cmd, fd, description.str());
+  };
+
+  handlers["channel"] = [&](const std::string& value, int) {
+    if (value == "all") {
+      channel = ALL_CHANNELS;
+      std::cout << "Target: all channels" << std::endl;
+      return;
+    }
     try {
-      double freq = std::stod(value);
-      Command cmd(CMD_SET_FREQ, freq);
-      write(fd, &cmd, sizeof(Command));
-      std::cout << "FREQ=" << freq << " Hz sent" << std::endl;
+      int index = std::stoi(value);
+      if (index < 0 || index >= static_cast<int>(MAX_CHANNELS)) throw 0;
+      channel = index;
+      std::cout << "Target: channel " << channel << std::endl;
     } catch (...) {
-      std::cout << "Error: invalid frequency value" << std::endl;
+      std::cout << "Error: use 'channel N' or 'channel all'" << std::endl;
     }
   };
 
+  handlers["at"] = [&](const std::string& value, int) {
+    if (value == "now") {
+      delayMs = -1.0;
+      std::cout << "Timing: immediate" << std::endl;
+      return;
+    }
+    try {
+      double ms = std::stod(value);
+      if (ms < 0.0 || !shm) throw 0;
+      delayMs = ms;
+      std::cout << "Timing: " << ms << " ms after send" << std::endl;
+    } catch (...) {
+      std::cout << "Error: use 'at MS' (needs shared memory) or 'at now'"
+                << std::endl;
+    }
+  };
+
+  handlers["begin"] = [&](const std::string&, int) {
+    batching = true;
+    std::cout << "Batch started ('commit' sends it atomically)" << std::endl;
+  };
+
+  handlers["commit"] = [&](const std::string&, int fd) {
+    batching = false;
+    if (batch.empty()) {
+      std::cout << "Batch empty" << std::endl;
+      return;
+    }
+    std::cout << "BATCH of " << batch.size() << " sent" << std::endl;
+    flush(fd);
+  };
+
+  handlers["start"] = [&](const std::string&, int fd) {
+    submit(Command(CMD_START, 0.0), fd, "START");
+  };
+
+  handlers["stop"] = [&](const std::string&, int fd) {
+    submit(Command(CMD_STOP, 0.0), fd, "STOP");
+  };
+
+  handlers["freq"] = [&](const std::string& value, int fd) {
+    valueCommand(CMD_SET_FREQ, "FREQ", " Hz", value, fd);
+  };
+
   handlers["amp"] = [&](const std::string& value, int fd) {
+    valueCommand(CMD_SET_AMP, "AMP", "", value, fd);
+  };
+
+  handlers["phase"] = [&](const std::string& value, int fd) {
     try {
-      double amp = std::stod(value);
-      Command cmd(CMD_SET_AMP, amp);
-      write(fd, &cmd, sizeof(Command));
-      std::cout << "AMP=" << amp << " sent" << std::endl;
+      double phase = std::stod(value);
+      std::ostringstream description;
+      description << "PHASE=" << phase << " rad";
+      submit(Command(CMD_SET_PHASE, phase), fd, description.str());
     } catch (...) {
-      std::cout << "Error: invalid amplitude value" << std::endl;
+      std::cout << "Error: invalid phase value" << std::endl;
+    }
+  };
+
+  // Reprodução de arquivo (gerador com --file); com outra fonte o gerador
+  // responde "unsupported". Trocar de arquivo não tem comando: o protocolo
+  // só leva números e o arquivo é aberto fora da renderização
+  auto playbackCommand = [&](CommandType type, const std::string& label,
+                             const std::string& unit,
+                             const std::string& value, int fd) {
+    double number;
+    if (!parseNumber(value.c_str(), number) || number < 0.0) {
+      std::cout << "Error: invalid " << label << " value" << std::endl;
+      return;
+    }
+    std::ostringstream description;
+    description << label << "=" << number << unit;
+    submit(Command(type, number), fd, description.str());
+  };
+
+  handlers["speed"] = [&](const std::string& value, int fd) {
+    playbackCommand(CMD_SET_SPEED, "SPEED", "x", value, fd);
+  };
+
+  handlers["seek"] = [&](const std::string& value, int fd) {
+    playbackCommand(CMD_SEEK, "SEEK", " s", value, fd);
+  };
+
+  // Estágio de efeito do canal alvo: tipo e parâmetros vão num só frame.
+  // Repetir o tipo atual só ajusta os parâmetros (o filtro mantém estado)
+  handlers["fx"] = [&](const std::string& args, int fd) {
+    std::istringstream iss(args);
+    uint32_t stage = MAX_EFFECT_STAGES;
+    std::string name;
+    EffectKind kind = EFFECT_NONE;
+    std::vector<double> values;
+    double v;
+    bool parsed = (iss >> stage >> name) && parseEffectKind(name.c_str(), kind);
+    while (parsed && iss >> v) values.push_back(v);
+    parsed = parsed && (iss >> std::ws).eof();
+
+    Command cmds[MAX_EFFECT_COMMANDS];
+    size_t count = parsed ? buildEffectCommands(stage, kind, values,
+                                                framesPerSecond(), cmds)
+                          : 0;
+    if (count == 0) {
+      std::cout << "Error: use 'fx STAGE off', 'fx STAGE "
+                   "lowpass|highpass|bandpass|notch HZ [Q]', 'fx STAGE "
+                   "gain|noise VALUE [RAMP_MS]' or 'fx STAGE mix HZ LEVEL "
+                   "[RAMP_MS]' (STAGE 0-"
+                << MAX_EFFECT_STAGES - 1 << ")" << std::endl;
+      return;
+    }
+    submitGroup(cmds, count, fd, "FX " + args);
+  };
+
+  // Raspa a telemetria do segmento (somente leitura, sem pausar ninguém)
+  handlers["stats"] = [&](const std::string&, int) {
+    if (!shm) {
+      std::cout << "Error: shared memory not attached" << std::endl;
+      return;
+    }
+    const ProducerTelemetry& t = shm->telemetry;
+    uint64_t head = shm->head.load();
+    uint64_t now = monotonicNs();
+    std::cout << "Producer: " << t.samplesProduced.load() << " samples, "
+              << t.framesRendered.load() << " frames ("
+              << t.framesSkipped.load() << " skipped), commands "
+              << t.commandsApplied.load() << " applied / "
+              << t.commandsDropped.load() << " dropped" << std::endl;
+
+    auto histogram = [](const char* label, const TelemetryHistogram& h) {
+      uint64_t count = h.count.load();
+      std::cout << "  " << label;
+      if (count == 0) {
+        std::cout << " no samples" << std::endl;
+        return;
+      }
+      std::cout << " mean " << h.sumNs.load() / count / 1000.0 << " us, p50 < "
+                << h.percentileNs(0.5) / 1000.0 << " us, p99 < "
+                << h.percentileNs(0.99) / 1000.0 << " us, max "
+                << h.maxNs.load() / 1000.0 << " us" << std::endl;
+    };
+    histogram("frame jitter:", t.framePeriodJitter);
+    histogram("generate:    ", t.generateTime);
+    histogram("copy:        ", t.copyTime);
+
+    std::cout << "Consumers:" << std::endl;
+    bool any = false;
+    for (size_t i = 0; i < MAX_CONSUMERS; ++i) {
+      const ConsumerSlot& slot = shm->consumers()[i];
+      uint32_t pid = slot.pid.load();
+      if (pid == 0) continue;
+      any = true;
+      uint64_t tail = slot.tail.load();
+      std::cout << "  " << std::string(slot.name, strnlen(slot.name,
+                                                          CONSUMER_NAME_SIZE))
+                << " (pid " << pid << "): lag "
+                << (head > tail ? head - tail : 0) << " frames, "
+                << slot.samplesConsumed.load() << " samples, "
+                << slot.framesLost.load() << " frames lost in "
+                << slot.overruns.load() << " overrun(s), last read "
+                << (now - slot.updatedNs.load()) / 1000000 << " ms ago"
+                << std::endl;
     }
+    if (!any) std::cout << "  none registered" << std::endl;
   };
 
   handlers["quit"] = [&](const std::string&, int fd) {
-    Command cmd(CMD_QUIT, 0.0);
-    write(fd, &cmd, sizeof(Command));
-    std::cout << "QUIT sent" << std::endl;
-    close(fd);
+    batching = false;
+    channel = ALL_CHANNELS;
+    delayMs = -1.0;
+    submit(Command(CMD_QUIT, 0.0), fd, "QUIT");
+    // flush() pode ter reconectado: o descritor atual é commandFd, não fd
+    if (replyFd >= 0) close(replyFd);
+    close(commandFd);
     exit(0);
   };
 
@@ -72,12 +631,17 @@ int main() {
   for (const auto& [cmd, _] : handlers) {
     std::cout << "  " << cmd << std::endl;
   }
+  std::cout << "  (freq/amp accept an optional ramp in ms: freq 880 250)"
+            << std::endl;
+  std::cout << "  (fx STAGE off|lowpass|highpass|bandpass|notch|gain|noise|mix"
+               " ...: fx 0 lowpass 800)"
+            << std::endl;
   std::cout << "==================\n" << std::endl;
 
   std::string line;
   while (true) {
     std::cout << "> ";
-    std::getline(std::cin, line);
+    if (!std::getline(std::cin, line)) break;
 
     if (line.empty()) continue;
 
@@ -97,6 +661,7 @@ int main() {
     }
   }
 
+  if (replyFd >= 0) close(replyFd);
   close(commandFd);
   return 0;
 }
@@ -1,32 +1,307 @@
+#include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 #include <signal.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
-#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
+#include "../include/AllocationGuard.hpp"
+#include "../include/BlockArena.hpp"
+#include "../include/ChannelEngine.hpp"
+#include "../include/CommandProtocol.hpp"
 #include "../include/Communication.hpp"
+#include "../include/FilePlaybackGenerator.hpp"
+#include "../include/FrameScheduler.hpp"
+#include "../include/RenderPool.hpp"
+#include "../include/RingBuffer.hpp"
+#include "../include/SharedMemory.hpp"
 #include "../include/SineGenerator.hpp"
+#include "../include/SpscQueue.hpp"
+#include "../include/ToolSupport.hpp"
+#include "../include/WavetableGenerator.hpp"
 
-static volatile bool keepRunning = true;
+// Quadros atrasados recuperados por disparo do timer (0,5 s a 20 fps);
+// atrasos maiores viram silêncio em vez de uma rajada de renderização
+constexpr uint64_t MAX_CATCHUP_FRAMES = 10;
+constexpr int REALTIME_PRIORITY = 50;  // Prioridade SCHED_FIFO de --realtime
+constexpr size_t COMMAND_QUEUE_FRAMES = 64;  // Frames entre I/O e renderização
+constexpr size_t REPLY_QUEUE_SIZE = 256;     // Confirmações no sentido inverso
+// Quadros renderizados antes de proibir alocações nesta thread (só com
+// SINE_ALLOC_GUARD; ver AllocationGuard.hpp)
+constexpr uint64_t ALLOC_WARMUP_FRAMES = 20;
+
+static std::atomic<bool> keepRunning(true);
 
 void signalHandler(int) { keepRunning = false; }
 
-int main() {
-  signal(SIGINT, signalHandler);
-  signal(SIGPIPE, SIG_IGN);
+// Frame de comandos decodificado pela thread de I/O
+struct CommandFrame {
+  CommandFrameHeader header;
+  Command commands[MAX_BATCH_COMMANDS];
+};
 
-  std::cout << "\n[GENERATOR] Started (PID: " << getpid() << ")\n" << std::endl;
+// Cria o FIFO `path` se ainda não existir (um FIFO existente é reutilizado)
+static bool ensureFifo(const char* path) {
+  if (mkfifo(path, 0666) == 0) return true;
+  struct stat st;
+  return errno == EEXIST && stat(path, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+// Opções de linha de comando
+struct GeneratorOptions {
+  RingLayout layout;       // Layout do anel (taxa 0 = modo visual legado)
+  bool dither = true;      // Dither TPDF para formatos inteiros
+  bool hugePages = false;  // MADV_HUGEPAGE no segmento
+  bool realtime = false;   // SCHED_FIFO + mlockall
+  unsigned threads = 0;    // Threads de renderização (0 = automático)
+  bool pin = false;        // Fixa cada thread de renderização num núcleo
+  bool wavetable = false;  // Oscilador por tabela em vez do SineGenerator
+  Waveform waveform = WAVE_SINE;  // Forma de onda do oscilador por tabela
+  WavetableGenerator::Interpolation interpolation =
+      WavetableGenerator::INTERP_LINEAR;
+  std::string file;   // Reproduz este arquivo em vez de um oscilador
+  bool loop = false;  // Reprodução em loop
+  double seek = 0.0;   // Posição inicial no arquivo (segundos)
+  double speed = 1.0;  // Velocidade de reprodução
+  // Formato de arquivos crus (padrão: o do anel)
+  SampleFile::RawFormat raw = {FORMAT_F64, 0, 0.0};
+};
+
+static void printUsage(const char* prog) {
+  std::cerr << "Usage: " << prog << " [options]\n"
+            << "  --sample-rate HZ  physical oscillator at HZ samples/s\n"
+            << "                    (default: legacy visual mode)\n"
+            << "  --format FMT      f64|f32|s16|s24 sample format in shared "
+               "memory (default f64)\n"
+            << "  --no-dither       plain rounding for integer formats\n"
+            << "  --channels N      independent channels, 1 to " << MAX_CHANNELS
+            << " (default 1)\n"
+            << "  --layout L        interleaved|planar channel layout "
+               "(default interleaved)\n"
+            << "  --capacity N      ring capacity in frames, power of 2 "
+               "(default "
+            << DEFAULT_BUFFER_CAPACITY << ")\n"
+            << "  --huge-pages      back the ring with transparent huge pages\n"
+            << "  --waveform W      sine|square|saw|triangle wavetable "
+               "oscillator\n"
+            << "                    (band-limited; needs --sample-rate)\n"
+            << "  --interp I        linear|cubic wavetable interpolation "
+               "(default linear)\n"
+            << "  --threads N       render threads (default: one per core, "
+               "up to the channel count)\n"
+            << "  --pin             pin each render thread to its own core\n"
+            << "  --file PATH       play a WAV or raw file (channel c plays "
+               "file channel\n"
+            << "                    c mod file channels; needs --sample-rate)\n"
+            << "  --loop            loop the file\n"
+            << "  --seek SEC        start SEC seconds into the file\n"
+            << "  --speed X         playback speed factor, "
+            << FilePlaybackGenerator::MIN_SPEED << " to "
+            << FilePlaybackGenerator::MAX_SPEED << " (default 1)\n"
+            << "  --file-format FMT, --file-channels N, --file-rate HZ\n"
+            << "                    raw file layout (default: the ring's)\n"
+            << "  --realtime        SCHED_FIFO priority " << REALTIME_PRIORITY
+            << " and locked memory" << std::endl;
+}
+
+static bool parseOptions(int argc, char* argv[], GeneratorOptions& options) {
+  RingLayout& layout = options.layout;
+  double value;
+  bool rawFormatGiven = false;
+
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--sample-rate") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value <= 0.0) {
+        std::cerr << "[GENERATOR] Invalid sample rate" << std::endl;
+        return false;
+      }
+      layout.sampleRate = value;
+    } else if (strcmp(argv[i], "--format") == 0 && hasValue) {
+      if (!parseSampleFormat(argv[++i], layout.format)) {
+        std::cerr << "[GENERATOR] Unknown sample format" << std::endl;
+        return false;
+      }
+    } else if (strcmp(argv[i], "--channels") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 1.0 ||
+          value > MAX_CHANNELS || value != std::floor(value)) {
+        std::cerr << "[GENERATOR] Invalid channel count" << std::endl;
+        return false;
+      }
+      layout.channels = static_cast<uint32_t>(value);
+    } else if (strcmp(argv[i], "--layout") == 0 && hasValue) {
+      const char* name = argv[++i];
+      if (strcmp(name, "interleaved") == 0) {
+        layout.channelLayout = LAYOUT_INTERLEAVED;
+      } else if (strcmp(name, "planar") == 0) {
+        layout.channelLayout = LAYOUT_PLANAR;
+      } else {
+        std::cerr << "[GENERATOR] Unknown channel layout" << std::endl;
+        return false;
+      }
+    } else if (strcmp(argv[i], "--no-dither") == 0) {
+      options.dither = false;
+    } else if (strcmp(argv[i], "--capacity") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 2.0 || value > 1e12) {
+        std::cerr << "[GENERATOR] Invalid capacity" << std::endl;
+        return false;
+      }
+      layout.capacity = static_cast<uint64_t>(value);
+    } else if (strcmp(argv[i], "--huge-pages") == 0) {
+      options.hugePages = true;
+    } else if (strcmp(argv[i], "--realtime") == 0) {
+      options.realtime = true;
+    } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 1.0 || value > 1024.0 ||
+          value != std::floor(value)) {
+        std::cerr << "[GENERATOR] Invalid thread count" << std::endl;
+        return false;
+      }
+      options.threads = static_cast<unsigned>(value);
+    } else if (strcmp(argv[i], "--pin") == 0) {
+      options.pin = true;
+    } else if (strcmp(argv[i], "--file") == 0 && hasValue) {
+      options.file = argv[++i];
+    } else if (strcmp(argv[i], "--loop") == 0) {
+      options.loop = true;
+    } else if (strcmp(argv[i], "--seek") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 0.0) {
+        std::cerr << "[GENERATOR] Invalid seek position" << std::endl;
+        return false;
+      }
+      options.seek = value;
+    } else if (strcmp(argv[i], "--speed") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) ||
+          value < FilePlaybackGenerator::MIN_SPEED ||
+          value > FilePlaybackGenerator::MAX_SPEED) {
+        std::cerr << "[GENERATOR] Invalid playback speed" << std::endl;
+        return false;
+      }
+      options.speed = value;
+    } else if (strcmp(argv[i], "--file-format") == 0 && hasValue) {
+      if (!parseSampleFormat(argv[++i], options.raw.format)) {
+        std::cerr << "[GENERATOR] Unknown sample format" << std::endl;
+        return false;
+      }
+      rawFormatGiven = true;
+    } else if (strcmp(argv[i], "--file-channels") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 1.0 ||
+          value > 65535.0 || value != std::floor(value)) {
+        std::cerr << "[GENERATOR] Invalid file channel count" << std::endl;
+        return false;
+      }
+      options.raw.channels = static_cast<uint32_t>(value);
+    } else if (strcmp(argv[i], "--file-rate") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value <= 0.0) {
+        std::cerr << "[GENERATOR] Invalid file sample rate" << std::endl;
+        return false;
+      }
+      options.raw.sampleRate = value;
+    } else if (strcmp(argv[i], "--waveform") == 0 && hasValue) {
+      if (!parseWaveform(argv[++i], options.waveform)) {
+        std::cerr << "[GENERATOR] Unknown waveform" << std::endl;
+        return false;
+      }
+      options.wavetable = true;
+    } else if (strcmp(argv[i], "--interp") == 0 && hasValue) {
+      const char* name = argv[++i];
+      if (strcmp(name, "linear") == 0) {
+        options.interpolation = WavetableGenerator::INTERP_LINEAR;
+      } else if (strcmp(name, "cubic") == 0) {
+        options.interpolation = WavetableGenerator::INTERP_CUBIC;
+      } else {
+        std::cerr << "[GENERATOR] Unknown interpolation" << std::endl;
+        return false;
+      }
+    } else {
+      printUsage(argv[0]);
+      return false;
+    }
+  }
 
-  // Cria gerador senoidal - frequência inicial 100 Hz, amplitude 0.8
-  SineGenerator generator(/*sampleRate*/ 1.0, 100.0, 0.8);
+  if (options.wavetable && layout.sampleRate <= 0.0) {
+    std::cerr << "[GENERATOR] --waveform requires --sample-rate" << std::endl;
+    return false;
+  }
+  if (!options.file.empty() && layout.sampleRate <= 0.0) {
+    std::cerr << "[GENERATOR] --file requires --sample-rate" << std::endl;
+    return false;
+  }
+  if (!rawFormatGiven) options.raw.format = layout.format;
+  if (options.raw.channels == 0) options.raw.channels = layout.channels;
+  if (options.raw.sampleRate <= 0.0) options.raw.sampleRate = layout.sampleRate;
+
+  if (!isValidLayout(layout)) {
+    std::cerr << "[GENERATOR] Capacity must be a power of 2" << std::endl;
+    return false;
+  }
+
+  // Um quadro inteiro precisa caber no buffer circular
+  double frameSamples = layout.sampleRate > 0.0
+                            ? layout.sampleRate * FRAME_INTERVAL_MS / 1000.0
+                            : SAMPLES_PER_FRAME;
+  if (std::ceil(frameSamples) > static_cast<double>(layout.capacity)) {
+    std::cerr << "[GENERATOR] Ring capacity smaller than one frame"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Serve comandos e renderiza até o QUIT (ou SIGINT) com os canais de
+ * `engine`. Instanciado uma vez por tipo de fonte: com um gerador concreto
+ * o laço de renderização chama o bloco dele diretamente, sem despacho
+ * virtual por canal.
+ */
+template <typename Generator>
+static int serve(const GeneratorOptions& options,
+                 BasicChannelEngine<Generator>& engine) {
+  const RingLayout& layout = options.layout;
+  double sampleRate = layout.sampleRate;
+  bool physical = sampleRate > 0.0;
+
+  // Efeitos por canal só no modo físico: filtros e rampas precisam do
+  // relógio de amostras real
+  if (physical) engine.enableEffects(sampleRate);
+
+  // Assume a memória compartilhada antes de tudo: falha cedo se outro
+  // gerador estiver ativo. Um segmento de uma execução anterior com o mesmo
+  // layout é reaproveitado, e os consumidores conectados continuam lendo
+  const char* shmError;
+  SharedBuffer* buffer = createSharedBuffer(SHARED_MEMORY_NAME, layout,
+                                            options.hugePages, shmError);
+  if (!buffer) {
+    std::cerr << "[GENERATOR] " << shmError << std::endl;
+    return 1;
+  }
+  if (shmError) std::cerr << "[GENERATOR] Warning: " << shmError << std::endl;
+  uint32_t epoch = buffer->epoch.load();
+  if (epoch > 1) {
+    std::cout << "[GENERATOR] Reusing shared memory (epoch " << epoch
+              << ", frame " << buffer->epochStart.load() << ")" << std::endl;
+  }
 
-  // Cria FIFO para receber comandos
-  unlink(FIFO_COMMAND);
-  if (mkfifo(FIFO_COMMAND, 0666) < 0) {
+  // Os FIFOs de comandos e de confirmações também sobrevivem ao gerador:
+  // um controlador já bloqueado no open() continua esperando o próximo
+  if (!ensureFifo(FIFO_COMMAND) || !ensureFifo(FIFO_REPLY)) {
     std::cerr << "[GENERATOR] Failed to create FIFO" << std::endl;
+    releaseProducerBuffer(buffer);
     return 1;
   }
 
@@ -34,104 +309,421 @@ int main() {
   int cmdFd = open(FIFO_COMMAND, O_RDONLY | O_NONBLOCK);
   if (cmdFd < 0) {
     std::cerr << "[GENERATOR] Failed to open FIFO" << std::endl;
+    releaseProducerBuffer(buffer);
     return 1;
   }
 
-  // Cria memória compartilhada para transferência de amostras
-  shm_unlink(SHARED_MEMORY_NAME);
-  int shmFd = shm_open(SHARED_MEMORY_NAME, O_CREAT | O_RDWR, 0666);
-  if (shmFd < 0) {
-    std::cerr << "[GENERATOR] Failed to create shared memory" << std::endl;
+  // Mantém um escritor próprio aberto: sem ele, poll() reportaria POLLHUP
+  // continuamente depois que o controlador fechasse o FIFO
+  int cmdKeepAliveFd = open(FIFO_COMMAND, O_WRONLY | O_NONBLOCK);
+
+  // Relógio de quadros com prazos absolutos: só fica armado enquanto algum
+  // canal está ativo
+  FrameScheduler scheduler(FRAME_INTERVAL_MS * 1000000LL, MAX_CATCHUP_FRAMES);
+  if (cmdKeepAliveFd < 0 || !scheduler.isValid()) {
+    std::cerr << "[GENERATOR] Failed to set up event sources" << std::endl;
+    if (cmdKeepAliveFd >= 0) close(cmdKeepAliveFd);
     close(cmdFd);
+    releaseProducerBuffer(buffer);
     return 1;
   }
 
-  // Ajusta tamanho da memória compartilhada
-  if (ftruncate(shmFd, sizeof(SharedBuffer)) < 0) {
-    std::cerr << "[GENERATOR] Failed to set shared memory size" << std::endl;
+  // Publica a frequência atual de cada canal para os consumidores
+  auto publishFrequencies = [&]() {
+    for (uint32_t c = 0; c < engine.channelCount(); ++c) {
+      buffer->frequency[c].store(
+          engine.channel(c).getParameter(PARAM_FREQUENCY));
+    }
+  };
+  publishFrequencies();
+  RingWriter writer(buffer, options.dither);
+
+  // No modo físico o tamanho do quadro segue a taxa de amostragem. O quadro
+  // n termina na amostra floor(n * samplesPerFrame), calculada do índice e
+  // não acumulada, então o relógio de amostras não deriva em horas de
+  // execução (ex.: 44100 Hz alterna quadros de 2205 amostras exatas)
+  double samplesPerFrame =
+      physical ? sampleRate * FRAME_INTERVAL_MS / 1000.0 : SAMPLES_PER_FRAME;
+  uint64_t frameIndex = 0;
+  auto frameEnd = [&](uint64_t n) {
+    return static_cast<uint64_t>(std::floor(n * samplesPerFrame));
+  };
+
+  // Com o anel em double planar os canais geram direto nos slots
+  // (RingWriter::reserve) e o quadro é publicado sem cópia. Nos demais
+  // formatos geram num bloco planar de trabalho, tirado de uma arena
+  // dimensionada pelo layout e já com as páginas presentes, que
+  // RingWriter::write converte numa única publicação (sem malloc no caminho
+  // quente)
+  size_t maxFrameSize = static_cast<size_t>(std::ceil(samplesPerFrame));
+  bool inPlace = writer.supportsInPlace() && maxFrameSize <= layout.capacity;
+  size_t frameSamples = inPlace ? 0 : maxFrameSize * layout.channels;
+  BlockArena arena(BlockArena::bytesFor<double>(frameSamples));
+  double* frame = arena.allocate<double>(frameSamples);
+  if (!inPlace && !frame) {
+    std::cerr << "[GENERATOR] Failed to map the work block" << std::endl;
+    close(cmdKeepAliveFd);
     close(cmdFd);
-    close(shmFd);
+    releaseProducerBuffer(buffer);
     return 1;
   }
 
-  // Mapeia memória compartilhada no espaço de endereço do processo
-  SharedBuffer* buffer =
-      (SharedBuffer*)mmap(nullptr, sizeof(SharedBuffer), PROT_READ | PROT_WRITE,
-                          MAP_SHARED, shmFd, 0);
+  std::cout << "[GENERATOR] Ring: " << layout.capacity << " frames x "
+            << layout.channels << " channel(s), "
+            << (layout.channelLayout == LAYOUT_PLANAR ? "planar"
+                                                      : "interleaved")
+            << ", " << sampleFormatName(layout.format) << " ("
+            << buffer->totalSize << " bytes of shared memory"
+            << (inPlace ? ", rendered in place" : "") << ")" << std::endl;
 
-  if (buffer == MAP_FAILED) {
-    std::cerr << "[GENERATOR] Failed to map shared memory" << std::endl;
+  // Threads: a de I/O (esta seção) lê e decodifica o FIFO e escreve as
+  // confirmações; a principal só aplica comandos e renderiza. Elas trocam
+  // frames e confirmações por filas SPSC sem locks, acordando uma à outra
+  // por eventfd
+  int renderWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  int ioWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (renderWakeFd < 0 || ioWakeFd < 0) {
+    std::cerr << "[GENERATOR] Failed to create event descriptors" << std::endl;
+    if (renderWakeFd >= 0) close(renderWakeFd);
+    if (ioWakeFd >= 0) close(ioWakeFd);
+    close(cmdKeepAliveFd);
     close(cmdFd);
-    close(shmFd);
+    releaseProducerBuffer(buffer);
     return 1;
   }
+  auto commandQueue =
+      std::make_unique<SpscQueue<CommandFrame, COMMAND_QUEUE_FRAMES>>();
+  auto replyQueue =
+      std::make_unique<SpscQueue<CommandReply, REPLY_QUEUE_SIZE>>();
+
+  auto ioThreadFunc = [&]() {
+    CommandDecoder decoder;
+    CommandFrame incoming;
+    CommandReply reply;
+    int replyFd = -1;  // Aberto sob demanda (ver sendReply)
+    struct pollfd fds[2] = {{cmdFd, POLLIN, 0}, {ioWakeFd, POLLIN, 0}};
+
+    while (keepRunning) {
+      if (poll(fds, 2, -1) < 0) continue;
+
+      if (fds[1].revents & POLLIN) drain(ioWakeFd);
+      while (replyQueue->pop(reply)) sendReply(replyFd, reply);
+
+      // Repassa todos os frames completos; leituras curtas ficam no decoder
+      if (fds[0].revents & POLLIN) {
+        decoder.fill(cmdFd);
+        bool queued = false;
+        while (decoder.next(incoming.header, incoming.commands)) {
+          if (commandQueue->push(incoming)) {
+            queued = true;
+            continue;
+          }
+          // Renderização atrasada demais para consumir: recusa aqui mesmo
+          buffer->telemetry.commandsDropped.fetch_add(
+              incoming.header.count, std::memory_order_relaxed);
+          std::cerr << "[GENERATOR] Rejected batch " << incoming.header.seq
+                    << ": " << replyStatusName(REPLY_QUEUE_FULL) << std::endl;
+          if (incoming.header.flags & CMD_FLAG_ACK) {
+            reply = {CMD_REPLY_MAGIC, incoming.header.seq, REPLY_QUEUE_FULL,
+                     incoming.header.count, buffer->head.load()};
+            sendReply(replyFd, reply);
+          }
+        }
+        if (queued) notify(renderWakeFd);
+      }
+    }
+
+    // Confirmações produzidas até o fim (ex.: a do QUIT)
+    while (replyQueue->pop(reply)) sendReply(replyFd, reply);
+    if (replyFd >= 0) close(replyFd);
+  };
 
-  // Inicializa o buffer (garante membros zerados)
-  new (buffer) SharedBuffer();
+  // A thread de I/O nasce antes do modo tempo real (fica com a política
+  // normal) e com os sinais bloqueados (SIGINT chega sempre à principal)
+  sigset_t allSignals, previousSignals;
+  sigfillset(&allSignals);
+  pthread_sigmask(SIG_BLOCK, &allSignals, &previousSignals);
+  std::thread ioThread(ioThreadFunc);
+  pthread_sigmask(SIG_SETMASK, &previousSignals, nullptr);
 
+  // Modo tempo real só depois de alocar e mapear tudo (mlockall cobre o
+  // segmento e o bloco de trabalho)
+  if (options.realtime) {
+    const char* rtError;
+    if (enableRealtime(REALTIME_PRIORITY, rtError)) {
+      std::cout << "[GENERATOR] Real-time mode: SCHED_FIFO "
+                << REALTIME_PRIORITY << ", memory locked" << std::endl;
+    } else {
+      std::cerr << "[GENERATOR] Warning: " << rtError << std::endl;
+    }
+  }
+
+  // Pool de renderização: criado depois do modo tempo real para que os
+  // workers herdem SCHED_FIFO. Por padrão uma thread por núcleo, sem passar
+  // do número de canais (cada canal é uma tarefa)
+  unsigned threads = options.threads;
+  if (threads == 0) {
+    threads = std::max(1u, std::min(std::thread::hardware_concurrency(),
+                                    layout.channels));
+  }
+  RenderPool pool(threads, options.pin);
+  if (pool.threads() > 1) engine.setPool(&pool);
+  std::cout << "[GENERATOR] Render threads: " << pool.threads()
+            << (options.pin ? " (pinned)" : "") << std::endl;
+  if (pool.pinFailures()) {
+    std::cerr << "[GENERATOR] Warning: failed to pin " << pool.pinFailures()
+              << " render thread(s)" << std::endl;
+  }
   std::cout << "[GENERATOR] Ready. Waiting for commands...\n" << std::endl;
 
-  Command cmd;
-  auto lastFrameTime = std::chrono::steady_clock::now();
+  CommandFrame frameIn;
+
+  // Telemetria do produtor (esta thread é a única escritora, exceto
+  // commandsDropped): relaxed, raspada por ferramentas externas
+  ProducerTelemetry& telemetry = buffer->telemetry;
+  auto store = [](std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(value, std::memory_order_relaxed);
+  };
+  const uint64_t frameIntervalNs = FRAME_INTERVAL_MS * 1000000ULL;
+  uint64_t lastTickNs = 0;  // Último disparo do relógio (0 = recém-armado)
+
+  // O timer só fica armado enquanto algum canal estiver ativo; cada início
+  // ancora novos prazos
+  auto updateTimer = [&](bool wasRunning) {
+    if (engine.isRunning() && !wasRunning) {
+      scheduler.start();
+      lastTickNs = 0;  // O primeiro disparo não tem período anterior
+    } else if (!engine.isRunning() && wasRunning) {
+      scheduler.stop();
+    }
+  };
+
+  // Valida o lote inteiro antes de aplicar qualquer comando: ou tudo vale,
+  // ou nada. Comandos com atFrame futuro vão para a fila do engine; START é
+  // sempre imediato (com o gerador parado o relógio de amostras não anda).
+  auto applyBatch = [&](const Command* cmds, size_t count) {
+    uint64_t now = writer.head();
+    size_t scheduled = 0;
+    for (size_t i = 0; i < count; ++i) {
+      if (cmds[i].type <= CMD_NONE || cmds[i].type > CMD_SEEK) {
+        return REPLY_MALFORMED;
+      }
+      if ((cmds[i].type == CMD_SET_SPEED || cmds[i].type == CMD_SEEK) &&
+          !std::is_same<Generator, FilePlaybackGenerator>::value) {
+        return REPLY_UNSUPPORTED;
+      }
+      if (cmds[i].type == CMD_SET_EFFECT) {
+        if (!engine.hasEffects()) return REPLY_UNSUPPORTED;
+        if (!isValidEffectCommand(cmds[i])) return REPLY_MALFORMED;
+      }
+      if (!engine.isValidTarget(cmds[i].channel)) {
+        return REPLY_INVALID_CHANNEL;
+      }
+      if (cmds[i].type != CMD_START && cmds[i].atFrame > now) ++scheduled;
+    }
+    if (scheduled > engine.freeCommandSlots()) return REPLY_QUEUE_FULL;
+
+    bool wasRunning = engine.isRunning();
+    for (size_t i = 0; i < count; ++i) {
+      const Command& cmd = cmds[i];
+      if (cmd.type == CMD_QUIT) {
+        keepRunning = false;
+      } else if (cmd.type != CMD_START && cmd.atFrame > now) {
+        engine.schedule(cmd);
+      } else {
+        engine.apply(cmd);
+      }
+    }
+    publishFrequencies();
+    updateTimer(wasRunning);
+    return REPLY_OK;
+  };
+
+  struct pollfd fds[2] = {{renderWakeFd, POLLIN, 0},
+                          {scheduler.fd(), POLLIN, 0}};
+  AllocationWarmup warmup(ALLOC_WARMUP_FRAMES);
 
   while (keepRunning) {
-    // Lê comandos recebidos (não-bloqueante)
-    ssize_t bytesRead = read(cmdFd, &cmd, sizeof(Command));
-    if (bytesRead == sizeof(Command)) {
-      switch (cmd.type) {
-        case CMD_START:
-          generator.start();
-          break;
-        case CMD_STOP:
-          generator.stop();
-          break;
-        case CMD_SET_FREQ:
-          generator.setParameter("frequency", cmd.value);
-          break;
-        case CMD_SET_AMP:
-          generator.setParameter("amplitude", cmd.value);
-          break;
-        case CMD_QUIT:
-          keepRunning = false;
-          break;
-        default:
-          break;
+    // Dorme até chegar um comando ou vencer o próximo quadro
+    if (poll(fds, 2, -1) < 0) continue;  // EINTR: reavalia keepRunning
+
+    // Aplica os frames repassados pela thread de I/O, em ordem
+    if (fds[0].revents & POLLIN) {
+      drain(renderWakeFd);
+      bool replied = false;
+      while (commandQueue->pop(frameIn)) {
+        const CommandFrameHeader& header = frameIn.header;
+        ReplyStatus status = applyBatch(frameIn.commands, header.count);
+        if (status == REPLY_OK) {
+          store(telemetry.commandsApplied,
+                telemetry.commandsApplied.load() + header.count);
+        } else {
+          telemetry.commandsDropped.fetch_add(header.count,
+                                              std::memory_order_relaxed);
+          std::cerr << "[GENERATOR] Rejected batch " << header.seq << ": "
+                    << replyStatusName(status) << std::endl;
+        }
+        if (header.flags & CMD_FLAG_ACK) {
+          CommandReply reply = {CMD_REPLY_MAGIC, header.seq, status,
+                                header.count, writer.head()};
+          replied |= replyQueue->push(reply);
+        }
       }
+      if (replied) notify(ioWakeFd);
     }
 
-    // Gera novo quadro em intervalos fixos
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now - lastFrameTime);
-
-    if (elapsed.count() >= FRAME_INTERVAL_MS) {
-      // Gera amostras apenas se o gerador estiver ativo
-      if (generator.isRunning()) {
-        auto samples = generator.generateSamples(SAMPLES_PER_FRAME);
-        if (!samples.empty()) {
-          for (double sample : samples) {
-            buffer->samples[buffer->writePos] = sample;
-            buffer->writePos = (buffer->writePos + 1) % BUFFER_SIZE;
-            buffer->totalProduced++;
-
-            // Se buffer cheio, avança readPos (descarta o mais antigo)
-            if (buffer->writePos == buffer->readPos) {
-              buffer->readPos = (buffer->readPos + 1) % BUFFER_SIZE;
-            }
+    // Gera um quadro por prazo vencido (vários se o processo atrasou)
+    if (fds[1].revents & POLLIN) {
+      uint64_t skippedBefore = scheduler.skipped();
+      uint64_t due = scheduler.framesDue();
+      uint64_t skipped = scheduler.skipped() - skippedBefore;
+      if (skipped > 0) {
+        std::cerr << "[GENERATOR] Stall: dropped " << skipped << " frame(s)"
+                  << std::endl;
+      }
+
+      // Jitter do período: distância entre o intervalo real desde o último
+      // disparo e o nominal dos quadros que ele trouxe
+      uint64_t tickNs = monotonicNs();
+      uint64_t expectedNs = (due + skipped) * frameIntervalNs;
+      if (lastTickNs != 0 && due > 0) {
+        uint64_t periodNs = tickNs - lastTickNs;
+        telemetry.framePeriodJitter.record(periodNs > expectedNs
+                                               ? periodNs - expectedNs
+                                               : expectedNs - periodNs);
+      }
+      lastTickNs = tickNs;
+      store(telemetry.framesSkipped, scheduler.skipped());
+
+      // Os quadros descartados viram silêncio publicado de uma vez: o
+      // relógio de amostras (e frameEnd) continua preso ao monotônico e
+      // gravações, timestamps e atFrame não derivam depois do travamento
+      if (skipped > 0 && engine.isRunning()) {
+        writer.skip(frameEnd(frameIndex + skipped) - frameEnd(frameIndex));
+        frameIndex += skipped;
+      }
+
+      // Gera amostras apenas se algum canal estiver ativo
+      bool wasRunning = engine.isRunning();
+      for (; due > 0 && engine.isRunning(); --due) {
+        size_t frameSize =
+            static_cast<size_t>(frameEnd(frameIndex + 1) - frameEnd(frameIndex));
+        ++frameIndex;
+
+        // Canais em paralelo no pool; comandos agendados valem na amostra
+        // exata (modo físico)
+        uint64_t renderStart = monotonicNs();
+        uint64_t copyStart;
+        if (inPlace) {
+          // Direto nos slots: dois trechos se o quadro cruza o fim do anel
+          RingRegion regions[2];
+          size_t count = writer.reserve(frameSize, regions);
+          uint64_t start = writer.head();
+          for (size_t r = 0; r < count; ++r) {
+            engine.render(regions[r].planes, regions[r].planeStride,
+                          regions[r].frames, start, physical);
+            start += regions[r].frames;
           }
-          buffer->newDataAvailable = true;
+          copyStart = monotonicNs();
+          writer.commit();
+        } else {
+          engine.render(frame, frameSize, writer.head(), physical);
+          copyStart = monotonicNs();
+          writer.write(frame, frameSize);
         }
+        // Em ambos o quadro de todos os canais fica visível de uma vez
+        // (nunca bloqueia; ver política de overrun em SharedBuffer)
+        uint64_t copyEnd = monotonicNs();
+
+        telemetry.generateTime.record(copyStart - renderStart);
+        telemetry.copyTime.record(copyEnd - copyStart);
+        store(telemetry.samplesProduced,
+              telemetry.samplesProduced.load() + frameSize * layout.channels);
+        store(telemetry.framesRendered, telemetry.framesRendered.load() + 1);
+        store(telemetry.updatedNs, copyEnd);
+        warmup.tick();
+        if (warmup.armed()) pool.armAllocationGuard();
       }
-      lastFrameTime = now;
+      publishFrequencies();  // Rampas e comandos agendados mudam frequências
+      updateTimer(wasRunning);
     }
   }
 
+  allocationGuardDisarm();  // A limpeza abaixo pode alocar
+
+  // Encerra a thread de I/O (depois de ela enviar as últimas confirmações)
+  keepRunning = false;
+  notify(ioWakeFd);
+  ioThread.join();
+
   // Limpeza
+  close(renderWakeFd);
+  close(ioWakeFd);
+  close(cmdKeepAliveFd);
   close(cmdFd);
-  munmap(buffer, sizeof(SharedBuffer));
-  close(shmFd);
-  unlink(FIFO_COMMAND);
+  releaseProducerBuffer(buffer);
 
   std::cout << "\n[GENERATOR] Shut down" << std::endl;
   return 0;
 }
+
+int main(int argc, char* argv[]) {
+  GeneratorOptions options;
+  if (!parseOptions(argc, argv, options)) return 1;
+  const RingLayout& layout = options.layout;
+  double sampleRate = layout.sampleRate;
+
+  signal(SIGINT, signalHandler);
+  signal(SIGPIPE, SIG_IGN);
+
+  std::cout << "\n[GENERATOR] Started (PID: " << getpid() << ")\n" << std::endl;
+
+  // Arquivo a reproduzir: mapeado uma vez e compartilhado pelos canais
+  FilePlaybackGenerator::FilePtr file;
+  if (!options.file.empty()) {
+    const char* fileError;
+    file = SampleFile::open(options.file, options.raw, fileError);
+    if (!file) {
+      std::cerr << "[GENERATOR] " << options.file << ": " << fileError
+                << std::endl;
+      return 1;
+    }
+    std::cout << "[GENERATOR] Playing " << options.file << " ("
+              << file->channels() << " channel(s), " << file->sampleRate()
+              << " Hz, " << file->frames() / file->sampleRate() << " s"
+              << (options.loop ? ", looped" : "") << ")" << std::endl;
+  }
+
+  // Cria um gerador por canal - frequência inicial 100 Hz, amplitude 0.8;
+  // cada canal é ajustado individualmente por comandos. Todos os canais
+  // usam a mesma fonte, então o engine é especializado no tipo dela
+  if (file) {
+    BasicChannelEngine<FilePlaybackGenerator> engine;
+    for (uint32_t c = 0; c < layout.channels; ++c) {
+      auto player = std::make_unique<FilePlaybackGenerator>(
+          sampleRate, options.raw, file, c % file->channels(), options.loop);
+      player->setParameter(PARAM_SPEED, options.speed);
+      if (options.seek > 0.0) {
+        player->setParameter(PARAM_POSITION, options.seek);
+      }
+      engine.addChannel(std::move(player));
+    }
+    return serve(options, engine);
+  }
+  if (options.wavetable) {
+    BasicChannelEngine<WavetableGenerator> engine;
+    for (uint32_t c = 0; c < layout.channels; ++c) {
+      engine.addChannel(std::make_unique<WavetableGenerator>(
+          sampleRate, 100.0, 0.8, options.waveform, options.interpolation));
+    }
+    return serve(options, engine);
+  }
+  bool physical = sampleRate > 0.0;
+  BasicChannelEngine<SineGenerator> engine;
+  for (uint32_t c = 0; c < layout.channels; ++c) {
+    engine.addChannel(std::make_unique<SineGenerator>(
+        physical ? sampleRate : 1.0, 100.0, 0.8,
+        physical ? SineGenerator::MODE_PHYSICAL : SineGenerator::MODE_VISUAL));
+  }
+  return serve(options, engine);
+}
@@ -9,26 +9,144 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
-#include <chrono>
-#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <string>
 #include <thread>
+#include <vector>
 
+#include "../include/AllocationGuard.hpp"
+#include "../include/BlockArena.hpp"
 #include "../include/Communication.hpp"
+#include "../include/EdgeTrigger.hpp"
+#include "../include/RingBuffer.hpp"
+#include "../include/SampleHistory.hpp"
+#include "../include/SeqLock.hpp"
+#include "../include/SharedMemory.hpp"
+#include "../include/SpectrumAnalyzer.hpp"
+#include "../include/TripleBuffer.hpp"
+#include "../include/WaveformRenderer.hpp"
 
 // Configuração da janela
 const int WINDOW_WIDTH = 800;   // Largura da janela em pixels
 const int WINDOW_HEIGHT = 400;  // Altura da janela em pixels
 const int MAX_DISPLAY_POINTS =
-    800;  // Número máximo de amostras exibidas na tela
+    800;  // Amostras exibidas no modo visual (um quadro do gerador)
+const size_t MAX_HISTORY_SAMPLES =
+    16384;  // Amostras exibidas no modo físico antes de decimar na leitura
 const int UI_UPDATE_INTERVAL_MS =
-    30;  // Intervalo de atualização da interface (~33 fps)
+    16;  // Intervalo de atualização da interface (~60 fps)
+const int READER_WAIT_TIMEOUT_MS =
+    100;  // Espera máxima no futex antes de reavaliar `running`
+const double AUTO_TRIGGER_MS =
+    200.0;  // Sem disparo por este tempo, a tela volta a rolar (modo auto)
+const uint64_t READER_WARMUP_LOOPS =
+    50;  // Leituras antes de proibir alocações (só com SINE_ALLOC_GUARD)
+
+// Configuração do analisador de espectro
+const int SPECTRUM_HEIGHT = 250;         // Altura do painel de espectro
+const size_t DEFAULT_FFT_SIZE = 4096;    // Pontos da FFT (potência de 2)
+const size_t MIN_FFT_SIZE = 256;         // Menor FFT aceita em --fft
+const size_t MAX_FFT_SIZE = 65536;       // Maior FFT aceita em --fft
+const size_t SPECTRUM_OVERLAP = 4;       // Quadros por janela (hop = N / 4)
+const size_t SPECTRUM_READ_CHUNK = 4096;  // Amostras por leitura do anel
+const double SPECTRUM_MIN_FREQ = 10.0;    // Início do eixo log de frequência
+const double SPECTRUM_FLOOR_DB = -120.0;  // Base do eixo de magnitude
+const double PEAK_DECAY_DB_PER_S = 20.0;  // Queda do pico retido
+
+// Mapeamento de zoom para sinais com taxa de amostragem física: em baixas
+// frequências poucos ciclos na tela (zoom in), em altas muitos (zoom out)
+const double DISPLAY_MIN_FREQ = 1.0;      // Frequência mapeada em MIN_CYCLES
+const double DISPLAY_MAX_FREQ = 22000.0;  // Frequência mapeada em MAX_CYCLES
+const double DISPLAY_MIN_CYCLES = 0.5;    // Mínimo de ciclos na tela
+const double DISPLAY_MAX_CYCLES = 12.0;   // Máximo de ciclos na tela
+
+// Quantos ciclos de uma onda de `freq` Hz devem aparecer na tela. Interpola
+// linearmente entre os limites de ciclos conforme a posição log de `freq`.
+static double displayCyclesFor(double freq) {
+  double logMin = log10(DISPLAY_MIN_FREQ);
+  double logMax = log10(DISPLAY_MAX_FREQ);
+  double ratio = std::clamp((log10(freq) - logMin) / (logMax - logMin), 0.0,
+                            1.0);
+  return DISPLAY_MIN_CYCLES +
+         ratio * (DISPLAY_MAX_CYCLES - DISPLAY_MIN_CYCLES);
+}
+
+// Trigger e base de tempo escolhidos na interface (publicados juntos)
+struct DisplaySettings {
+  TriggerMode mode;     // Borda de disparo (ou desligado)
+  double level;         // Nível de disparo
+  double holdoffMs;     // Tempo ignorado depois de cada aquisição
+  double timePerDivMs;  // Base de tempo (0 = automática pela frequência)
+};
+
+// Último espectro analisado (vetores com capacidade fixa, sem realocação)
+struct SpectrumSnapshot {
+  std::vector<float> magnitude;  // Magnitude linear por bin (0..N/2)
+  std::vector<float> peak;       // Pico retido por bin
+  double sampleRate = 0.0;       // Taxa do sinal analisado (0 = sem espectro)
+  SpectrumAnalyzer::Measurement measurement = {0.0, 0.0, 0.0};
+};
+
+// Memória de trabalho das threads de leitura, dimensionada pelo cabeçalho do
+// segmento e tirada de uma única BlockArena na partida. A taxa de
+// amostragem é fixa enquanto o segmento existir: no modo visual a janela
+// nunca passa de um quadro do gerador. Nenhuma leitura pede mais quadros do
+// que o anel guarda, e readChannel entrega um canal só, então os channels
+// do anel não entram na conta
+struct ViewerBuffers {
+  size_t history;        // Amostras do histórico e de cada janela publicada
+  size_t readChunk;      // Quadros por leitura (forma de onda)
+  size_t spectrumChunk;  // Quadros por leitura (espectro)
+
+  explicit ViewerBuffers(const SharedBuffer* buffer)
+      : history(buffer->sampleRate.load() > 0.0 ? MAX_HISTORY_SAMPLES
+                                                : MAX_DISPLAY_POINTS),
+        readChunk(std::min<uint64_t>(MAX_DISPLAY_POINTS, buffer->capacity)),
+        spectrumChunk(
+            std::min<uint64_t>(SPECTRUM_READ_CHUNK, buffer->capacity)) {}
+
+  // As janelas do TripleBuffer, o histórico e os dois blocos de leitura
+  size_t bytes() const {
+    return TripleBuffer<WaveSnapshot>::INSTANCES *
+               BlockArena::bytesFor<double>(history) +
+           BlockArena::bytesFor<double>(SampleHistory::storageFor(history)) +
+           BlockArena::bytesFor<double>(readChunk) +
+           BlockArena::bytesFor<double>(spectrumChunk);
+  }
+};
+
+// Registra um leitor do viewer na telemetria do segmento (opcional: sem slot
+// o leitor funciona igual, só não aparece nas estatísticas)
+static ConsumerSlot* registerReader(const SharedBuffer* buffer,
+                                    const char* label) {
+  const char* error;
+  ConsumerSlot* slot =
+      registerConsumer(SHARED_MEMORY_NAME, buffer, label, error);
+  if (!slot) {
+    std::cerr << "AVISO: telemetria indisponível para " << label << " ("
+              << error << ")" << std::endl;
+  }
+  return slot;
+}
 
 // Agrupa os dados compartilhados entre a thread de leitura e a thread principal
 struct ViewerContext {
-  SharedBuffer* shmBuffer;  // Ponteiro para o buffer de memória compartilhada
-  std::deque<double> sampleHistory;  // Histórico de amostras para exibição
-  bool running;                      // Flag de controle da thread de leitura
+  const SharedBuffer* shmBuffer;  // Buffer de memória compartilhada (leitura)
+  uint32_t channel;               // Canal exibido
+  // Última janela publicada pela thread de leitura; a UI desenha direto do
+  // buffer da frente, sem cópia nem lock
+  TripleBuffer<WaveSnapshot> snapshots;
+  // Escrita pela UI, lida pela thread de leitura a cada quadro
+  SeqLock<DisplaySettings> settings;
+  size_t fftSize;  // Pontos da FFT do painel de espectro
+  // Último espectro publicado pela thread de análise
+  TripleBuffer<SpectrumSnapshot> spectra;
+  std::atomic<bool> running;  // Flag de controle das threads de leitura
 };
 
 // Área de desenho customizada que renderiza a forma de onda
@@ -40,98 +158,234 @@ class WaveformCanvas : public Gtk::DrawingArea {
     set_draw_func(sigc::mem_fun(*this, &WaveformCanvas::onDraw));
   }
 
-  // Chamado pela UI thread quando novas amostras estão disponíveis
-  void updateSamples(const std::deque<double>& samples) {
-    m_samples = samples;
+  // Chamado pela UI thread quando há uma nova janela. O canvas só guarda o
+  // endereço: a janela fica estável até o próximo TripleBuffer::update(),
+  // que também acontece na UI thread
+  void updateSamples(const WaveSnapshot& snapshot) {
+    m_snapshot = &snapshot;
     queue_draw();  // Solicita redesenho do canvas
   }
 
  private:
-  std::deque<double> m_samples;  // Cópia local das amostras para renderização
+  const WaveSnapshot* m_snapshot = nullptr;  // Janela atual (buffer da frente)
+  WaveformRenderer m_renderer;  // Grade, traço e marcas (só Cairo)
 
   // Função de desenho chamada pelo GTK quando o canvas precisa ser renderizado
   void onDraw(const Cairo::RefPtr<Cairo::Context>& cr, int width, int height) {
-    // Fundo preto
-    cr->set_source_rgb(0, 0, 0);
-    cr->paint();
+    static const WaveSnapshot empty;
+    if (m_renderer.draw(cr, width, height, m_snapshot ? *m_snapshot : empty)) {
+      return;
+    }
 
     // Se não há dados, exibe mensagem de espera
-    if (m_samples.size() < 2) {
-      cr->set_source_rgb(0, 1, 0);
-      auto layout = create_pango_layout("Aguardando sinal...");
-      layout->set_font_description(Pango::FontDescription("Monospace 12"));
-      int tw, th;
-      layout->get_pixel_size(tw, th);
-      cr->move_to(static_cast<double>(width - tw) / 2,
-                  static_cast<double>(height - th) / 2);
-      layout->show_in_cairo_context(cr);
-      return;
+    cr->set_source_rgb(0, 1, 0);
+    auto layout = create_pango_layout("Aguardando sinal...");
+    layout->set_font_description(Pango::FontDescription("Monospace 12"));
+    int tw, th;
+    layout->get_pixel_size(tw, th);
+    cr->move_to(static_cast<double>(width - tw) / 2,
+                static_cast<double>(height - th) / 2);
+    layout->show_in_cairo_context(cr);
+  }
+};
+
+// Painel do espectro: magnitude em dBFS sobre um eixo log de frequência
+class SpectrumCanvas : public Gtk::DrawingArea {
+ public:
+  SpectrumCanvas() {
+    set_content_width(WINDOW_WIDTH);
+    set_content_height(SPECTRUM_HEIGHT);
+    set_draw_func(sigc::mem_fun(*this, &SpectrumCanvas::onDraw));
+  }
+
+  // Mesmo contrato de WaveformCanvas::updateSamples
+  void updateSpectrum(const SpectrumSnapshot& snapshot) {
+    m_snapshot = &snapshot;
+    queue_draw();
+  }
+
+ private:
+  const SpectrumSnapshot* m_snapshot = nullptr;  // Buffer da frente
+
+  // Um ponto por coluna de pixel com o maior bin da faixa de frequências da
+  // coluna: em altas frequências vários bins caem na mesma coluna
+  void traceSpectrum(const Cairo::RefPtr<Cairo::Context>& cr,
+                     const std::vector<float>& bins, double binHz,
+                     double minFreq, double maxFreq, double plotWidth,
+                     double plotHeight) {
+    int columns = static_cast<int>(plotWidth);
+    double growth = pow(maxFreq / minFreq, 1.0 / columns);
+    double low = minFreq;
+    for (int x = 0; x < columns; ++x) {
+      double high = low * growth;
+      size_t first = std::min(static_cast<size_t>(low / binHz + 0.5),
+                              bins.size() - 1);
+      size_t last = std::clamp(static_cast<size_t>(high / binHz + 0.5), first,
+                               bins.size() - 1);
+      float magnitude =
+          *std::max_element(bins.begin() + first, bins.begin() + last + 1);
+      double db = std::clamp(SpectrumAnalyzer::decibels(magnitude),
+                             SPECTRUM_FLOOR_DB, 0.0);
+      double y = PLOT_MARGIN + plotHeight * db / SPECTRUM_FLOOR_DB;
+      if (x == 0) {
+        cr->move_to(PLOT_MARGIN, y);
+      } else {
+        cr->line_to(PLOT_MARGIN + x, y);
+      }
+      low = high;
     }
+  }
 
-    // Desenha grade de referência (linhas horizontais e verticais)
-    cr->set_source_rgba(0, 0.5, 0, 0.2);  // Verde transparente
-    cr->set_line_width(0.5);
+  void showText(const Cairo::RefPtr<Cairo::Context>& cr, const char* text,
+                double x, double y) {
+    auto layout = create_pango_layout(text);
+    layout->set_font_description(Pango::FontDescription("Monospace 8"));
+    cr->move_to(x, y);
+    layout->show_in_cairo_context(cr);
+  }
 
-    // Linha central (zero)
-    int centerY = height / 2;
-    cr->move_to(20, centerY);
-    cr->line_to(width - 20, centerY);
-    cr->stroke();
+  void onDraw(const Cairo::RefPtr<Cairo::Context>& cr, int width, int height) {
+    cr->set_source_rgb(0, 0, 0);
+    cr->paint();
 
-    // Linhas horizontais de referência (amplitudes ±1/3 e ±2/3)
-    for (int i = -2; i <= 2; i += 2) {
-      double y = centerY + i * (static_cast<double>(height) / 6);
-      cr->move_to(20, y);
-      cr->line_to(width - 20, y);
-      cr->stroke();
+    if (!m_snapshot || m_snapshot->sampleRate <= 0.0) {
+      cr->set_source_rgb(0, 1, 1);
+      showText(cr, "Espectro: aguardando sinal com taxa de amostragem...",
+               PLOT_MARGIN, PLOT_MARGIN);
+      return;
     }
 
-    // Linhas verticais de referência (divisões de tempo)
-    for (int i = 0; i <= 4; i++) {
-      double x = 20 + i * static_cast<double>(width - 40) / 4;
-      cr->move_to(x, 20);
-      cr->line_to(x, height - 20);
-      cr->stroke();
+    double plotWidth = width - 2 * PLOT_MARGIN;
+    double plotHeight = height - 2 * PLOT_MARGIN;
+    size_t bins = m_snapshot->magnitude.size();
+    double maxFreq = m_snapshot->sampleRate / 2;
+    double binHz = maxFreq / (bins - 1);
+    double minFreq = std::max(SPECTRUM_MIN_FREQ, binHz);
+    if (plotWidth < 1.0 || plotHeight < 1.0 || maxFreq <= minFreq) return;
+    double logSpan = log(maxFreq / minFreq);
+
+    // Grade: décadas de frequência e passos de 20 dB, num só caminho
+    cr->set_source_rgba(0, 0.5, 0.5, 0.3);
+    cr->set_line_width(0.5);
+    for (double f = pow(10.0, ceil(log10(minFreq))); f <= maxFreq; f *= 10) {
+      double x = PLOT_MARGIN + plotWidth * log(f / minFreq) / logSpan;
+      cr->move_to(x, PLOT_MARGIN);
+      cr->line_to(x, height - PLOT_MARGIN);
+    }
+    for (double db = 0.0; db >= SPECTRUM_FLOOR_DB; db -= 20.0) {
+      double y = PLOT_MARGIN + plotHeight * db / SPECTRUM_FLOOR_DB;
+      cr->move_to(PLOT_MARGIN, y);
+      cr->line_to(width - PLOT_MARGIN, y);
     }
+    cr->stroke();
 
-    // Desenha a forma de onda
-    cr->set_source_rgb(0, 1, 0);  // Verde brilhante
-    cr->set_line_width(2);
-
-    size_t n = m_samples.size();
-    double stepX =
-        (double)(width - 40) / (n - 1);  // Espaçamento horizontal entre pontos
-    double verticalScale =
-        (height - 60) / 2.0;  // Escala vertical (reserva margem de 30px)
-
-    // Conecta os pontos com linhas
-    for (size_t i = 0; i < n - 1; ++i) {
-      double x1 = 20 + i * stepX;
-      double y1 = centerY - m_samples[i] * verticalScale;
-      double x2 = 20 + (i + 1) * stepX;
-      double y2 = centerY - m_samples[i + 1] * verticalScale;
-
-      // Garante que as linhas não ultrapassem as margens
-      y1 = std::clamp(y1, 20.0, (double)(height - 20));
-      y2 = std::clamp(y2, 20.0, (double)(height - 20));
-
-      cr->move_to(x1, y1);
-      cr->line_to(x2, y2);
-      cr->stroke();
+    cr->set_source_rgb(0, 0.7, 0.7);
+    char label[96];
+    for (double f = pow(10.0, ceil(log10(minFreq))); f <= maxFreq; f *= 10) {
+      double x = PLOT_MARGIN + plotWidth * log(f / minFreq) / logSpan;
+      snprintf(label, sizeof(label), f >= 1000 ? "%.0fk" : "%.0f",
+               f >= 1000 ? f / 1000 : f);
+      showText(cr, label, x + 2, height - PLOT_MARGIN);
     }
+
+    // Pico retido (escuro) e espectro atual (claro), recortados na área
+    cr->save();
+    cr->rectangle(PLOT_MARGIN, PLOT_MARGIN, plotWidth, plotHeight);
+    cr->clip();
+    cr->set_line_width(1);
+    cr->set_source_rgb(0.6, 0.5, 0);
+    traceSpectrum(cr, m_snapshot->peak, binHz, minFreq, maxFreq, plotWidth,
+                  plotHeight);
+    cr->stroke();
+    cr->set_source_rgb(0, 1, 1);
+    traceSpectrum(cr, m_snapshot->magnitude, binHz, minFreq, maxFreq,
+                  plotWidth, plotHeight);
+    cr->stroke();
+    cr->restore();
+
+    const SpectrumAnalyzer::Measurement& m = m_snapshot->measurement;
+    snprintf(label, sizeof(label), "Pico: %.2f Hz  %.1f dBFS  THD: %.4f %%",
+             m.frequency, SpectrumAnalyzer::decibels(m.magnitude),
+             m.thd * 100.0);
+    cr->set_source_rgb(0, 1, 1);
+    showText(cr, label, PLOT_MARGIN, 2);
   }
 };
 
 // Janela principal da aplicação
 class ViewerWindow : public Gtk::Window {
  public:
-  ViewerWindow(SharedBuffer* buffer) : m_ctx{buffer, {}, true} {
-    set_title("Visualizador de Onda Senoidal");
-    set_default_size(WINDOW_WIDTH, WINDOW_HEIGHT);
-    set_child(m_canvas);
+  ViewerWindow(const SharedBuffer* buffer, uint32_t channel,
+               const DisplaySettings& settings, size_t fftSize,
+               const ViewerBuffers& sizes, BlockArena& arena)
+      : m_ctx{buffer,
+              channel,
+              TripleBuffer<WaveSnapshot>(),
+              SeqLock<DisplaySettings>(settings),
+              fftSize,
+              TripleBuffer<SpectrumSnapshot>(
+                  {std::vector<float>(fftSize / 2 + 1),
+                   std::vector<float>(fftSize / 2 + 1)}),
+              true},
+        m_layout(Gtk::Orientation::VERTICAL),
+        m_controls(Gtk::Orientation::HORIZONTAL, 6),
+        m_modeLabel("Trigger:"),
+        m_mode(std::vector<Glib::ustring>{"Desligado", "Subida", "Descida"}),
+        m_levelLabel("Nível:"),
+        m_level(Gtk::Adjustment::create(settings.level, -1.0, 1.0, 0.05, 0.25),
+                0.05, 2),
+        m_holdoffLabel("Holdoff (ms):"),
+        m_holdoff(Gtk::Adjustment::create(settings.holdoffMs, 0.0, 1000.0, 1.0,
+                                          10.0),
+                  1.0, 1),
+        m_timeLabel("Tempo/div (ms, 0 = auto):"),
+        m_timePerDiv(Gtk::Adjustment::create(settings.timePerDivMs, 0.0,
+                                             1000.0, 0.1, 1.0),
+                     0.1, 2),
+        m_sizes(sizes),
+        m_historyStorage(arena.allocate<double>(
+            SampleHistory::storageFor(sizes.history))),
+        m_readChunk(arena.allocate<double>(sizes.readChunk)),
+        m_spectrumChunk(arena.allocate<double>(sizes.spectrumChunk)) {
+    for (size_t i = 0; i < TripleBuffer<WaveSnapshot>::INSTANCES; ++i) {
+      m_ctx.snapshots.instance(i).samples =
+          arena.allocate<double>(sizes.history);
+    }
+    set_title(buffer->channels > 1
+                  ? "Visualizador de Onda Senoidal - canal " +
+                        std::to_string(channel)
+                  : std::string("Visualizador de Onda Senoidal"));
+    set_default_size(WINDOW_WIDTH, WINDOW_HEIGHT + SPECTRUM_HEIGHT);
+
+    // Onda em cima, espectro embaixo; os controles ficam numa linha no fim
+    m_mode.set_selected(static_cast<unsigned>(settings.mode));
+    m_canvas.set_vexpand(true);
+    m_spectrum.set_vexpand(true);
+    m_controls.set_margin(6);
+    m_controls.append(m_modeLabel);
+    m_controls.append(m_mode);
+    m_controls.append(m_levelLabel);
+    m_controls.append(m_level);
+    m_controls.append(m_holdoffLabel);
+    m_controls.append(m_holdoff);
+    m_controls.append(m_timeLabel);
+    m_controls.append(m_timePerDiv);
+    m_layout.append(m_canvas);
+    m_layout.append(m_spectrum);
+    m_layout.append(m_controls);
+    set_child(m_layout);
+
+    m_mode.property_selected().signal_changed().connect(
+        sigc::mem_fun(*this, &ViewerWindow::publishSettings));
+    for (Gtk::SpinButton* spin : {&m_level, &m_holdoff, &m_timePerDiv}) {
+      spin->signal_value_changed().connect(
+          sigc::mem_fun(*this, &ViewerWindow::publishSettings));
+    }
 
-    // Inicia thread que lê dados da memória compartilhada
+    // Inicia as threads que leem a memória compartilhada: cada uma é um
+    // consumidor independente do anel, com seu próprio cursor
     m_readerThread = std::thread(&ViewerWindow::readerThreadFunc, this);
+    m_spectrumThread = std::thread(&ViewerWindow::spectrumThreadFunc, this);
 
     // Configura timer para atualizar a UI periodicamente
     Glib::signal_timeout().connect(
@@ -140,62 +394,274 @@ class ViewerWindow : public Gtk::Window {
   }
 
   ~ViewerWindow() {
-    m_ctx.running = false;  // Sinaliza para thread de leitura parar
+    m_ctx.running = false;  // Sinaliza para as threads de leitura pararem
     if (m_readerThread.joinable()) m_readerThread.join();
+    if (m_spectrumThread.joinable()) m_spectrumThread.join();
   }
 
  private:
   ViewerContext m_ctx;         // Contexto compartilhado com a thread
   WaveformCanvas m_canvas;     // Área de desenho da onda
+  SpectrumCanvas m_spectrum;   // Painel do espectro
+  Gtk::Box m_layout;           // Canvas + linha de controles
+  Gtk::Box m_controls;         // Controles do trigger e da base de tempo
+  Gtk::Label m_modeLabel;
+  Gtk::DropDown m_mode;        // Ordem igual à de TriggerMode
+  Gtk::Label m_levelLabel;
+  Gtk::SpinButton m_level;
+  Gtk::Label m_holdoffLabel;
+  Gtk::SpinButton m_holdoff;
+  Gtk::Label m_timeLabel;
+  Gtk::SpinButton m_timePerDiv;
+  ViewerBuffers m_sizes;        // Tamanhos dos blocos abaixo
+  double* m_historyStorage;     // Do SampleHistory da thread de leitura
+  double* m_readChunk;          // Leituras da forma de onda
+  double* m_spectrumChunk;      // Leituras do espectro
   std::thread m_readerThread;  // Thread para leitura de dados
+  std::thread m_spectrumThread;  // Thread de análise espectral
+
+  // Chamado pelos controles: publica a configuração inteira de uma vez
+  void publishSettings() {
+    m_ctx.settings.store({static_cast<TriggerMode>(m_mode.get_selected()),
+                          m_level.get_value(), m_holdoff.get_value(),
+                          m_timePerDiv.get_value()});
+  }
+
+  // Copia `count` amostras a partir de `first` para o buffer livre e publica
+  void publishWindow(const double* first, size_t count, bool triggered,
+                     size_t triggerIndex, double triggerLevel) {
+    WaveSnapshot& snapshot = m_ctx.snapshots.back();
+    snapshot.count = count;
+    snapshot.triggered = triggered;
+    snapshot.triggerIndex = triggerIndex;
+    snapshot.triggerLevel = triggerLevel;
+    std::copy_n(first, count, snapshot.samples);
+    m_ctx.snapshots.publish();
+  }
 
   // Executa em thread separada: lê novos dados da memória compartilhada
   void readerThreadFunc() {
-    int lastWritePos = -1;
+    RingReader reader(m_ctx.shmBuffer);
+    ConsumerSlot* slot = registerReader(m_ctx.shmBuffer, "viewer");
+    reader.setTelemetry(slot);
+    SampleHistory history(m_historyStorage, m_sizes.history);
+    double* chunk = m_readChunk;
+    size_t decimationCount = 0;
+
+    // Trigger: avaliado uma vez por amostra que entra no histórico. Um
+    // disparo em T vira janela quando chegam as amostras de depois dele;
+    // a janela é [T - pre, T + post), com o disparo no centro da tela.
+    EdgeTrigger trigger;
+    uint32_t settingsVersion = 1;  // Ímpar: nunca igual a uma versão real
+    size_t configuredPoints = 0;
+    size_t configuredStride = 0;
+    bool pending = false;    // Disparou, esperando as amostras de depois
+    bool completed = false;  // Janela disparada pronta para publicar
+    uint64_t pendingAt = 0;
+    uint64_t completedAt = 0;
+    uint64_t lastPublished = 0;  // history.total() na última publicação
+    uint32_t restarts = 0;       // Reinícios do gerador já tratados
+    AllocationWarmup warmup(READER_WARMUP_LOOPS);
+
+    // Gerador reiniciado: o sinal novo não continua o antigo, então a tela
+    // recomeça vazia e o trigger é rearmado
+    auto resync = [&]() {
+      if (reader.restarts() == restarts) return;
+      restarts = reader.restarts();
+      history.clear();
+      pending = completed = false;
+      settingsVersion = 1;
+    };
 
     while (m_ctx.running) {
-      int currentWrite = m_ctx.shmBuffer->writePos;
+      // Modo visual: o gerador já entrega a forma de onda pronta para a tela.
+      // Modo físico: a janela exibida cobre TIME_DIVISIONS divisões da base
+      // de tempo escolhida ou, em automático, displayCycles ciclos do sinal
+      // real, em resolução total até o tamanho do histórico (o canvas
+      // decima por min/max na hora de desenhar); janelas maiores pulam
+      // amostras na leitura.
+      uint32_t version;
+      DisplaySettings settings = m_ctx.settings.load(version);
+      size_t stride = 1;
+      size_t displayPoints = MAX_DISPLAY_POINTS;
+      double rate = m_ctx.shmBuffer->sampleRate.load(std::memory_order_relaxed);
+      double freq = m_ctx.shmBuffer->frequency[m_ctx.channel].load(
+          std::memory_order_relaxed);
+      size_t span = 0;
+      if (rate > 0.0 && settings.timePerDivMs > 0.0) {
+        span = static_cast<size_t>(TIME_DIVISIONS * settings.timePerDivMs *
+                                   rate / 1000.0);
+      } else if (rate > 0.0 && freq > 0.0) {
+        span = static_cast<size_t>(displayCyclesFor(freq) * rate / freq);
+      }
+      if (span > 0) {
+        stride = (span + m_sizes.history - 1) / m_sizes.history;
+        stride = std::max<size_t>(1, stride);
+        displayPoints = std::clamp<size_t>(span / stride, 2, m_sizes.history);
+      }
 
-      // Verifica se há novos dados disponíveis
-      if (lastWritePos != currentWrite && m_ctx.shmBuffer->newDataAvailable) {
-        int readPos = m_ctx.shmBuffer->readPos;
+      // O trigger só vale no modo físico, onde há um relógio de amostras
+      bool triggering = settings.mode != TRIGGER_OFF && rate > 0.0;
+      size_t post = displayPoints / 2;
+      size_t pre = displayPoints - post;
+      if (version != settingsVersion || displayPoints != configuredPoints ||
+          stride != configuredStride) {
+        // Holdoff conta a partir do fim da aquisição
+        double samplesPerMs = rate / 1000.0 / stride;
+        uint64_t holdoff =
+            static_cast<uint64_t>(settings.holdoffMs * samplesPerMs);
+        trigger.configure(triggering ? settings.mode : TRIGGER_OFF,
+                          settings.level, post + holdoff);
+        settingsVersion = version;
+        configuredPoints = displayPoints;
+        configuredStride = stride;
+        pending = completed = false;
+      }
 
-        // Lê todas as amostras novas do buffer circular
-        while (readPos != currentWrite) {
-          double sample = m_ctx.shmBuffer->samples[readPos];
-          readPos = (readPos + 1) % BUFFER_SIZE;
+      // Drena tudo o que foi publicado, avaliando o trigger a cada amostra
+      size_t n;
+      bool received = false;
+      while ((n = reader.readChannel(m_ctx.channel, chunk,
+                                     m_sizes.readChunk)) > 0) {
+        resync();
+        received = true;
+        for (size_t i = 0; i < n; ++i) {
+          if (++decimationCount < stride) continue;
+          decimationCount = 0;
+
+          history.push(chunk[i]);
+          if (!triggering) continue;
+          uint64_t index = history.total() - 1;
+          if (trigger.process(chunk[i], index)) {
+            pending = true;
+            pendingAt = index;
+          }
+          if (pending && history.total() >= pendingAt + post) {
+            completed = true;
+            completedAt = pendingAt;
+            pending = false;
+          }
+        }
+      }
 
-          // Adiciona ao histórico e mantém tamanho máximo
-          m_ctx.sampleHistory.push_back(sample);
-          if (m_ctx.sampleHistory.size() > MAX_DISPLAY_POINTS) {
-            m_ctx.sampleHistory.pop_front();
+      // Publica a janela nova: uma cópia contígua para o buffer livre
+      if (received && !triggering) {
+        size_t count = std::min(displayPoints, history.size());
+        publishWindow(history.latest(count), count, false, 0, 0.0);
+      } else if (received) {
+        uint64_t total = history.total();
+        if (completed) {
+          // A janela inteira ainda precisa estar no histórico
+          completed = false;
+          uint64_t first = completedAt - pre;
+          if (completedAt >= pre && total - first <= history.size()) {
+            size_t back = static_cast<size_t>(total - first);
+            publishWindow(history.latest(back), displayPoints, true, pre,
+                          settings.level);
+            lastPublished = total;
           }
         }
+        // Modo auto: sem disparos por um tempo, a tela volta a rolar
+        uint64_t timeout = std::max<uint64_t>(
+            2 * displayPoints,
+            static_cast<uint64_t>(AUTO_TRIGGER_MS * rate / 1000.0 / stride));
+        if (total - lastPublished >= timeout) {
+          size_t count = std::min(displayPoints, history.size());
+          publishWindow(history.latest(count), count, false, 0, 0.0);
+          lastPublished = total;
+        }
+      }
 
-        // Atualiza posição de leitura e limpa flag de novo dado
-        m_ctx.shmBuffer->readPos = readPos;
-        m_ctx.shmBuffer->newDataAvailable = false;
-        lastWritePos = currentWrite;
+      resync();
+      if (reader.retired()) break;
+
+      // Dorme até o produtor publicar um novo quadro
+      reader.waitForData(READER_WAIT_TIMEOUT_MS);
+      warmup.tick();
+    }
+    allocationGuardDisarm();
+    if (reader.retired()) {
+      std::cerr << "AVISO: o gerador reiniciou com outro layout; reabra o "
+                   "visualizador" << std::endl;
+    }
+    if (slot) unregisterConsumer(slot);
+  }
+
+  /**
+   * Executa em thread separada: analisa o canal em resolução total, todas as
+   * amostras, com FFTs sobrepostas (hop = N / SPECTRUM_OVERLAP). A UI só
+   * recebe o último espectro de cada leitura, então o custo do desenho não
+   * depende da taxa de amostragem.
+   */
+  void spectrumThreadFunc() {
+    RingReader reader(m_ctx.shmBuffer);
+    ConsumerSlot* slot = registerReader(m_ctx.shmBuffer, "viewer-fft");
+    reader.setTelemetry(slot);
+    SpectrumAnalyzer analyzer(m_ctx.fftSize,
+                              m_ctx.fftSize / SPECTRUM_OVERLAP);
+    double* chunk = m_spectrumChunk;
+    double analyzedRate = 0.0;
+    uint32_t restarts = 0;
+    AllocationWarmup warmup(READER_WARMUP_LOOPS);
+
+    while (m_ctx.running && !reader.retired()) {
+      // Sem relógio de amostras (modo visual) não há espectro a mostrar;
+      // um gerador reiniciado recomeça a média de picos do zero
+      double rate = m_ctx.shmBuffer->sampleRate.load(std::memory_order_relaxed);
+      if (rate != analyzedRate || reader.restarts() != restarts) {
+        restarts = reader.restarts();
+        analyzer.reset();
+        analyzer.setPeakDecay(PEAK_DECAY_DB_PER_S * analyzer.hop() /
+                              std::max(rate, 1.0));
+        analyzedRate = rate;
+      }
+
+      size_t n;
+      size_t analyzed = 0;
+      while ((n = reader.readChannel(m_ctx.channel, chunk,
+                                     m_sizes.spectrumChunk)) > 0) {
+        if (rate > 0.0) analyzed += analyzer.push(chunk, n);
+      }
+
+      if (analyzed > 0) {
+        SpectrumSnapshot& snapshot = m_ctx.spectra.back();
+        std::copy(analyzer.magnitude().begin(), analyzer.magnitude().end(),
+                  snapshot.magnitude.begin());
+        std::copy(analyzer.peak().begin(), analyzer.peak().end(),
+                  snapshot.peak.begin());
+        snapshot.sampleRate = rate;
+        snapshot.measurement = analyzer.measure(rate);
+        m_ctx.spectra.publish();
       }
 
-      // Pequena pausa para evitar uso excessivo de CPU
-      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      reader.waitForData(READER_WAIT_TIMEOUT_MS);
+      warmup.tick();
     }
+    allocationGuardDisarm();
+    if (slot) unregisterConsumer(slot);
   }
 
-  // Chamado pelo timer da UI: atualiza o canvas com novas amostras
+  // Chamado pelo timer da UI: redesenha só quando há janela nova
   bool updateWaveform() {
-    m_canvas.updateSamples(m_ctx.sampleHistory);
+    if (m_ctx.snapshots.update()) {
+      m_canvas.updateSamples(m_ctx.snapshots.front());
+    }
+    if (m_ctx.spectra.update()) {
+      m_spectrum.updateSpectrum(m_ctx.spectra.front());
+    }
     return true;  // Mantém o timer ativo
   }
 };
 
 // Ponteiro global para a aplicação GTK
 Glib::RefPtr<Gtk::Application> g_app;
+// Falso depois do Ctrl+C: interrompe a espera pelo gerador
+std::atomic<bool> g_waiting(true);
 
 // Handler de sinal que fecha o GTK main loop
 void signalHandler(int) {
   std::cout << "\nEncerrando visualizador..." << std::endl;
+  g_waiting = false;
   if (g_app) {
     g_app->quit();
   }
@@ -204,24 +670,66 @@ void signalHandler(int) {
 int main(int argc, char* argv[]) {
   signal(SIGINT, signalHandler);
 
+  // Opções próprias do viewer; o GTK não recebe argumentos
+  uint32_t channel = 0;
+  DisplaySettings settings = {TRIGGER_OFF, 0.0, 0.0, 0.0};
+  size_t fftSize = DEFAULT_FFT_SIZE;
+  for (int i = 1; i < argc; ++i) {
+    bool valid = i + 1 < argc;
+    if (valid && strcmp(argv[i], "--channel") == 0) {
+      channel = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (valid && strcmp(argv[i], "--trigger") == 0) {
+      valid = parseTriggerMode(argv[++i], settings.mode);
+    } else if (valid && strcmp(argv[i], "--level") == 0) {
+      settings.level = std::strtod(argv[++i], nullptr);
+    } else if (valid && strcmp(argv[i], "--holdoff") == 0) {
+      settings.holdoffMs = std::max(0.0, std::strtod(argv[++i], nullptr));
+    } else if (valid && strcmp(argv[i], "--time-div") == 0) {
+      settings.timePerDivMs = std::max(0.0, std::strtod(argv[++i], nullptr));
+    } else if (valid && strcmp(argv[i], "--fft") == 0) {
+      fftSize = std::strtoul(argv[++i], nullptr, 10);
+      valid = FFT::isPowerOfTwo(fftSize) && fftSize >= MIN_FFT_SIZE &&
+              fftSize <= MAX_FFT_SIZE;
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      std::cerr << "Uso: " << argv[0]
+                << " [--channel N] [--trigger off|rising|falling]"
+                   " [--level X] [--holdoff MS] [--time-div MS]"
+                   " [--fft N (potência de 2, 256 a 65536)]"
+                << std::endl;
+      return 1;
+    }
+  }
+
   std::cout << "Visualizador de Onda Senoidal - PID: " << getpid() << std::endl;
   std::cout << "Conectando à memória compartilhada..." << std::endl;
 
-  // Abre memória compartilhada criada pelo gerador
-  int shmFd = shm_open(SHARED_MEMORY_NAME, O_RDWR, 0666);
-  if (shmFd < 0) {
-    std::cerr << "ERRO: Gerador não está em execução?" << std::endl;
+  // Mapeia a memória compartilhada criada pelo gerador. O viewer é apenas
+  // mais um consumidor do anel de difusão: o mapeamento é somente leitura e
+  // tamanho, formato e capacidade vêm do cabeçalho do segmento. Se o
+  // gerador ainda não subiu, espera por ele.
+  const char* shmError;
+  const SharedBuffer* buffer = waitForSharedBuffer(
+      SHARED_MEMORY_NAME, g_waiting,
+      [] { std::cout << "Aguardando o gerador..." << std::endl; }, shmError);
+  if (!buffer) {
+    if (g_waiting) std::cerr << "ERRO: " << shmError << std::endl;
+    return 1;
+  }
+  if (channel >= buffer->channels) {
+    std::cerr << "ERRO: canal " << channel << " inexistente (o gerador tem "
+              << buffer->channels << ")" << std::endl;
     return 1;
   }
 
-  // Mapeia memória compartilhada no espaço de endereço do processo
-  SharedBuffer* buffer =
-      (SharedBuffer*)mmap(nullptr, sizeof(SharedBuffer), PROT_READ | PROT_WRITE,
-                          MAP_SHARED, shmFd, 0);
-
-  if (buffer == MAP_FAILED) {
-    std::cerr << "ERRO: Falha ao mapear memória compartilhada" << std::endl;
-    close(shmFd);
+  // Tudo o que as threads de leitura usam já fica reservado aqui
+  ViewerBuffers sizes(buffer);
+  BlockArena arena(sizes.bytes());
+  if (!arena.isValid()) {
+    std::cerr << "ERRO: não foi possível reservar a memória de trabalho"
+              << std::endl;
     return 1;
   }
 
@@ -230,6 +738,6 @@ int main(int argc, char* argv[]) {
 
   // Inicia aplicação GTK
   g_app = Gtk::Application::create("org.sine.viewer");
-  ViewerWindow window(buffer);
-  return g_app->make_window_and_run<ViewerWindow>(argc, argv, buffer);
+  return g_app->make_window_and_run<ViewerWindow>(
+      1, argv, buffer, channel, settings, fftSize, sizes, arena);
 }
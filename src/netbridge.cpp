@@ -0,0 +1,481 @@
+// netbridge.cpp - Ponte de rede do anel compartilhado (RTP sobre UDP)
+// `send` publica o anel local num grupo multicast; `receive` reconstrói um
+// anel local a partir do fluxo, no relógio do emissor.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/Communication.hpp"
+#include "../include/JitterBuffer.hpp"
+#include "../include/NetStream.hpp"
+#include "../include/RingBuffer.hpp"
+#include "../include/SampleFormat.hpp"
+#include "../include/SharedMemory.hpp"
+#include "../include/ToolSupport.hpp"
+
+constexpr size_t BATCH_PACKETS = 64;    // Datagramas por sendmmsg/recvmmsg
+constexpr int WAIT_TIMEOUT_MS = 100;    // Espera máxima antes de reavaliar
+constexpr double STATUS_INTERVAL_S = 10.0;  // Intervalo do relatório
+constexpr int SOCKET_BUFFER_BYTES = 4 << 20;  // SO_SNDBUF / SO_RCVBUF
+
+static std::atomic<bool> keepRunning(true);
+
+void signalHandler(int) { keepRunning = false; }
+
+// Opções de linha de comando (os dois modos)
+struct BridgeOptions {
+  bool send = true;                  // Modo: send ou receive
+  std::string group = "239.255.0.1";  // Grupo multicast (ou IP unicast)
+  uint16_t port = 5004;               // Porta UDP (padrão RTP)
+  std::string interface;              // IP da interface (vazio = padrão)
+  int ttl = 1;                        // TTL multicast do emissor
+  size_t payload = NET_DEFAULT_PAYLOAD;  // Bytes de amostras por pacote
+  double jitterMs = 20.0;                // Atraso do receptor
+  uint64_t capacity = DEFAULT_BUFFER_CAPACITY;  // Anel local do receptor
+  std::string shmName = SHARED_MEMORY_NAME;     // Segmento do receptor
+};
+
+static void printUsage(const char* prog) {
+  std::cerr << "Usage: " << prog << " send|receive [options]\n"
+            << "  --group ADDR      multicast group or unicast address "
+               "(default 239.255.0.1)\n"
+            << "  --port N          UDP port (default 5004)\n"
+            << "  --interface ADDR  local interface address for multicast\n"
+            << "send:\n"
+            << "  --ttl N           multicast TTL (default 1)\n"
+            << "  --payload BYTES   sample bytes per packet (default "
+            << NET_DEFAULT_PAYLOAD << ")\n"
+            << "receive:\n"
+            << "  --jitter-ms MS    playout delay (default 20)\n"
+            << "  --capacity N      local ring capacity in frames, power of 2\n"
+            << "  --shm NAME        local segment (default "
+            << SHARED_MEMORY_NAME << "; replaces it)" << std::endl;
+}
+
+static bool parseOptions(int argc, char* argv[], BridgeOptions& options) {
+  if (argc < 2 || (strcmp(argv[1], "send") != 0 &&
+                   strcmp(argv[1], "receive") != 0)) {
+    printUsage(argv[0]);
+    return false;
+  }
+  options.send = strcmp(argv[1], "send") == 0;
+
+  double value;
+  for (int i = 2; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--group") == 0 && hasValue) {
+      options.group = argv[++i];
+    } else if (strcmp(argv[i], "--port") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 1.0 || value > 65535.0) {
+        std::cerr << "[NETBRIDGE] Invalid port" << std::endl;
+        return false;
+      }
+      options.port = static_cast<uint16_t>(value);
+    } else if (strcmp(argv[i], "--interface") == 0 && hasValue) {
+      options.interface = argv[++i];
+    } else if (strcmp(argv[i], "--ttl") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 0.0 || value > 255.0) {
+        std::cerr << "[NETBRIDGE] Invalid TTL" << std::endl;
+        return false;
+      }
+      options.ttl = static_cast<int>(value);
+    } else if (strcmp(argv[i], "--payload") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 64.0 ||
+          value > 65000.0) {
+        std::cerr << "[NETBRIDGE] Invalid payload size" << std::endl;
+        return false;
+      }
+      options.payload = static_cast<size_t>(value);
+    } else if (strcmp(argv[i], "--jitter-ms") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 0.0) {
+        std::cerr << "[NETBRIDGE] Invalid jitter delay" << std::endl;
+        return false;
+      }
+      options.jitterMs = value;
+    } else if (strcmp(argv[i], "--capacity") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 2.0 || value > 1e12) {
+        std::cerr << "[NETBRIDGE] Invalid capacity" << std::endl;
+        return false;
+      }
+      options.capacity = static_cast<uint64_t>(value);
+    } else if (strcmp(argv[i], "--shm") == 0 && hasValue) {
+      options.shmName = argv[++i];
+    } else {
+      printUsage(argv[0]);
+      return false;
+    }
+  }
+
+  in_addr address;
+  if (inet_pton(AF_INET, options.group.c_str(), &address) != 1 ||
+      (!options.interface.empty() &&
+       inet_pton(AF_INET, options.interface.c_str(), &address) != 1)) {
+    std::cerr << "[NETBRIDGE] Invalid IPv4 address" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Socket UDP configurado para o modo; -1 em erro (já reportado)
+static int openSocket(const BridgeOptions& options, sockaddr_in& group) {
+  memset(&group, 0, sizeof(group));
+  group.sin_family = AF_INET;
+  group.sin_port = htons(options.port);
+  inet_pton(AF_INET, options.group.c_str(), &group.sin_addr);
+  bool multicast = IN_MULTICAST(ntohl(group.sin_addr.s_addr));
+  in_addr interface = {htonl(INADDR_ANY)};
+  if (!options.interface.empty()) {
+    inet_pton(AF_INET, options.interface.c_str(), &interface);
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    std::cerr << "[NETBRIDGE] socket: " << strerror(errno) << std::endl;
+    return -1;
+  }
+  int bufferBytes = SOCKET_BUFFER_BYTES;
+  bool ok = true;
+  if (options.send) {
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufferBytes, sizeof(bufferBytes));
+    if (multicast) {
+      unsigned char ttl = static_cast<unsigned char>(options.ttl);
+      ok = setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl,
+                      sizeof(ttl)) == 0;
+      if (ok && !options.interface.empty()) {
+        ok = setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &interface,
+                        sizeof(interface)) == 0;
+      }
+    }
+  } else {
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+    timeval timeout = {0, WAIT_TIMEOUT_MS * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // Multicast: recebe no grupo; unicast: em qualquer endereço local
+    sockaddr_in local = group;
+    if (!multicast) local.sin_addr.s_addr = htonl(INADDR_ANY);
+    ok = bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) == 0;
+    if (ok && multicast) {
+      ip_mreq membership = {group.sin_addr, interface};
+      ok = setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership,
+                      sizeof(membership)) == 0;
+    }
+  }
+  if (!ok) {
+    std::cerr << "[NETBRIDGE] Socket setup failed: " << strerror(errno)
+              << std::endl;
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * Emissor: consumidor independente do anel local. Cada leitura vira uma
+ * rajada de pacotes de quadros inteiros enviada com um único sendmmsg; a
+ * sequência RTP numera os pacotes e o timestamp é o relógio de amostras.
+ */
+static int runSender(const BridgeOptions& options) {
+  const char* error;
+  const SharedBuffer* buffer = waitForSharedBuffer(
+      SHARED_MEMORY_NAME, keepRunning,
+      [] {
+        std::cout << "[NETBRIDGE] Waiting for the generator..." << std::endl;
+      },
+      error);
+  if (!buffer) {
+    if (keepRunning) std::cerr << "[NETBRIDGE] " << error << std::endl;
+    return 1;
+  }
+  double sampleRate = buffer->sampleRate.load(std::memory_order_relaxed);
+  if (sampleRate <= 0.0) {
+    std::cerr << "[NETBRIDGE] Generator is in visual mode; start it with "
+                 "--sample-rate" << std::endl;
+    releaseSharedBuffer(buffer);
+    return 1;
+  }
+
+  sockaddr_in group;
+  int fd = openSocket(options, group);
+  if (fd < 0) {
+    releaseSharedBuffer(buffer);
+    return 1;
+  }
+
+  uint32_t channels = buffer->channels;
+  SampleFormat format = buffer->sampleFormat;
+  size_t frameBytes = channels * sampleFormatSize(format);
+  size_t packetFrames = std::max<size_t>(1, options.payload / frameBytes);
+  size_t packetBytes = NET_HEADER_BYTES + packetFrames * frameBytes;
+
+  // Uma rajada inteira preparada de antemão: nada é alocado no laço
+  std::vector<unsigned char> packets(BATCH_PACKETS * packetBytes);
+  std::vector<double> samples(BATCH_PACKETS * packetFrames * channels);
+  std::vector<iovec> iov(BATCH_PACKETS);
+  std::vector<mmsghdr> messages(BATCH_PACKETS);
+  for (size_t p = 0; p < BATCH_PACKETS; ++p) {
+    iov[p].iov_base = packets.data() + p * packetBytes;
+    memset(&messages[p], 0, sizeof(mmsghdr));
+    messages[p].msg_hdr.msg_name = &group;
+    messages[p].msg_hdr.msg_namelen = sizeof(group);
+    messages[p].msg_hdr.msg_iov = &iov[p];
+    messages[p].msg_hdr.msg_iovlen = 1;
+  }
+
+  RtpHeader rtp = {true, 0, 0, std::random_device()()};
+  StreamHeader stream = {NET_MAGIC, NET_VERSION,
+                         static_cast<uint16_t>(channels),
+                         static_cast<uint32_t>(format), 0, sampleRate, 0};
+  Dither noDither(false);  // Mesmo formato do anel: recodificação exata
+  RingReader reader(buffer);
+  ConsumerSlot* slot = registerConsumer(SHARED_MEMORY_NAME, buffer,
+                                        "netbridge", error);
+  if (!slot) std::cerr << "[NETBRIDGE] Warning: " << error << std::endl;
+  reader.setTelemetry(slot);
+  uint64_t sentPackets = 0, failedPackets = 0;
+  uint32_t restarts = 0;  // Reinícios do gerador já registrados
+  uint64_t nextStatus = static_cast<uint64_t>(STATUS_INTERVAL_S * sampleRate);
+
+  std::cout << "\n[NETBRIDGE] Sending " << channels << " channel(s) at "
+            << sampleRate << " Hz, " << sampleFormatName(format) << " to "
+            << options.group << ":" << options.port << " (" << packetFrames
+            << " frames per packet, SSRC " << rtp.ssrc << ")\n"
+            << std::endl;
+
+  while (keepRunning) {
+    size_t n = reader.read(samples.data(), samples.size() / channels);
+    if (reader.restarts() != restarts) {
+      // O relógio de amostras continua: o receptor vê só um intervalo
+      restarts = reader.restarts();
+      std::cout << "[NETBRIDGE] Generator restarted (epoch "
+                << buffer->epoch.load() << ")" << std::endl;
+    }
+    if (n == 0) {
+      if (reader.retired()) {
+        std::cerr << "[NETBRIDGE] Generator restarted with another layout, "
+                     "stopping" << std::endl;
+        break;
+      }
+      reader.waitForData(WAIT_TIMEOUT_MS);
+      continue;
+    }
+
+    // Índice absoluto do primeiro quadro lido (overruns já descontados)
+    uint64_t first = reader.tail() - n;
+    size_t count = 0;
+    for (size_t done = 0; done < n; done += packetFrames, ++count) {
+      size_t frames = std::min(packetFrames, n - done);
+      unsigned char* packet = packets.data() + count * packetBytes;
+      stream.frames = static_cast<uint32_t>(frames);
+      stream.firstFrame = first + done;
+      rtp.timestamp = static_cast<uint32_t>(stream.firstFrame);
+      buildNetHeader(packet, rtp, stream);
+      encodeSamples(format, samples.data() + done * channels,
+                    packet + NET_HEADER_BYTES, frames * channels, noDither);
+      iov[count].iov_len = NET_HEADER_BYTES + frames * frameBytes;
+      rtp.marker = false;
+      ++rtp.sequence;
+    }
+
+    for (size_t sent = 0; sent < count;) {
+      int result = sendmmsg(fd, messages.data() + sent,
+                            static_cast<unsigned>(count - sent), 0);
+      if (result < 0 && errno == EINTR) continue;
+      if (result <= 0) {
+        failedPackets += count - sent;  // Rede recusou: pula a rajada
+        break;
+      }
+      sent += static_cast<size_t>(result);
+      sentPackets += static_cast<size_t>(result);
+    }
+
+    if (reader.tail() >= nextStatus) {
+      nextStatus += static_cast<uint64_t>(STATUS_INTERVAL_S * sampleRate);
+      std::cout << "[NETBRIDGE] " << sentPackets << " packets sent, "
+                << failedPackets << " failed, " << reader.lost()
+                << " frames lost (ring overrun)" << std::endl;
+    }
+  }
+
+  close(fd);
+  if (slot) unregisterConsumer(slot);
+  releaseSharedBuffer(buffer);
+  std::cout << "\n[NETBRIDGE] Stopped: " << sentPackets << " packets sent"
+            << std::endl;
+  return 0;
+}
+
+/**
+ * Receptor: recvmmsg em rajadas, JitterBuffer indexado pelos quadros do
+ * emissor e publicação no anel local do que já cumpriu o atraso. O anel é
+ * criado com o layout do primeiro pacote válido; consumidores locais
+ * (viewer, recorder) não sabem que o sinal veio da rede.
+ */
+static int runReceiver(const BridgeOptions& options) {
+  sockaddr_in group;
+  int fd = openSocket(options, group);
+  if (fd < 0) return 1;
+
+  // Maior datagrama UDP: qualquer --payload do emissor cabe
+  const size_t MAX_DATAGRAM = 65536;
+  std::vector<unsigned char> packets(BATCH_PACKETS * MAX_DATAGRAM);
+  std::vector<iovec> iov(BATCH_PACKETS);
+  std::vector<mmsghdr> messages(BATCH_PACKETS);
+  for (size_t p = 0; p < BATCH_PACKETS; ++p) {
+    iov[p] = {packets.data() + p * MAX_DATAGRAM, MAX_DATAGRAM};
+    memset(&messages[p], 0, sizeof(mmsghdr));
+    messages[p].msg_hdr.msg_iov = &iov[p];
+    messages[p].msg_hdr.msg_iovlen = 1;
+  }
+
+  std::cout << "\n[NETBRIDGE] Receiving on " << options.group << ":"
+            << options.port << " into " << options.shmName << " ("
+            << options.jitterMs << " ms jitter buffer)\n"
+            << std::endl;
+
+  SharedBuffer* buffer = nullptr;
+  std::unique_ptr<RingWriter> writer;
+  std::unique_ptr<JitterBuffer> jitter;
+  StreamHeader layout = {};  // Layout do anel local
+  uint32_t ssrc = 0;
+  uint16_t expectedSequence = 0;
+  uint64_t received = 0, lostPackets = 0, rejected = 0;
+  std::vector<double> decoded, planar;
+  int idleWaits = 0;  // Esperas seguidas sem pacotes
+  double nextStatus = STATUS_INTERVAL_S;
+
+  while (keepRunning) {
+    int count = recvmmsg(fd, messages.data(), BATCH_PACKETS, MSG_WAITFORONE,
+                         nullptr);
+    if (count <= 0) {
+      // Fluxo parado: entrega a cauda retida pelo atraso em vez de segurá-la
+      if (jitter && ++idleWaits == 2 && jitter->pending() > 0) {
+        size_t frames = jitter->pending();
+        for (size_t done = 0; done < frames;) {
+          size_t n = std::min(frames - done, planar.size() / layout.channels);
+          jitter->pop(planar.data(), n);
+          writer->write(planar.data(), n);
+          done += n;
+        }
+      }
+      continue;
+    }
+    idleWaits = 0;
+
+    for (int p = 0; p < count; ++p) {
+      const unsigned char* data = packets.data() + p * MAX_DATAGRAM;
+      RtpHeader rtp;
+      StreamHeader stream;
+      if (!parseNetPacket(data, messages[p].msg_len, rtp, stream)) {
+        ++rejected;
+        continue;
+      }
+
+      if (!buffer) {
+        // Primeiro pacote: cria o anel local com o layout do fluxo
+        RingLayout ring;
+        ring.capacity = options.capacity;
+        ring.format = static_cast<SampleFormat>(stream.format);
+        ring.channels = stream.channels;
+        ring.sampleRate = stream.sampleRate;
+        const char* error;
+        buffer = createSharedBuffer(options.shmName.c_str(), ring, false,
+                                    error);
+        if (!buffer) {
+          std::cerr << "[NETBRIDGE] " << error << std::endl;
+          close(fd);
+          return 1;
+        }
+        writer = std::make_unique<RingWriter>(buffer, false);
+        uint64_t delay = static_cast<uint64_t>(options.jitterMs / 1000.0 *
+                                               stream.sampleRate);
+        size_t capacity = 65536;
+        while (capacity < 4 * delay) capacity <<= 1;
+        jitter = std::make_unique<JitterBuffer>(stream.channels, capacity,
+                                                delay);
+        decoded.resize(MAX_DATAGRAM * stream.channels);
+        planar.resize(capacity * stream.channels);
+        layout = stream;
+        std::cout << "[NETBRIDGE] Stream: " << stream.channels
+                  << " channel(s) at " << stream.sampleRate << " Hz, "
+                  << sampleFormatName(ring.format) << std::endl;
+      } else if (stream.channels != layout.channels ||
+                 stream.format != layout.format ||
+                 stream.sampleRate != layout.sampleRate) {
+        ++rejected;  // Layout diferente do anel local: reinicie o receptor
+        continue;
+      }
+
+      // Emissor novo (ou reiniciado): recomeça a reordenação
+      if (received == 0 || rtp.ssrc != ssrc) {
+        if (received > 0) {
+          std::cout << "[NETBRIDGE] New stream (SSRC " << rtp.ssrc << ")"
+                    << std::endl;
+        }
+        ssrc = rtp.ssrc;
+        jitter->reset();
+        expectedSequence = rtp.sequence;
+      }
+      int16_t gap = static_cast<int16_t>(rtp.sequence - expectedSequence);
+      if (gap > 0) lostPackets += static_cast<uint16_t>(gap);
+      if (gap >= 0) expectedSequence = static_cast<uint16_t>(rtp.sequence + 1);
+      ++received;
+
+      decodeSamples(static_cast<SampleFormat>(stream.format),
+                    data + NET_HEADER_BYTES, decoded.data(),
+                    stream.frames * stream.channels);
+      jitter->insert(stream.firstFrame, decoded.data(), stream.frames);
+    }
+
+    // Publica o que já cumpriu o atraso, em blocos
+    while (jitter && jitter->ready() > 0) {
+      size_t n = std::min(jitter->ready(), planar.size() / layout.channels);
+      jitter->pop(planar.data(), n);
+      writer->write(planar.data(), n);
+    }
+
+    if (buffer && writer->head() / layout.sampleRate >= nextStatus) {
+      nextStatus += STATUS_INTERVAL_S;
+      std::cout << "[NETBRIDGE] " << received << " packets received, "
+                << lostPackets << " lost, " << jitter->late()
+                << " late frames, " << jitter->missing()
+                << " frames concealed" << std::endl;
+    }
+  }
+
+  close(fd);
+  if (buffer) releaseProducerBuffer(buffer);
+  std::cout << "\n[NETBRIDGE] Stopped: " << received << " packets received, "
+            << lostPackets << " lost, " << rejected << " rejected"
+            << std::endl;
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  BridgeOptions options;
+  if (!parseOptions(argc, argv, options)) return 1;
+
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+
+  std::cout << "\n[NETBRIDGE] Started (PID: " << getpid() << ")" << std::endl;
+  return options.send ? runSender(options) : runReceiver(options);
+}
@@ -0,0 +1,485 @@
+// recorder.cpp - Gravador contínuo do anel compartilhado em disco
+// Consumidor independente de /sine_buffer: grava todos os canais em
+// arquivos WAV (ou crus) em rotação, com escritas O_DIRECT alinhadas.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/Communication.hpp"
+#include "../include/RingBuffer.hpp"
+#include "../include/SampleFormat.hpp"
+#include "../include/SharedMemory.hpp"
+#include "../include/SpscQueue.hpp"
+#include "../include/ToolSupport.hpp"
+#include "../include/WavFormat.hpp"
+
+constexpr size_t IO_ALIGNMENT = 4096;  // Alinhamento exigido por O_DIRECT
+constexpr size_t BLOCK_TARGET_BYTES = 4 << 20;  // Tamanho alvo de um bloco
+constexpr size_t MAX_BLOCKS = 64;      // Blocos entre leitura e escrita
+constexpr size_t READ_FRAMES = 4096;   // Quadros por leitura do anel
+constexpr int WAIT_TIMEOUT_MS = 100;   // Espera máxima antes de reavaliar
+constexpr double STATUS_INTERVAL_S = 10.0;  // Intervalo do relatório
+
+static std::atomic<bool> keepRunning(true);
+
+void signalHandler(int) { keepRunning = false; }
+
+// Opções de linha de comando
+struct RecorderOptions {
+  std::string prefix = "capture";  // Arquivos PREFIX-0001.wav, ...
+  bool wav = true;                 // Cabeçalho WAV (false = amostras cruas)
+  bool formatGiven = false;        // --format (senão o formato do anel)
+  SampleFormat format = FORMAT_F32;
+  double rotateMiB = 1024.0;  // Tamanho de cada arquivo (0 = sem rotação)
+  size_t blocks = 16;         // Blocos de ~4 MiB entre leitura e escrita
+  double duration = 0.0;      // Segundos de áudio (0 = até Ctrl+C)
+  bool direct = true;         // O_DIRECT (false = escrita com cache)
+};
+
+// Bloco de quadros inteiros; bytes é sempre múltiplo de IO_ALIGNMENT,
+// exceto no último bloco da gravação
+struct Block {
+  unsigned char* data;
+  size_t bytes;  // Bytes válidos
+};
+
+static void printUsage(const char* prog) {
+  std::cerr << "Usage: " << prog << " [options]\n"
+            << "  --output PREFIX   file name prefix (default capture)\n"
+            << "  --raw             raw samples instead of WAV files\n"
+            << "  --format FMT      f64|f32|s16|s24 file sample format "
+               "(default: ring format)\n"
+            << "  --rotate-mb N     start a new file every N MiB "
+               "(default 1024, 0 = never;\n"
+            << "                    WAV files always stop below 4 GiB)\n"
+            << "  --buffers N       ~4 MiB write buffers, 2 to " << MAX_BLOCKS
+            << " (default 16)\n"
+            << "  --duration S      stop after S seconds of signal\n"
+            << "  --no-direct       page-cache writes instead of O_DIRECT"
+            << std::endl;
+}
+
+static bool parseOptions(int argc, char* argv[], RecorderOptions& options) {
+  double value;
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--output") == 0 && hasValue) {
+      options.prefix = argv[++i];
+    } else if (strcmp(argv[i], "--raw") == 0) {
+      options.wav = false;
+    } else if (strcmp(argv[i], "--format") == 0 && hasValue) {
+      if (!parseSampleFormat(argv[++i], options.format)) {
+        std::cerr << "[RECORDER] Unknown sample format" << std::endl;
+        return false;
+      }
+      options.formatGiven = true;
+    } else if (strcmp(argv[i], "--rotate-mb") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 0.0) {
+        std::cerr << "[RECORDER] Invalid rotation size" << std::endl;
+        return false;
+      }
+      options.rotateMiB = value;
+    } else if (strcmp(argv[i], "--buffers") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value < 2.0 ||
+          value > MAX_BLOCKS || value != std::floor(value)) {
+        std::cerr << "[RECORDER] Invalid buffer count" << std::endl;
+        return false;
+      }
+      options.blocks = static_cast<size_t>(value);
+    } else if (strcmp(argv[i], "--duration") == 0 && hasValue) {
+      if (!parseNumber(argv[++i], value) || value <= 0.0) {
+        std::cerr << "[RECORDER] Invalid duration" << std::endl;
+        return false;
+      }
+      options.duration = value;
+    } else if (strcmp(argv[i], "--no-direct") == 0) {
+      options.direct = false;
+    } else {
+      printUsage(argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @class RotatingFile
+ * @brief Sequência de arquivos PREFIX-NNNN escrita em blocos alinhados.
+ *
+ * Cada bloco vai inteiro para um arquivo (a rotação acontece entre blocos,
+ * que contêm quadros inteiros). Com O_DIRECT as escritas saem direto do
+ * buffer do bloco para o dispositivo, sem poluir o cache de páginas; o
+ * último bloco, parcial, é escrito com preenchimento e o arquivo truncado
+ * no tamanho real. O cabeçalho WAV é reescrito no lugar ao fechar.
+ */
+class RotatingFile {
+ public:
+  RotatingFile(const RecorderOptions& options, SampleFormat format,
+               uint32_t channels, double sampleRate, uint64_t fileLimit)
+      : m_options(options),
+        m_format(format),
+        m_channels(channels),
+        m_sampleRate(sampleRate),
+        m_fileLimit(fileLimit),
+        m_direct(options.direct),
+        m_fd(-1),
+        m_index(0),
+        m_dataBytes(0),
+        m_padded(false),
+        m_header(nullptr) {}
+
+  ~RotatingFile() { free(m_header); }
+
+  RotatingFile(const RotatingFile&) = delete;
+  RotatingFile& operator=(const RotatingFile&) = delete;
+
+  // Grava um bloco, abrindo o próximo arquivo se preciso; false em erro
+  bool write(Block& block, const char*& error) {
+    if (m_fd >= 0 && m_dataBytes + block.bytes > m_fileLimit &&
+        !close(error)) {
+      return false;
+    }
+    if (m_fd < 0 && !open(error)) return false;
+
+    // O_DIRECT exige tamanho alinhado: completa o último bloco com zeros
+    size_t padded = (block.bytes + IO_ALIGNMENT - 1) & ~(IO_ALIGNMENT - 1);
+    memset(block.data + block.bytes, 0, padded - block.bytes);
+    off_t offset = static_cast<off_t>(dataOffset() + m_dataBytes);
+    if (!writeAll(block.data, padded, offset)) {
+      error = "Write failed";
+      return false;
+    }
+    m_dataBytes += block.bytes;
+    m_padded = padded != block.bytes;
+    return true;
+  }
+
+  // Fecha o arquivo atual: tamanho real e cabeçalho definitivo
+  bool close(const char*& error) {
+    if (m_fd < 0) return true;
+    bool ok = true;
+    if (m_padded &&
+        ftruncate(m_fd, static_cast<off_t>(dataOffset() + m_dataBytes)) < 0) {
+      ok = false;
+    }
+    if (m_options.wav) {
+      buildWavHeader(m_header, m_format, m_channels, m_sampleRate,
+                     m_dataBytes);
+      ok = writeAll(m_header, WAV_HEADER_BYTES, 0) && ok;
+    }
+    ok = ::close(m_fd) == 0 && ok;
+    m_fd = -1;
+    if (!ok) error = "Failed to finalize capture file";
+    return ok;
+  }
+
+  bool direct() const { return m_direct; }
+  unsigned files() const { return m_index; }
+
+ private:
+  const RecorderOptions& m_options;
+  SampleFormat m_format;
+  uint32_t m_channels;
+  double m_sampleRate;
+  uint64_t m_fileLimit;   // Bytes de amostras por arquivo
+  bool m_direct;          // O_DIRECT em uso (desligado se o FS recusar)
+  int m_fd;
+  unsigned m_index;       // Arquivos já abertos
+  uint64_t m_dataBytes;   // Bytes de amostras no arquivo atual
+  bool m_padded;          // Última escrita passou do tamanho real
+  unsigned char* m_header;  // Cabeçalho alinhado (só WAV)
+
+  size_t dataOffset() const { return m_options.wav ? WAV_HEADER_BYTES : 0; }
+
+  bool open(const char*& error) {
+    char name[32];
+    snprintf(name, sizeof(name), "-%04u.%s", m_index + 1,
+             m_options.wav ? "wav" : "raw");
+    std::string path = m_options.prefix + name;
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    m_fd = ::open(path.c_str(), flags | (m_direct ? O_DIRECT : 0), 0644);
+    if (m_fd < 0 && m_direct && errno == EINVAL) {
+      // Sistemas de arquivos como tmpfs não aceitam O_DIRECT
+      std::cerr << "[RECORDER] O_DIRECT not supported here, using buffered "
+                   "writes" << std::endl;
+      m_direct = false;
+      m_fd = ::open(path.c_str(), flags, 0644);
+    }
+    if (m_fd < 0) {
+      error = "Failed to create capture file";
+      return false;
+    }
+    ++m_index;
+    m_dataBytes = 0;
+    m_padded = false;
+
+    // Cabeçalho provisório (tamanho 0), corrigido em close()
+    if (m_options.wav) {
+      if (!m_header &&
+          posix_memalign(reinterpret_cast<void**>(&m_header), IO_ALIGNMENT,
+                         WAV_HEADER_BYTES) != 0) {
+        m_header = nullptr;
+        error = "Out of memory";
+        return false;
+      }
+      buildWavHeader(m_header, m_format, m_channels, m_sampleRate, 0);
+      if (!writeAll(m_header, WAV_HEADER_BYTES, 0)) {
+        error = "Write failed";
+        return false;
+      }
+    }
+    std::cout << "[RECORDER] Writing " << path << std::endl;
+    return true;
+  }
+
+  bool writeAll(const unsigned char* data, size_t bytes, off_t offset) {
+    while (bytes > 0) {
+      ssize_t written = pwrite(m_fd, data, bytes, offset);
+      if (written < 0 && errno == EINTR) continue;
+      if (written <= 0) return false;
+      data += written;
+      bytes -= static_cast<size_t>(written);
+      offset += written;
+    }
+    return true;
+  }
+};
+
+int main(int argc, char* argv[]) {
+  RecorderOptions options;
+  if (!parseOptions(argc, argv, options)) return 1;
+
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+
+  // Pode subir antes do gerador: espera o segmento aparecer
+  const char* error;
+  const SharedBuffer* buffer = waitForSharedBuffer(
+      SHARED_MEMORY_NAME, keepRunning,
+      [] {
+        std::cout << "[RECORDER] Waiting for the generator..." << std::endl;
+      },
+      error);
+  if (!buffer) {
+    if (keepRunning) std::cerr << "[RECORDER] " << error << std::endl;
+    return 1;
+  }
+  double sampleRate = buffer->sampleRate.load(std::memory_order_relaxed);
+  if (sampleRate <= 0.0) {
+    std::cerr << "[RECORDER] Generator is in visual mode; start it with "
+                 "--sample-rate" << std::endl;
+    releaseSharedBuffer(buffer);
+    return 1;
+  }
+
+  uint32_t channels = buffer->channels;
+  SampleFormat format = options.formatGiven ? options.format
+                                            : buffer->sampleFormat;
+  size_t frameBytes = channels * sampleFormatSize(format);
+
+  // Blocos de quadros inteiros e múltiplos de IO_ALIGNMENT bytes: um
+  // múltiplo de IO_ALIGNMENT quadros satisfaz as duas condições
+  size_t blockFrames =
+      IO_ALIGNMENT *
+      std::max<size_t>(1, BLOCK_TARGET_BYTES / (frameBytes * IO_ALIGNMENT));
+  size_t blockBytes = blockFrames * frameBytes;
+
+  // Limite por arquivo em blocos inteiros (pelo menos um)
+  uint64_t fileLimit = options.rotateMiB > 0.0
+                           ? static_cast<uint64_t>(options.rotateMiB * 1048576)
+                           : UINT64_MAX;
+  if (options.wav) fileLimit = std::min(fileLimit, WAV_MAX_DATA_BYTES);
+  fileLimit = std::max<uint64_t>(fileLimit / blockBytes, 1) * blockBytes;
+
+  // Todos os blocos são alocados (e tocados) antes de começar a ler
+  std::vector<Block> blocks(options.blocks);
+  for (Block& block : blocks) {
+    void* memory;
+    if (posix_memalign(&memory, IO_ALIGNMENT, blockBytes) != 0) {
+      std::cerr << "[RECORDER] Out of memory" << std::endl;
+      return 1;
+    }
+    block.data = static_cast<unsigned char*>(memory);
+    block.bytes = 0;
+    memset(block.data, 0, blockBytes);
+  }
+
+  // Blocos livres (escritor -> leitor) e cheios (leitor -> escritor)
+  SpscQueue<Block*, MAX_BLOCKS> freeBlocks;
+  SpscQueue<Block*, MAX_BLOCKS> fullBlocks;
+  for (Block& block : blocks) freeBlocks.push(&block);
+  int writerWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  std::atomic<bool> readerDone(false);
+  std::atomic<bool> writerFailed(false);
+
+  std::cout << "\n[RECORDER] Started (PID: " << getpid() << "): " << channels
+            << " channel(s) at " << sampleRate << " Hz, "
+            << sampleFormatName(format) << ", " << options.blocks << " x "
+            << blockBytes / 1024 << " KiB buffers\n" << std::endl;
+
+  // Thread de escrita: a única que espera pelo disco. Nunca bloqueia a
+  // leitura; se ficar para trás, o leitor descarta blocos (e conta)
+  RotatingFile file(options, format, channels, sampleRate, fileLimit);
+  std::thread writer([&] {
+    const char* writeError = nullptr;
+    while (true) {
+      Block* block;
+      if (fullBlocks.pop(block)) {
+        if (!writerFailed && !file.write(*block, writeError)) {
+          std::cerr << "[RECORDER] " << writeError << ": " << strerror(errno)
+                    << std::endl;
+          writerFailed = true;
+          keepRunning = false;
+        }
+        freeBlocks.push(block);
+        continue;
+      }
+      if (readerDone) break;
+      pollfd pfd = {writerWakeFd, POLLIN, 0};
+      poll(&pfd, 1, WAIT_TIMEOUT_MS);
+      drain(writerWakeFd);
+    }
+    if (!file.close(writeError)) {
+      std::cerr << "[RECORDER] " << writeError << std::endl;
+      writerFailed = true;
+    }
+  });
+
+  // Leitura: consumidor independente do anel, a partir de agora
+  RingReader reader(buffer);
+  ConsumerSlot* slot = registerConsumer(SHARED_MEMORY_NAME, buffer,
+                                        "recorder", error);
+  if (!slot) std::cerr << "[RECORDER] Warning: " << error << std::endl;
+  reader.setTelemetry(slot);
+  std::vector<double> samples(READ_FRAMES * channels);
+  Dither dither(buffer->sampleFormat != format &&
+                (buffer->sampleFormat == FORMAT_F64 ||
+                 buffer->sampleFormat == FORMAT_F32));
+  uint64_t maxFrames = UINT64_MAX;
+  if (options.duration > 0.0) {
+    maxFrames = static_cast<uint64_t>(options.duration * sampleRate);
+  }
+  uint64_t recorded = 0;  // Quadros do sinal entregues ao escritor
+  uint64_t dropped = 0;   // Quadros descartados por falta de bloco livre
+  uint64_t silenced = 0;  // Quadros de lacuna gravados como silêncio
+  uint64_t gap = 0;       // Lacuna ainda por gravar (espera bloco livre)
+  uint64_t lostSeen = 0;  // reader.lost() já convertido em lacuna
+  uint64_t nextStatus = static_cast<uint64_t>(STATUS_INTERVAL_S * sampleRate);
+  Block* current = nullptr;
+  size_t currentFrames = 0;
+  uint32_t restarts = 0;  // Reinícios do gerador já registrados
+
+  auto submit = [&] {
+    current->bytes = currentFrames * frameBytes;
+    fullBlocks.push(current);
+    notify(writerWakeFd);
+    current = nullptr;
+    currentFrames = 0;
+  };
+
+  // Copia `count` quadros de `in` (nullptr = silêncio) para os blocos;
+  // retorna quantos couberam antes de faltar bloco livre
+  auto append = [&](const double* in, uint64_t count) {
+    uint64_t done = 0;
+    while (done < count) {
+      if (!current && freeBlocks.pop(current)) currentFrames = 0;
+      if (!current) break;
+      size_t take = static_cast<size_t>(
+          std::min<uint64_t>(count - done, blockFrames - currentFrames));
+      unsigned char* out = current->data + currentFrames * frameBytes;
+      if (in) {
+        encodeSamples(format, in + done * channels, out, take * channels,
+                      dither);
+      } else {
+        memset(out, 0, take * frameBytes);  // Zero em todos os formatos
+      }
+      currentFrames += take;
+      done += take;
+      if (currentFrames == blockFrames) submit();
+    }
+    return done;
+  };
+
+  // Posição no relógio do arquivo: sinal, silêncio e lacuna pendente. Cada
+  // quadro perdido (overrun do anel ou disco atrasado) vira silêncio antes
+  // dos seguintes, então o arquivo não encurta nas falhas
+  while (keepRunning && recorded + silenced + gap < maxFrames) {
+    uint64_t wanted = std::min<uint64_t>(
+        READ_FRAMES, maxFrames - recorded - silenced - gap);
+    size_t n = reader.read(samples.data(), static_cast<size_t>(wanted));
+    if (reader.restarts() != restarts) {
+      restarts = reader.restarts();
+      std::cout << "[RECORDER] Generator restarted (epoch "
+                << buffer->epoch.load() << "), recording continues"
+                << std::endl;
+    }
+    if (n == 0) {
+      // Outro layout: os quadros novos vão para outro segmento
+      if (reader.retired()) {
+        std::cerr << "[RECORDER] Generator restarted with another layout, "
+                     "stopping" << std::endl;
+        break;
+      }
+      reader.waitForData(WAIT_TIMEOUT_MS);
+      continue;
+    }
+
+    // Quadros que o overrun levou vêm antes dos lidos agora (sem passar
+    // do fim pedido por --duration)
+    uint64_t overrun = reader.lost() - lostSeen;
+    lostSeen = reader.lost();
+    gap += std::min(overrun, maxFrames - recorded - silenced - gap);
+    n = static_cast<size_t>(
+        std::min<uint64_t>(n, maxFrames - recorded - silenced - gap));
+
+    uint64_t filled = append(nullptr, gap);
+    silenced += filled;
+    gap -= filled;
+    uint64_t taken = gap == 0 ? append(samples.data(), n) : 0;
+    recorded += taken;
+    dropped += n - taken;  // Disco atrasado: perde este trecho, não o anel
+    gap += n - taken;
+
+    if (recorded + silenced + gap >= nextStatus) {
+      nextStatus += static_cast<uint64_t>(STATUS_INTERVAL_S * sampleRate);
+      std::cout << "[RECORDER] " << recorded / sampleRate << " s recorded, "
+                << reader.lost() << " frames lost (ring overrun), " << dropped
+                << " dropped (disk), " << silenced << " written as silence"
+                << std::endl;
+    }
+  }
+  if (current && currentFrames > 0) submit();
+
+  readerDone = true;
+  notify(writerWakeFd);
+  writer.join();
+
+  close(writerWakeFd);
+  for (Block& block : blocks) free(block.data);
+  if (slot) unregisterConsumer(slot);
+  releaseSharedBuffer(buffer);
+
+  std::cout << "\n[RECORDER] Stopped: " << recorded << " frames ("
+            << recorded / sampleRate << " s) in " << file.files()
+            << " file(s)" << (file.direct() ? " with O_DIRECT" : "") << ", "
+            << reader.lost() << " lost, " << dropped << " dropped, "
+            << silenced << " written as silence" << std::endl;
+  return writerFailed ? 1 : 0;
+}